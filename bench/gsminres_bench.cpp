@@ -0,0 +1,304 @@
+/**
+ * \file gsminres_bench.cpp
+ * \brief Benchmark suite of GSMINRES++ on synthetic generalized shifted problems.
+ * \author Shuntaro Hidaka
+ *
+ * \details Solves \f$ (A + \sigma^{(m)} B)x^{(m)} = b \f$ (b = ones, shifts on the circle of radius 0.1
+ *          as in the samples) with `gsminres::Solver` for every combination of
+ *          problem, size, storage format, number of shifts, number of threads and reorthogonalization
+ *          setting, and prints one CSV line per run:
+ *          - `csr`: `util::spmv()` for A and `util::cg()` for the inner solves with B.
+ *          - `packed`: `blas::zhpmv()` for A and the Cholesky factor of B (`lapack::zpptrf()`, setup).
+ *
+ *          The columns are the version, problem, format, N, nnz of A, M, threads, partial reorthogonalization
+ *          (`Solver::set_reorthogonalization()`, 0 or 1), iterations until all shifts have converged
+ *          or stalled, the number of shifts stalled at the reorthogonalization loss (always 0 without it),
+ *          setup and solve time (best of the repetitions), time per iteration, the largest relative true residual,
+ *          the memory of the matrices and of the solver (solutions, auxiliary vectors and, with reorthogonalization,
+ *          the stored Lanczos vectors) and the peak resident set size of the process.
+ *
+ * \par Usage:
+ * \code
+ *  $ ./gsminres_bench [--problems lap2d,lap3d,banded,tb] [--sizes 1000,10000] [--shifts 4,16]
+ *                     [--threads 1,2] [--reorth 0,1] [--formats csr,packed] [--tol 1e-10] [--repeat 3]
+ *                     [--bandwidth 5] [--orbitals 4] [--max-packed 4000] [--output results.csv]
+ * \endcode
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "gsminres_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include "gsminres_bench_problems.hpp"
+
+#ifndef GSMINRES_VERSION
+#define GSMINRES_VERSION "unknown"
+#endif
+
+namespace {
+
+  struct Options {
+    std::vector<std::string> problems   = {"lap2d", "lap3d", "banded", "tb"};
+    std::vector<std::size_t> sizes      = {1000, 10000};
+    std::vector<std::size_t> shifts     = {4, 16};
+    std::vector<std::size_t> threads    = {1};
+    std::vector<std::size_t> reorth     = {0};
+    std::vector<std::string> formats    = {"csr", "packed"};
+    double                   tol        = 1e-10;
+    std::size_t              repeat     = 3;
+    std::size_t              bandwidth  = 5;
+    std::size_t              orbitals   = 4;
+    std::size_t              max_packed = 4000;
+    std::size_t              max_iter   = 100000;
+    std::string              output;
+  };
+
+  struct Result {
+    std::size_t iterations = 0;
+    std::size_t stalled    = 0;
+    double      setup      = 0.0;
+    double      solve      = 0.0;
+    double      residual   = 0.0;
+  };
+
+  std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> list;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      if (!item.empty()) {
+        list.push_back(item);
+      }
+    }
+    return list;
+  }
+
+  std::vector<std::size_t> split_sizes(const std::string& s) {
+    std::vector<std::size_t> list;
+    for (const std::string& item : split(s)) {
+      list.push_back(std::stoul(item));
+    }
+    return list;
+  }
+
+  void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--problems lap2d,lap3d,banded,tb] [--sizes N,...] [--shifts M,...]\n"
+              << "       [--threads T,...] [--reorth 0,1] [--formats csr,packed] [--tol tol] [--repeat R]\n"
+              << "       [--bandwidth bw] [--orbitals b] [--max-packed N] [--max-iter K] [--output file]" << std::endl;
+  }
+
+  Options parse(int argc, char* argv[]) {
+    Options opt;
+    for (int i=1; i<argc; i++) {
+      const std::string key = argv[i];
+      if (i+1 >= argc) {
+        usage(argv[0]);
+        std::exit(EXIT_FAILURE);
+      }
+      const std::string val = argv[++i];
+      if      (key == "--problems")   opt.problems   = split(val);
+      else if (key == "--sizes")      opt.sizes      = split_sizes(val);
+      else if (key == "--shifts")     opt.shifts     = split_sizes(val);
+      else if (key == "--threads")    opt.threads    = split_sizes(val);
+      else if (key == "--reorth")     opt.reorth     = split_sizes(val);
+      else if (key == "--formats")    opt.formats    = split(val);
+      else if (key == "--tol")        opt.tol        = std::stod(val);
+      else if (key == "--repeat")     opt.repeat     = std::max<std::size_t>(1, std::stoul(val));
+      else if (key == "--bandwidth")  opt.bandwidth  = std::stoul(val);
+      else if (key == "--orbitals")   opt.orbitals   = std::stoul(val);
+      else if (key == "--max-packed") opt.max_packed = std::stoul(val);
+      else if (key == "--max-iter")   opt.max_iter   = std::stoul(val);
+      else if (key == "--output")     opt.output     = val;
+      else {
+        usage(argv[0]);
+        std::exit(EXIT_FAILURE);
+      }
+    }
+    return opt;
+  }
+
+  gsminres::bench::Problem generate(const std::string& kind, std::size_t size, const Options& opt) {
+    if (kind == "lap2d") {
+      return gsminres::bench::laplacian_2d(static_cast<std::size_t>(std::lround(std::sqrt(static_cast<double>(size)))));
+    } else if (kind == "lap3d") {
+      return gsminres::bench::laplacian_3d(static_cast<std::size_t>(std::lround(std::cbrt(static_cast<double>(size)))));
+    } else if (kind == "banded") {
+      return gsminres::bench::banded_hermitian(size, opt.bandwidth);
+    } else if (kind == "tb") {
+      return gsminres::bench::tight_binding(std::max<std::size_t>(1, size/opt.orbitals), opt.orbitals);
+    }
+    std::cerr << "gsminres_bench: [ERROR] Unknown problem " << kind << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  /**
+   * \brief Solve all shifted systems once and check the true residuals.
+   */
+  Result run(const gsminres::bench::Problem& p, const std::string& format,
+             const std::vector<std::complex<double>>& sigma, bool reorth, const Options& opt) {
+    const std::size_t N = p.A.matrix_size;
+    const std::size_t M = sigma.size();
+    const bool packed = (format == "packed");
+    Result r;
+    const std::vector<std::complex<double>> b = gsminres::util::generate_ones(N);
+    std::vector<std::complex<double>> x(M*N, {0.0, 0.0}), w(N), u(N);
+    std::vector<std::complex<double>> Ap, Bp, Bc;
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (packed) {
+      Ap = gsminres::bench::to_packed(p.A);
+      Bp = gsminres::bench::to_packed(p.B);
+      Bc = Bp;
+      gsminres::lapack::zpptrf(static_cast<int>(N), Bc);
+    }
+    r.setup = seconds_since(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    auto matvec = [&](std::vector<std::complex<double>>& in, std::vector<std::complex<double>>& out) {
+      if (packed) {
+        gsminres::blas::zhpmv({1.0, 0.0}, Ap, in, {0.0, 0.0}, out);
+      } else {
+        gsminres::util::spmv(p.A, in, out);
+      }
+    };
+    auto bsolve = [&](std::vector<std::complex<double>>& out, const std::vector<std::complex<double>>& in) {
+      if (packed) {
+        gsminres::lapack::zpptrs(static_cast<int>(N), Bc, out, in);
+      } else if (!gsminres::util::cg(p.B, out, in, 1e-13, 10000)) {
+        std::cerr << "gsminres_bench: [ERROR] Inner CG did not converge" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    };
+    gsminres::Solver solver(N, M);
+    solver.set_reorthogonalization(reorth);
+    bsolve(w, b);
+    solver.initialize(x, b, w, sigma, opt.tol);
+    for (std::size_t j=1; j<=opt.max_iter; ++j) {
+      matvec(w, u);
+      solver.glanczos_pre(u);
+      bsolve(w, u);
+      solver.glanczos_pst(w, u);
+      r.iterations = j;
+      if (solver.update(x)) {
+        break;
+      }
+    }
+    r.solve = seconds_since(t0);
+    std::vector<std::size_t> stalled;
+    solver.get_stalled(stalled);
+    r.stalled = static_cast<std::size_t>(std::count_if(stalled.begin(), stalled.end(),
+                                                       [](std::size_t k) { return k != 0; }));
+
+    // True residuals ||b - (A + sigma B) x|| / ||b|| (not timed)
+    const double bnrm = gsminres::blas::dznrm2(N, b);
+    std::vector<std::complex<double>> xm(N), Ax(N), Bx(N);
+    for (std::size_t m=0; m<M; m++) {
+      gsminres::blas::zcopy(N, x, m*N, xm, 0);
+      gsminres::util::spmv(p.A, xm, Ax);
+      gsminres::util::spmv(p.B, xm, Bx);
+      gsminres::blas::zaxpy(N, sigma[m], Bx, 0, Ax, 0);
+      gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, 0, Ax, 0);
+      r.residual = std::max(r.residual, gsminres::blas::dznrm2(N, Ax)/bnrm);
+    }
+    return r;
+  }
+
+  double peak_rss_mb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss)/1024.0; // kilobytes on Linux
+  }
+
+}  // namespace
+
+
+int main(int argc, char* argv[]) {
+  const Options opt = parse(argc, argv);
+  std::ofstream file;
+  if (!opt.output.empty()) {
+    file.open(opt.output);
+    if (!file) {
+      std::cerr << "gsminres_bench: [ERROR] Cannot open " << opt.output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& os = opt.output.empty() ? std::cout : file;
+  os << "version,problem,format,N,nnz,M,threads,reorth,iterations,stalled,setup_s,solve_s,per_iter_ms,"
+     << "max_rel_residual,matrix_mb,solver_mb,peak_rss_mb" << std::endl;
+
+  for (const std::string& kind : opt.problems) {
+    for (const std::size_t size : opt.sizes) {
+      const gsminres::bench::Problem p = generate(kind, size, opt);
+      const std::size_t N = p.A.matrix_size;
+      for (const std::string& format : opt.formats) {
+        if (format != "csr" && format != "packed") {
+          std::cerr << "gsminres_bench: [ERROR] Unknown format " << format << std::endl;
+          return 1;
+        }
+        if (format == "packed" && N > opt.max_packed) {
+          std::cerr << "gsminres_bench: skipping packed format for " << p.name
+                    << " (N > " << opt.max_packed << ")" << std::endl;
+          continue;
+        }
+        const double matrix_mb = (format == "packed")
+          ? 3.0*16.0*static_cast<double>(N*(N+1)/2)/1e6  // A, B and the Cholesky factor of B
+          : (24.0*static_cast<double>(p.A.values.size() + p.B.values.size()) + 16.0*static_cast<double>(N+1))/1e6;
+        for (const std::size_t M : opt.shifts) {
+          std::vector<std::complex<double>> sigma(M);
+          for (std::size_t i=0; i<M; i++) {
+            sigma[i] = 0.1*std::exp(std::complex<double>(0.0, 2.0*M_PI*(static_cast<double>(i)+0.5)/static_cast<double>(M)));
+          }
+          // Solutions and the three auxiliary vectors per shift, six Lanczos vectors
+          const double base_mb = 16.0*static_cast<double>(4*M*N + 6*N)/1e6;
+          for (const std::size_t T : opt.threads) {
+#ifdef _OPENMP
+            omp_set_num_threads(static_cast<int>(T));
+#endif
+            for (const std::size_t R : opt.reorth) {
+              Result best;
+              for (std::size_t k=0; k<opt.repeat; k++) {
+                const Result r = run(p, format, sigma, R != 0, opt);
+                if (k == 0 || r.solve < best.solve) {
+                  best = r;
+                }
+              }
+              // With reorthogonalization, w and Bw of every iteration are stored as well
+              const double solver_mb = base_mb
+                + (R != 0 ? 16.0*2.0*static_cast<double>(N)*static_cast<double>(best.iterations + 1)/1e6 : 0.0);
+              os << GSMINRES_VERSION << "," << p.name << "," << format << ","
+                 << N << "," << p.A.values.size() << "," << M << "," << T << ","
+                 << (R != 0 ? 1 : 0) << "," << best.iterations << "," << best.stalled << ","
+                 << std::scientific << std::setprecision(6)
+                 << best.setup << "," << best.solve << ","
+                 << best.solve*1e3/static_cast<double>(best.iterations) << ","
+                 << std::setprecision(3) << best.residual << ","
+                 << std::fixed << std::setprecision(3)
+                 << matrix_mb << "," << solver_mb << "," << peak_rss_mb() << std::endl;
+              os.unsetf(std::ios::floatfield);
+            }
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * \file gsminres_bench_problems.cpp
+ * \brief Implementation of the synthetic problems for the GSMINRES++ benchmark suite.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_bench_problems.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+namespace gsminres {
+  namespace bench {
+
+    namespace {
+      using Row = std::vector<std::pair<std::size_t, std::complex<double>>>;
+
+      /**
+       * \brief Assemble a CSR matrix from unsorted rows.
+       */
+      util::CSRMat from_rows(std::vector<Row>& rows) {
+        std::size_t nnz = 0;
+        for (const Row& r : rows) {
+          nnz += r.size();
+        }
+        util::CSRMat A(rows.size()+1, nnz);
+        std::size_t pos = 0;
+        for (std::size_t i=0; i<rows.size(); i++) {
+          std::sort(rows[i].begin(), rows[i].end(),
+                    [](const Row::value_type& a, const Row::value_type& b) { return a.first < b.first; });
+          for (const Row::value_type& e : rows[i]) {
+            A.col_indices[pos] = e.first;
+            A.values[pos]      = e.second;
+            pos++;
+          }
+          A.row_pointer[i+1] = pos;
+        }
+        return A;
+      }
+
+      /**
+       * \brief Add the entry (i, j) and its conjugate (j, i) to A and B (i != j).
+       */
+      void add_pair(std::vector<Row>& A, std::vector<Row>& B, std::size_t i, std::size_t j,
+                    std::complex<double> a, std::complex<double> b) {
+        A[i].push_back({j, a});
+        A[j].push_back({i, std::conj(a)});
+        B[i].push_back({j, b});
+        B[j].push_back({i, std::conj(b)});
+      }
+
+      /**
+       * \brief Append the diagonal of B as one plus the sum of the moduli of the row (diagonally dominant).
+       */
+      void dominant_diagonal(std::vector<Row>& B) {
+        for (std::size_t i=0; i<B.size(); i++) {
+          double sum = 0.0;
+          for (const Row::value_type& e : B[i]) {
+            sum += std::abs(e.second);
+          }
+          B[i].push_back({i, {1.0 + sum, 0.0}});
+        }
+      }
+    }  // namespace
+
+    Problem laplacian_2d(std::size_t n) {
+      const std::size_t N = n*n;
+      std::vector<Row> A(N), B(N);
+      for (std::size_t y=0; y<n; y++) {
+        for (std::size_t x=0; x<n; x++) {
+          const std::size_t i = x + y*n;
+          A[i].push_back({i, {4.0, 0.0}});
+          B[i].push_back({i, {2.0/3.0, 0.0}});
+          if (x+1 < n) add_pair(A, B, i, i+1, {-1.0, 0.0}, {1.0/12.0, 0.0});
+          if (y+1 < n) add_pair(A, B, i, i+n, {-1.0, 0.0}, {1.0/12.0, 0.0});
+        }
+      }
+      Problem p;
+      p.name = "lap2d_n" + std::to_string(n);
+      p.A    = from_rows(A);
+      p.B    = from_rows(B);
+      return p;
+    }
+
+    Problem laplacian_3d(std::size_t n) {
+      const std::size_t N = n*n*n;
+      std::vector<Row> A(N), B(N);
+      for (std::size_t z=0; z<n; z++) {
+        for (std::size_t y=0; y<n; y++) {
+          for (std::size_t x=0; x<n; x++) {
+            const std::size_t i = x + (y + z*n)*n;
+            A[i].push_back({i, {6.0, 0.0}});
+            B[i].push_back({i, {0.5, 0.0}});
+            if (x+1 < n) add_pair(A, B, i, i+1,   {-1.0, 0.0}, {1.0/24.0, 0.0});
+            if (y+1 < n) add_pair(A, B, i, i+n,   {-1.0, 0.0}, {1.0/24.0, 0.0});
+            if (z+1 < n) add_pair(A, B, i, i+n*n, {-1.0, 0.0}, {1.0/24.0, 0.0});
+          }
+        }
+      }
+      Problem p;
+      p.name = "lap3d_n" + std::to_string(n);
+      p.A    = from_rows(A);
+      p.B    = from_rows(B);
+      return p;
+    }
+
+    Problem banded_hermitian(std::size_t N, std::size_t bandwidth, std::uint64_t seed) {
+      std::mt19937_64 gen(seed);
+      std::uniform_real_distribution<double> unit(-1.0, 1.0);
+      std::vector<Row> A(N), B(N);
+      const double bw = static_cast<double>(bandwidth);
+      for (std::size_t i=0; i<N; i++) {
+        A[i].push_back({i, {bw*unit(gen), 0.0}});
+        for (std::size_t j=i+1; j<=i+bandwidth && j<N; j++) {
+          const double ar = unit(gen), ai = unit(gen);
+          const double br = 0.5*unit(gen), bi = 0.5*unit(gen);
+          add_pair(A, B, i, j, {ar, ai}, {br, bi});
+        }
+      }
+      dominant_diagonal(B);
+      Problem p;
+      p.name = "banded_N" + std::to_string(N) + "_bw" + std::to_string(bandwidth);
+      p.A    = from_rows(A);
+      p.B    = from_rows(B);
+      return p;
+    }
+
+    Problem tight_binding(std::size_t cells, std::size_t orbitals, std::uint64_t seed) {
+      std::mt19937_64 gen(seed);
+      std::uniform_real_distribution<double> unit(-1.0, 1.0);
+      const std::size_t b = orbitals;
+      // On-site (upper triangle, Hermitian) and hopping blocks, the same for all cells
+      std::vector<std::complex<double>> H0(b*b), T(b*b), S0(b*b), S1(b*b);
+      for (std::size_t j=0; j<b; j++) {
+        H0[j+j*b] = {unit(gen), 0.0};
+        for (std::size_t i=0; i<j; i++) {
+          H0[i+j*b] = {0.5*unit(gen), 0.5*unit(gen)};
+          S0[i+j*b] = {0.05*unit(gen), 0.05*unit(gen)};
+        }
+      }
+      for (std::size_t k=0; k<b*b; k++) {
+        T[k]  = {0.5*unit(gen), 0.5*unit(gen)};
+        S1[k] = {0.05*unit(gen), 0.05*unit(gen)};
+      }
+      const std::size_t N = cells*b;
+      std::vector<Row> A(N), B(N);
+      for (std::size_t c=0; c<cells; c++) {
+        const std::size_t o = c*b;
+        for (std::size_t j=0; j<b; j++) {
+          A[o+j].push_back({o+j, H0[j+j*b]});
+          for (std::size_t i=0; i<j; i++) {
+            add_pair(A, B, o+i, o+j, H0[i+j*b], S0[i+j*b]);
+          }
+        }
+        if (c+1 < cells) {
+          for (std::size_t j=0; j<b; j++) {
+            for (std::size_t i=0; i<b; i++) {
+              add_pair(A, B, o+i, o+b+j, T[i+j*b], S1[i+j*b]);
+            }
+          }
+        }
+      }
+      dominant_diagonal(B);
+      Problem p;
+      p.name = "tb_cells" + std::to_string(cells) + "_orb" + std::to_string(orbitals);
+      p.A    = from_rows(A);
+      p.B    = from_rows(B);
+      return p;
+    }
+
+    std::vector<std::complex<double>> to_packed(const util::CSRMat& A) {
+      const std::size_t N = A.matrix_size;
+      std::vector<std::complex<double>> P(N*(N+1)/2, {0.0, 0.0});
+      for (std::size_t i=0; i<N; i++) {
+        for (std::size_t k=A.row_pointer[i]; k<A.row_pointer[i+1]; k++) {
+          const std::size_t j = A.col_indices[k];
+          if (i <= j) {
+            P[i + j*(j+1)/2] = A.values[k];
+          }
+        }
+      }
+      return P;
+    }
+
+  }  // namespace bench
+}  // namespace gsminres
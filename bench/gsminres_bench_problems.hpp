@@ -0,0 +1,91 @@
+/**
+ * \file gsminres_bench_problems.hpp
+ * \brief Synthetic generalized shifted problems for the GSMINRES++ benchmark suite.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header provides generators of Hermitian matrix pairs (A, B), B positive definite,
+ *          so that the benchmarks do not depend on downloaded matrices. All generators are
+ *          deterministic: random entries are drawn from `std::mt19937_64` with a fixed seed.
+ *          - `laplacian_2d()`, `laplacian_3d()`: finite-difference Laplacians (Dirichlet) and
+ *            consistent-mass-like B.
+ *          - `banded_hermitian()`: random banded Hermitian A (indefinite) and a diagonally dominant B
+ *            of the same band.
+ *          - `tight_binding()`: block tridiagonal Hamiltonian of a chain of cells with several orbitals,
+ *            with a non-orthogonal overlap matrix B.
+ */
+
+#ifndef GSMINRES_BENCH_PROBLEMS_HPP
+#define GSMINRES_BENCH_PROBLEMS_HPP
+
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gsminres_util.hpp"
+
+namespace gsminres {
+  namespace bench {
+
+    /**
+     * \struct Problem
+     * \brief Matrix pair of a generalized shifted problem.
+     */
+    struct Problem {
+      std::string    name; ///< Name including the parameters (e.g. "lap2d_n100").
+      util::CSRMat   A;    ///< Hermitian matrix.
+      util::CSRMat   B;    ///< Hermitian positive-definite matrix.
+      /**
+       * \brief Constructor for Problem (empty matrices).
+       */
+      Problem() : name(), A(1, 0), B(1, 0) {}
+    };
+
+    /**
+     * \brief 5-point Laplacian on an n x n grid, B with 2/3 on the diagonal and 1/12 for the neighbours.
+     * \param[in] n Number of grid points per direction (N = n^2).
+     * \return Problem.
+     */
+    Problem laplacian_2d(std::size_t n);
+
+    /**
+     * \brief 7-point Laplacian on an n x n x n grid, B with 1/2 on the diagonal and 1/24 for the neighbours.
+     * \param[in] n Number of grid points per direction (N = n^3).
+     * \return Problem.
+     */
+    Problem laplacian_3d(std::size_t n);
+
+    /**
+     * \brief Random banded Hermitian A and diagonally dominant B.
+     * \details The off-diagonal entries within the band are uniform in the unit square (A) and
+     *          in [-0.5, 0.5]^2 (B); the diagonal of A is uniform in [-bandwidth, bandwidth],
+     *          and the diagonal of B is one plus the sum of the moduli of its row.
+     * \param[in] N         Matrix size.
+     * \param[in] bandwidth Number of off-diagonals on each side.
+     * \param[in] seed      Seed of the random entries.
+     * \return Problem.
+     */
+    Problem banded_hermitian(std::size_t N, std::size_t bandwidth, std::uint64_t seed = 1);
+
+    /**
+     * \brief Tight-binding chain of cells with several orbitals and a non-orthogonal overlap.
+     * \details The on-site block and the hopping block between neighbouring cells are random and the same
+     *          for all cells; the overlap has small random off-diagonal entries (0.05) in the same pattern
+     *          and is made diagonally dominant.
+     * \param[in] cells    Number of cells.
+     * \param[in] orbitals Number of orbitals per cell (N = cells * orbitals).
+     * \param[in] seed     Seed of the random entries.
+     * \return Problem.
+     */
+    Problem tight_binding(std::size_t cells, std::size_t orbitals, std::uint64_t seed = 1);
+
+    /**
+     * \brief Convert a Hermitian CSR matrix to the packed format (upper triangle) of `blas::zhpmv()`.
+     * \param[in] A Matrix (CSR format).
+     * \return Packed matrix, \f$ a_{ij} \f$ (i <= j) at i + j(j+1)/2.
+     */
+    std::vector<std::complex<double>> to_packed(const util::CSRMat& A);
+
+  }  // namespace bench
+}  // namespace gsminres
+
+#endif // GSMINRES_BENCH_PROBLEMS_HPP
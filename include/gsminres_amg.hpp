@@ -0,0 +1,105 @@
+/**
+ * \file gsminres_amg.hpp
+ * \brief Smoothed aggregation algebraic multigrid (AMG) preconditioner for GSMINRES++.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header provides a smoothed aggregation AMG for Hermitian positive-definite
+ *          matrices in `util::CSRMat` format, intended as the preconditioner of `util::cg()`
+ *          for the inner linear systems with B. The number of CG iterations then stays
+ *          (nearly) independent of the matrix size.
+ *
+ *          The setup builds, on every level,
+ *          - the strength graph: \f$ |a_{ij}|^2 \ge \theta^2 |a_{ii}||a_{jj}| \f$,
+ *          - aggregates of strongly connected nodes (greedy, three phases),
+ *          - the tentative prolongator from the constant vector, smoothed by one damped Jacobi step
+ *            \f$ P = (I - \omega D^{-1}A)T \f$,
+ *          - the Galerkin coarse matrix \f$ A_c = P^H A P \f$,
+ *
+ *          until the coarse matrix is small enough for a dense Cholesky factorization.
+ *          The strength graph, the prolongator and the sparse matrix products are threaded with OpenMP;
+ *          the aggregation itself is sequential. The setup depends only on the matrix,
+ *          so it should be built once and reused for all inner solves.
+ *
+ *          The V-cycle uses damped Jacobi pre- and post-smoothing, so that it is a Hermitian
+ *          positive-definite preconditioner suitable for CG.
+ */
+
+#ifndef GSMINRES_AMG_HPP
+#define GSMINRES_AMG_HPP
+
+#include <complex>
+#include <vector>
+#include "gsminres_util.hpp"
+
+namespace gsminres {
+  namespace util {
+
+    /**
+     * \struct AMGParam
+     * \brief Parameters of the smoothed aggregation AMG setup.
+     */
+    struct AMGParam {
+      double      strength        = 0.08; ///< Strength threshold \f$ \theta \f$.
+      std::size_t max_levels      = 10;   ///< Maximum number of levels.
+      std::size_t coarse_size     = 500;  ///< Coarsening stops at or below this size (dense Cholesky).
+      std::size_t smoothing_steps = 1;    ///< Number of Jacobi sweeps before and after the coarse correction.
+    };
+
+    /**
+     * \struct AMGLevel
+     * \brief One level of the AMG hierarchy.
+     * \details P and R are stored as `CSRMat` with matrix_size equal to their number of rows.
+     */
+    struct AMGLevel {
+      CSRMat              A;        ///< Matrix of this level.
+      CSRMat              P;        ///< Prolongator from the next coarser level (rows of this level).
+      CSRMat              R;        ///< Restriction \f$ P^H \f$ (rows of the next coarser level).
+      std::vector<double> inv_diag; ///< Inverse of the diagonal of A.
+      double              omega;    ///< Jacobi damping \f$ 4/(3\rho(D^{-1}A)) \f$.
+      mutable std::vector<std::complex<double>> x, b, r; ///< Work vectors of the V-cycle.
+      /**
+       * \brief Constructor for AMGLevel (empty level, filled by `amg_setup()`).
+       */
+      AMGLevel() : A(1, 0), P(1, 0), R(1, 0), inv_diag(), omega(1.0), x(), b(), r() {}
+    };
+
+    /**
+     * \struct AMGHierarchy
+     * \brief Smoothed aggregation AMG hierarchy built by `amg_setup()`.
+     * \details The work vectors are part of the hierarchy, so one hierarchy must not be used
+     *          by several threads at the same time.
+     */
+    struct AMGHierarchy {
+      std::vector<AMGLevel>             levels;        ///< Levels from the finest (input matrix) to the coarsest.
+      std::vector<std::complex<double>> coarse_factor; ///< Packed Cholesky factor of the coarsest matrix (empty if coarsening stalled).
+      std::size_t                       smoothing_steps = 1; ///< Number of Jacobi sweeps.
+    };
+
+    /**
+     * \brief Build the smoothed aggregation AMG hierarchy of a Hermitian positive-definite matrix.
+     * \details The input matrix is copied to the finest level. If the coarsening stalls
+     *          (strongly diagonally dominant matrix) above `param.coarse_size`, the coarsest level
+     *          is smoothed instead of factorized.
+     * \param[in] A     Matrix (CSR format).
+     * \param[in] param Setup parameters.
+     * \return AMG hierarchy.
+     * \note Exits the program if a diagonal element is not positive.
+     */
+    AMGHierarchy amg_setup(const CSRMat& A, const AMGParam& param = AMGParam());
+
+    /**
+     * \brief Apply one V-cycle with zero initial guess: \f$ z = M^{-1} r \f$.
+     * \details Can be passed to `util::cg()` as the preconditioner, e.g.
+     *          `[&H](const auto& r, auto& z) { util::amg_vcycle(H, r, z); }`.
+     * \param[in]  H AMG hierarchy.
+     * \param[in]  r Input vector (size = N).
+     * \param[out] z Output vector (size = N).
+     */
+    void amg_vcycle(const AMGHierarchy&                      H,
+                    const std::vector<std::complex<double>>& r,
+                    std::vector<std::complex<double>>&       z);
+
+  }  // namespace util
+}  // namespace gsminres
+
+#endif // GSMINRES_AMG_HPP
@@ -0,0 +1,143 @@
+/**
+ * \file gsminres_batch_solver.hpp
+ * \brief Header file for the GSMINRES++ batched solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `BatchSolver` class, which advances
+ *          K independent generalized shifted MINRES iterations in lockstep.
+ *          All right-hand sides share the same matrix pair and the same shifts,
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)}_k = b_k, \quad (m = 1, \dots, M,\ k = 1, \dots, K)
+ *          \f]
+ *          so that the matrix-vector multiplication and the inner linear solve
+ *          can be applied to all K Lanczos vectors at once as a multi-vector operation
+ *          (e.g. `gsminres::util::spmm` and `gsminres::util::block_cg`).
+ *
+ *          Multi-vectors of K vectors are stored column by column,
+ *          i.e. the k-th vector occupies the range [k*N, (k+1)*N).
+ *          The solutions are stored as x[(k*M + m)*N + i].
+ */
+
+#ifndef GSMINRES_BATCH_SOLVER_HPP
+#define GSMINRES_BATCH_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+#include <array>
+
+namespace gsminres {
+
+  /**
+   * \class BatchSolver
+   * \brief Batched generalized shifted MINRES solver class.
+   * \details This class runs one generalized Lanczos process per right-hand side,
+   *          but exposes the matrix-vector multiplication and the inner linear solve
+   *          as operations on a block of K vectors.
+   *          The convergence is tracked for each pair of right-hand side and shift.
+   *          Once all shifts of a right-hand side have converged, its columns of the
+   *          Lanczos block are set to zero and are no longer updated.
+   */
+  class BatchSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] shift_size  Number of shifts.
+     * \param[in] rhs_size    Number of right-hand sides.
+     */
+    BatchSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t rhs_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~BatchSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for iteration.
+     * \param[out]    x         Approximate solutions (size = rhs_size * shift_size * matrix_size).
+     * \param[in]     b         Right-hand side vectors (size = rhs_size * matrix_size).
+     * \param[in,out] w         Pre-processed right-hand sides \f$ B^{-1}b_k \f$ (size = rhs_size * matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals.
+     */
+    void initialize(std::vector<std::complex<double>>& x,
+                    const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Block to which the matrix-vector multiplication is applied, \f$ U=AW \f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed block \f$ W = B^{-1}U \f$.
+     * \param[in,out] u Block which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the approximate solutions and check convergence.
+     * \param[in,out] x Solution vectors to be updated (size = rhs_size * shift_size * matrix_size).
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each system (size = rhs_size * shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each system (size = rhs_size * shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each system (size = rhs_size * shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+    /**
+     * \brief Check whether all shifts of a right-hand side have converged.
+     * \param[in] k Index of the right-hand side.
+     * \return true if the k-th right-hand side has converged for every shift.
+     */
+    bool is_converged(std::size_t k) const;
+
+  private:
+    // Basic parameters
+    std::size_t iter_;                        ///< Number of iterations
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    std::size_t rhs_size_;                    ///< Number of right-hand sides \f$ K \f$
+    std::vector<double> r0_norm_;             ///< Norms of the initial residuals (size = K)
+    std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
+
+    // Generalized Lanczos process variables (one set per right-hand side)
+    std::vector<double> alpha_;                    ///< alpha coefficients
+    std::vector<double> beta_prev_, beta_curr_;    ///< beta coefficients (previous and current)
+    std::vector<std::complex<double>> w_prev_, w_curr_, w_next_; ///< Lanczos basis blocks
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary blocks
+
+    // Variables for updating the solutions (one set per right-hand side and shift)
+    std::vector<std::complex<double>> T_prev2_, T_prev_, T_curr_, T_next_; ///< Elements of the tridiagonal matrix
+    std::vector<std::array<double, 3>>               Gc_; ///< Givens rotation matrixs element "c"
+    std::vector<std::array<std::complex<double>, 3>> Gs_; ///< Givens rotation matrixs element "s"
+    std::vector<std::complex<double>> p_prev2_, p_prev_, p_curr_; ///< Auxiliary vectors (rhs*shift*matrix)
+    std::vector<std::complex<double>> f_; ///< Auxiliary variables
+    std::vector<double> h_;               ///< Residual norms in Algorithm
+
+    // Convergence-related variables
+    std::size_t conv_num_;             ///< Number of systems that have converged
+    std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    std::vector<std::size_t> rhs_conv_num_; ///< Number of converged shifts for each right-hand side
+    double threshold_;                 ///< Relative reisudal convergence threshold
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_BATCH_SOLVER_HPP
@@ -4,8 +4,8 @@
  * \author Shuntaro Hidaka
  *
  * \details This header defines lightweight C++ wrapper functions for
- *          selected BLAS Level-1 and Level-2 routines such as
- *          `zaxpy`, `dznrm2`, `zdotc`, and `zhpmv`, which are used internally in GSMINRES++.
+ *          selected BLAS Level-1, Level-2 and Level-3 routines such as
+ *          `zaxpy`, `dznrm2`, `zdotc`, `zhpmv` and `zgemm`, which are used internally in GSMINRES++.
  *          The interfaces are designed for safety and usability using `std::vector`,
  *          and provide explicit control over starting offsets and memory strides
  *          for advanced vector operations.
@@ -19,6 +19,7 @@
 #include <vector>
 #include <cstddef>
 #include <cstdlib>
+#include "gsminres_profiler.hpp"
 
 extern "C" {
   void dscal_(const int *n, const double *a, double *x, const int *incx);
@@ -32,6 +33,9 @@ extern "C" {
   void zhpmv_(char *uplo, int *n, std::complex<double> *alpha, std::complex<double> *A, std::complex<double> *x, int *incx, std::complex<double> *beta, std::complex<double> *y, int *incy);
   void zrotg_(std::complex<double> *a, std::complex<double> *b, double *c, std::complex<double> *s);
   void zrot_(const int *n, std::complex<double> *x, const int *incx, std::complex<double> *y, const int *incy, const double *c, const std::complex<double> *s);
+  void zgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k, const std::complex<double> *alpha, const std::complex<double> *A, const int *lda, const std::complex<double> *B, const int *ldb, const std::complex<double> *beta, std::complex<double> *C, const int *ldc);
+  void ztrmm_(const char *side, const char *uplo, const char *transa, const char *diag, const int *m, const int *n, const std::complex<double> *alpha, const std::complex<double> *A, const int *lda, std::complex<double> *B, const int *ldb);
+  void ztrsm_(const char *side, const char *uplo, const char *transa, const char *diag, const int *m, const int *n, const std::complex<double> *alpha, const std::complex<double> *A, const int *lda, std::complex<double> *B, const int *ldb);
 }
 
 /**
@@ -87,6 +91,7 @@ namespace gsminres {
      */
     inline void zdscal(std::size_t n, double a,
                        std::vector<std::complex<double>>& x, std::size_t x_offset=0, std::size_t incx=1) {
+      GSMINRES_PROFILE_KERNEL("zdscal", -1, 32.0*n, 2.0*n);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx);
       zdscal_(&nn, &a, x.data()+x_offset, &ix);
@@ -102,6 +107,7 @@ namespace gsminres {
      */
     inline void zscal(std::size_t n, std::complex<double> a,
                       std::vector<std::complex<double>>& x, std::size_t x_offset=0, std::size_t incx=1) {
+      GSMINRES_PROFILE_KERNEL("zscal", -1, 32.0*n, 6.0*n);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx);
       zscal_(&nn, &a, x.data()+x_offset, &ix);
@@ -121,6 +127,7 @@ namespace gsminres {
                       const std::vector<std::complex<double>>& x, std::size_t x_offset,
                       std::vector<std::complex<double>>&       y, std::size_t y_offset,
                       std::size_t incx=1, std::size_t incy=1) {
+      GSMINRES_PROFILE_KERNEL("zcopy", -1, 32.0*n, 0.0);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx), iy = static_cast<int>(incy);
       zcopy_(&nn, x.data()+x_offset, &ix, y.data()+y_offset, &iy);
@@ -141,6 +148,7 @@ namespace gsminres {
                       const std::vector<std::complex<double>>& x, std::size_t x_offset,
                       std::vector<std::complex<double>>&       y, std::size_t y_offset,
                       std::size_t incx=1, std::size_t incy=1) {
+      GSMINRES_PROFILE_KERNEL("zaxpy", -1, 48.0*n, 8.0*n);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx), iy = static_cast<int>(incy);
       zaxpy_(&nn, &alpha, x.data()+x_offset, &ix, y.data()+y_offset, &iy);
@@ -161,6 +169,7 @@ namespace gsminres {
                                       const std::vector<std::complex<double>>& x, std::size_t x_offset,
                                       const std::vector<std::complex<double>>& y, std::size_t y_offset,
                                       std::size_t incx=1, std::size_t incy=1) {
+      GSMINRES_PROFILE_KERNEL("zdotc", -1, 32.0*n, 8.0*n);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx), iy = static_cast<int>(incy);
       return zdotc_(&nn, x.data()+x_offset, &ix, y.data()+y_offset, &iy);
@@ -177,6 +186,7 @@ namespace gsminres {
     inline double dznrm2(std::size_t n,
                          const std::vector<std::complex<double>>& x, std::size_t x_offset=0,
                          std::size_t incx=1) {
+      GSMINRES_PROFILE_KERNEL("dznrm2", -1, 16.0*n, 4.0*n);
       int nn = static_cast<int>(n);
       int ix = static_cast<int>(incx);
       return dznrm2_(&nn, x.data()+x_offset, &ix);
@@ -199,6 +209,7 @@ namespace gsminres {
                       const std::vector<std::complex<double>>& x,
                       std::complex<double> beta,
                       std::vector<std::complex<double>>&       y) {
+      GSMINRES_PROFILE_KERNEL("zhpmv", -1, 8.0*x.size()*(x.size()+1) + 48.0*x.size(), 8.0*x.size()*x.size());
       char uplo = 'U';
       int n = static_cast<int>(x.size()), incx = 1, incy = 1;
       zhpmv_(&uplo, &n, &alpha, const_cast<std::complex<double>*>(A.data()), const_cast<std::complex<double>*>(x.data()), &incx, &beta, y.data(), &incy);
@@ -237,6 +248,92 @@ namespace gsminres {
       int ix = static_cast<int>(incx), iy = static_cast<int>(incy);
       zrot_(&nn, x.data()+x_offset, &ix, y.data()+y_offset, &iy, &c, &s);
     }
+
+    /**
+     * \brief General complex matrix-matrix multiplication: \f$ C = \alpha op(A) op(B) + \beta C \f$.
+     * \details All matrices are stored in column-major order.
+     * \param[in]     transa   'N', 'T' or 'C' for op(A).
+     * \param[in]     transb   'N', 'T' or 'C' for op(B).
+     * \param[in]     m        Number of rows of op(A) and C.
+     * \param[in]     n        Number of columns of op(B) and C.
+     * \param[in]     k        Number of columns of op(A) and rows of op(B).
+     * \param[in]     alpha    Scalar multiplier for op(A)*op(B).
+     * \param[in]     A        Matrix A.
+     * \param[in]     a_offset Starting index within the A matrix.
+     * \param[in]     lda      Leading dimension of A.
+     * \param[in]     B        Matrix B.
+     * \param[in]     b_offset Starting index within the B matrix.
+     * \param[in]     ldb      Leading dimension of B.
+     * \param[in]     beta     Scalar multiplier for C.
+     * \param[in,out] C        Matrix C.
+     * \param[in]     c_offset Starting index within the C matrix.
+     * \param[in]     ldc      Leading dimension of C.
+     */
+    inline void zgemm(char transa, char transb,
+                      std::size_t m, std::size_t n, std::size_t k,
+                      std::complex<double> alpha,
+                      const std::vector<std::complex<double>>& A, std::size_t a_offset, std::size_t lda,
+                      const std::vector<std::complex<double>>& B, std::size_t b_offset, std::size_t ldb,
+                      std::complex<double> beta,
+                      std::vector<std::complex<double>>&       C, std::size_t c_offset, std::size_t ldc) {
+      GSMINRES_PROFILE_KERNEL("zgemm", -1, 16.0*(m*k + k*n + 2.0*m*n), 8.0*m*n*k);
+      int mm = static_cast<int>(m), nn = static_cast<int>(n), kk = static_cast<int>(k);
+      int la = static_cast<int>(lda), lb = static_cast<int>(ldb), lc = static_cast<int>(ldc);
+      zgemm_(&transa, &transb, &mm, &nn, &kk, &alpha, A.data()+a_offset, &la, B.data()+b_offset, &lb, &beta, C.data()+c_offset, &lc);
+    }
+
+    /**
+     * \brief Solve a triangular matrix equation: \f$ op(A) X = \alpha B \f$ or \f$ X op(A) = \alpha B \f$.
+     * \details The solution X overwrites B. All matrices are stored in column-major order.
+     * \param[in]     side     'L' for op(A) X, 'R' for X op(A).
+     * \param[in]     uplo     'U' or 'L' for upper or lower triangular A.
+     * \param[in]     transa   'N', 'T' or 'C' for op(A).
+     * \param[in]     diag     'U' for unit triangular A, 'N' otherwise.
+     * \param[in]     m        Number of rows of B.
+     * \param[in]     n        Number of columns of B.
+     * \param[in]     alpha    Scalar multiplier for B.
+     * \param[in]     A        Triangular matrix A.
+     * \param[in]     a_offset Starting index within the A matrix.
+     * \param[in]     lda      Leading dimension of A.
+     * \param[in,out] B        Right-hand side matrix, overwritten by X.
+     * \param[in]     b_offset Starting index within the B matrix.
+     * \param[in]     ldb      Leading dimension of B.
+     */
+    inline void ztrsm(char side, char uplo, char transa, char diag,
+                      std::size_t m, std::size_t n,
+                      std::complex<double> alpha,
+                      const std::vector<std::complex<double>>& A, std::size_t a_offset, std::size_t lda,
+                      std::vector<std::complex<double>>&       B, std::size_t b_offset, std::size_t ldb) {
+      int mm = static_cast<int>(m), nn = static_cast<int>(n);
+      int la = static_cast<int>(lda), lb = static_cast<int>(ldb);
+      ztrsm_(&side, &uplo, &transa, &diag, &mm, &nn, &alpha, A.data()+a_offset, &la, B.data()+b_offset, &lb);
+    }
+    /**
+     * \brief Triangular matrix-matrix product: \f$ B = \alpha op(A) B \f$ or \f$ B = \alpha B op(A) \f$.
+     * \details All matrices are stored in column-major order.
+     * \param[in]     side     'L' for op(A) B, 'R' for B op(A).
+     * \param[in]     uplo     'U' or 'L' for upper or lower triangular A.
+     * \param[in]     transa   'N', 'T' or 'C' for op(A).
+     * \param[in]     diag     'U' for unit triangular A, 'N' otherwise.
+     * \param[in]     m        Number of rows of B.
+     * \param[in]     n        Number of columns of B.
+     * \param[in]     alpha    Scalar multiplier.
+     * \param[in]     A        Triangular matrix A.
+     * \param[in]     a_offset Starting index within the A matrix.
+     * \param[in]     lda      Leading dimension of A.
+     * \param[in,out] B        Matrix B, overwritten by the product.
+     * \param[in]     b_offset Starting index within the B matrix.
+     * \param[in]     ldb      Leading dimension of B.
+     */
+    inline void ztrmm(char side, char uplo, char transa, char diag,
+                      std::size_t m, std::size_t n,
+                      std::complex<double> alpha,
+                      const std::vector<std::complex<double>>& A, std::size_t a_offset, std::size_t lda,
+                      std::vector<std::complex<double>>&       B, std::size_t b_offset, std::size_t ldb) {
+      int mm = static_cast<int>(m), nn = static_cast<int>(n);
+      int la = static_cast<int>(lda), lb = static_cast<int>(ldb);
+      ztrmm_(&side, &uplo, &transa, &diag, &mm, &nn, &alpha, A.data()+a_offset, &la, B.data()+b_offset, &lb);
+    }
   }  //namespace blas
 }  // namespace gsminres
 
@@ -0,0 +1,167 @@
+/**
+ * \file gsminres_block_solver.hpp
+ * \brief Header file for the GSMINRES++ block solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `BlockSolver` class, which implements
+ *          the block generalized shifted MINRES method for L right-hand sides
+ *          \f[
+ *            (A + \sigma^{(m)} B)X^{(m)} = [b_1, \dots, b_L], \quad (m = 1, \dots, M).
+ *          \f]
+ *          Unlike `gsminres::BatchSolver`, all right-hand sides share a single
+ *          block Krylov subspace built by the block generalized Lanczos process,
+ *          which reduces the number of iterations for clustered right-hand sides.
+ *
+ *          Blocks of L vectors are stored column by column,
+ *          i.e. the l-th vector occupies the range [l*N, (l+1)*N).
+ *          The solutions are stored as x[(l*M + m)*N + i].
+ */
+
+#ifndef GSMINRES_BLOCK_SOLVER_HPP
+#define GSMINRES_BLOCK_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+
+namespace gsminres {
+
+  /**
+   * \class BlockSolver
+   * \brief Block generalized shifted MINRES solver class.
+   * \details The Lanczos blocks are B-orthonormalized by two passes of Cholesky QR of the small
+   *          L x L Gram matrix. Columns that become linearly dependent are deflated:
+   *          they are set to zero and excluded from the following iterations.
+   *          The block tridiagonal matrix is reduced per shift by Householder QR
+   *          of 2L x L blocks, and the solutions are updated with matrix-matrix products.
+   *          A shift stops being updated once all of its columns have converged.
+   */
+  class BlockSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] shift_size  Number of shifts.
+     * \param[in] block_size  Number of right-hand sides.
+     */
+    BlockSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t block_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~BlockSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for iteration.
+     * \param[out]    x         Approximate solutions (size = block_size * shift_size * matrix_size).
+     * \param[in]     b         Right-hand side block (size = block_size * matrix_size).
+     * \param[in,out] w         Pre-processed right-hand side block \f$ B^{-1}b \f$ (size = block_size * matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals.
+     */
+    void initialize(std::vector<std::complex<double>>& x,
+                    const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the block generalized Lanczos process.
+     * \param[in,out] u Block to which the matrix-vector multiplication is applied, \f$ U=AW \f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the block generalized Lanczos process.
+     * \param[in,out] w Pre-processed block \f$ W = B^{-1}U \f$.
+     * \param[in,out] u Block which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the approximate solutions and check convergence.
+     * \param[in,out] x Solution vectors to be updated (size = block_size * shift_size * matrix_size).
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each system (size = block_size * shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each system (size = block_size * shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each system (size = block_size * shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+    /**
+     * \brief Retrieve the number of deflated (linearly dependent) columns of the Lanczos block.
+     * \return Number of deflated columns.
+     */
+    std::size_t get_deflated() const;
+
+    /**
+     * \brief Set the tolerance used to detect linearly dependent columns.
+     * \details A column is deflated when its squared B-norm after orthogonalization against
+     *          the preceding columns falls below `tol` times its squared B-norm before.
+     * \param[in] tol Relative deflation tolerance (default = 1e-14).
+     */
+    void set_deflation_tolerance(const double tol);
+
+  private:
+    /**
+     * \brief Cholesky factorization \f$ G = R^H R \f$ of a Gram matrix with column deflation.
+     * \details Newly dependent columns are marked in `deflated_`.
+     * \param[in]  G Hermitian L x L Gram matrix.
+     * \param[out] R Upper triangular factor (zero rows for deflated columns).
+     */
+    void cholesky_deflate(const std::vector<std::complex<double>>& G,
+                          std::vector<std::complex<double>>& R);
+
+    /**
+     * \brief Compute \f$ V R^{-1} \f$ in place and zero deflated columns.
+     * \param[in]     R Triangular factor returned by `cholesky_deflate()`.
+     * \param[in,out] V Block to be normalized (size = block_size * matrix_size).
+     */
+    void normalize_block(const std::vector<std::complex<double>>& R,
+                         std::vector<std::complex<double>>& V);
+
+    // Basic parameters
+    std::size_t iter_;                        ///< Number of iterations
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    std::size_t block_size_;                  ///< Block size \f$ L \f$
+    std::vector<double> r0_norm_;             ///< Norms of the initial residuals (size = L)
+    std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
+
+    // Block generalized Lanczos process variables (L x L matrices are column-major)
+    std::vector<std::complex<double>> alpha_;                    ///< alpha block
+    std::vector<std::complex<double>> beta_prev_, beta_curr_;    ///< beta blocks (previous and current)
+    std::vector<std::complex<double>> w_prev_, w_curr_, w_next_; ///< Lanczos basis blocks
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary blocks
+    std::vector<bool> deflated_;  ///< Flags indicating deflated columns of the Lanczos block
+    double deflation_tol_;        ///< Relative deflation tolerance
+
+    // Variables for updating the solutions
+    std::vector<std::complex<double>> Q_prev2_, Q_prev_;     ///< Householder reflectors of the last two QR steps (shift * 2L * L)
+    std::vector<std::complex<double>> tau_prev2_, tau_prev_; ///< Householder scalar factors (shift * L)
+    std::vector<std::complex<double>> p_prev2_, p_prev_; ///< Direction blocks of the last two steps (shift*matrix*L)
+    std::vector<std::complex<double>> work_;  ///< Work block (size = matrix * L)
+    std::vector<std::complex<double>> g_;     ///< Right-hand side of the projected problems (shift * L * L)
+    std::vector<double> h_;                   ///< Residual norms in Algorithm (L * shift)
+
+    // Convergence-related variables
+    std::size_t conv_num_;             ///< Number of systems that have converged
+    std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    std::vector<std::size_t> shift_conv_num_; ///< Number of converged columns for each shift
+    double threshold_;                 ///< Relative reisudal convergence threshold
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_BLOCK_SOLVER_HPP
@@ -32,6 +32,15 @@ extern "C" {
    */
   typedef void* gsminres_handle;
 
+  /**
+   * \brief Callback type called when a shifted system has converged.
+   * \details The arguments are the index of the shift (zero-based), a pointer to
+   *          its final solution (`double _Complex`, size = n), the matrix size,
+   *          and the user pointer given to `gsminres_set_convergence_callback`.
+   *          The solution pointer is valid only during the call.
+   */
+  typedef void (*gsminres_convergence_callback)(size_t shift, const void *xm, size_t n, void *user_data);
+
   /**
    * \brief Create a new GSMINRES Solver.
    * \param[in] n Matrix size.
@@ -40,6 +49,15 @@ extern "C" {
    */
   gsminres_handle gsminres_create(size_t n, size_t m);
 
+  /**
+   * \brief Create a new GSMINRES Solver for the standard shifted systems (B = I).
+   * \details Use `gsminres_glanczos` in place of `gsminres_glanczos_pre` and `gsminres_glanczos_pst`.
+   * \param[in] n Matrix size.
+   * \param[in] m Number of shifts.
+   * \return Solver handle.
+   */
+  gsminres_handle gsminres_create_std(size_t n, size_t m);
+
   /**
    * \brief Destroy the solver and free memory.
    * \param handle Solver handle.
@@ -88,6 +106,16 @@ extern "C" {
                              void            *u,
                              const size_t    n);
 
+  /**
+   * \brief Perform one step of the Lanczos process for a solver created by `gsminres_create_std`.
+   * \param[in]     handle Solver handle.
+   * \param[in,out] v      On input \f$ Aw \f$, on output the next Lanczos vector (size = n).
+   * \param[in]     n      Matrix size.
+   */
+  void gsminres_glanczos(gsminres_handle handle,
+                         void            *v,
+                         const size_t    n);
+
   /**
    * \brief Update the approximate solutions and check convergence.
    * \param[in]     handle Solver handle.
@@ -128,6 +156,16 @@ extern "C" {
                              void            *res,
                              const size_t    m);
 
+  /**
+   * \brief Register a callback to hand over each solution as soon as it has converged.
+   * \param[in] handle    Solver handle.
+   * \param[in] callback  Function to be called from `gsminres_update` (NULL disables the callback).
+   * \param[in] user_data Pointer passed to the callback unchanged.
+   */
+  void gsminres_set_convergence_callback(gsminres_handle               handle,
+                                         gsminres_convergence_callback callback,
+                                         void                          *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,200 @@
+/**
+ * \file gsminres_contour_solver.hpp
+ * \brief Header file for the GSMINRES++ contour-integral eigensolver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `ContourSolver` class, a Sakurai-Sugiura type eigensolver
+ *          for the interior eigenpairs of the Hermitian-definite pencil (A, B),
+ *          \f[
+ *            Ax = \lambda Bx, \quad |\lambda - \gamma| < \rho,
+ *          \f]
+ *          built on `gsminres::Solver`. The moments
+ *          \f[
+ *            S_k = \frac{1}{2\pi i}\oint_\Gamma \left(\frac{z-\gamma}{\rho}\right)^k (zB - A)^{-1} BV\, dz
+ *                \approx \sum_{m=1}^{M} \omega_m \zeta_m^k (z_m B - A)^{-1} BV
+ *          \f]
+ *          are approximated by the trapezoidal rule on the circle,
+ *          \f$ z_m = \gamma + \rho\zeta_m,\ \zeta_m = e^{2\pi i(m+1/2)/M},\ \omega_m = \rho\zeta_m/M \f$,
+ *          i.e. by the shifted systems \f$ (A + \sigma^{(m)} B)x = Bv \f$ with \f$ \sigma^{(m)} = -z_m \f$,
+ *          which is the layout of the shifts in the sample programs.
+ *
+ *          The L source vectors V are random and are processed one after another by a `Solver`.
+ *          Every solution is added to the moments as soon as its shift has converged
+ *          (convergence callback), so that only the solutions of one source (M N) and the moments
+ *          (N L K) are kept, never the M N L solutions of all sources.
+ *
+ *          Two extraction methods are provided:
+ *          - SS-Hankel (`hankel()`): the eigenvalues of the pencil of block Hankel matrices of
+ *            \f$ \mu_k = V^H S_k \f$ (k = 0, ..., 2K-1). No further operation with A or B.
+ *          - SS-RR (`basis()` and `rayleigh_ritz()`): Rayleigh-Ritz on the orthonormalized
+ *            \f$ [S_0, \dots, S_{K-1}] \f$, with AQ and BQ computed by the caller. More accurate.
+ */
+
+#ifndef GSMINRES_CONTOUR_SOLVER_HPP
+#define GSMINRES_CONTOUR_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+#include <memory>
+#include "gsminres_solver.hpp"
+
+namespace gsminres {
+
+  /**
+   * \class ContourSolver
+   * \brief Contour-integral (Sakurai-Sugiura) eigensolver driving the generalized shifted MINRES solver.
+   * \details For each source l = 0, ..., L-1, the caller computes \f$ b = Bv_l \f$ with the source
+   *          vector from `get_source()`, calls `initialize()`, and runs the usual iteration loop
+   *          (matrix-vector multiplication with A and inner solve with B) until `update()` returns true.
+   *          No inner solve is needed for the initial vector, since \f$ B^{-1}b = v_l \f$.
+   *          After all sources, the eigenpairs in the circle are extracted.
+   */
+  class ContourSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size     Matrix size.
+     * \param[in] center          Center \f$ \gamma \f$ of the circle.
+     * \param[in] radius          Radius \f$ \rho \f$ of the circle.
+     * \param[in] quadrature_size Number of quadrature points M (= number of shifts).
+     * \param[in] source_size     Number of source vectors L.
+     * \param[in] moment_size     Number of moments K (the subspace dimension is at most L K).
+     */
+    ContourSolver(std::size_t matrix_size, std::complex<double> center, double radius,
+                  std::size_t quadrature_size, std::size_t source_size, std::size_t moment_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~ContourSolver() = default;
+
+    /**
+     * \brief Shifts passed to the shifted solver, \f$ \sigma^{(m)} = -z_m \f$.
+     * \return Vector of shifts (size = quadrature_size).
+     */
+    const std::vector<std::complex<double>>& get_shifts() const { return sigma_; }
+
+    /**
+     * \brief Retrieve a source vector.
+     * \param[in]  source Index of the source (< source_size).
+     * \param[out] v      Source vector \f$ v_l \f$ (size = matrix_size).
+     */
+    void get_source(std::size_t source, std::vector<std::complex<double>>& v) const;
+
+    /**
+     * \brief Start the shifted systems of a source.
+     * \param[in]  source    Index of the source (< source_size).
+     * \param[in]  b         Right-hand side \f$ Bv_l \f$ (size = matrix_size).
+     * \param[out] w         Vector to which the first matrix-vector multiplication is applied (size = matrix_size).
+     * \param[in]  threshold Convergence threshold for relative residuals.
+     */
+    void initialize(std::size_t source,
+                    const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in]     u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the solutions and add the newly converged ones to the moments.
+     * \return true if all shifts of the current source have converged, false otherwise.
+     */
+    bool update();
+
+    /**
+     * \brief Add the current approximations of the unconverged shifts to the moments.
+     * \details Only needed if the iteration of a source is stopped before `update()` returns true.
+     */
+    void flush();
+
+    /**
+     * \brief Retrieve the converged iterations of the current source.
+     * \param[out] conv_itr Number of iterations for each shift (size = quadrature_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each shift (size = quadrature_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Extract the eigenpairs in the circle with the block SS-Hankel method.
+     * \param[out] eigenvalues  Eigenvalues in the circle.
+     * \param[out] eigenvectors Corresponding eigenvectors, normalized in the 2-norm (size = matrix_size * count).
+     * \param[in]  delta        Relative threshold of the singular values for the numerical rank.
+     * \return Number of eigenpairs found in the circle.
+     */
+    std::size_t hankel(std::vector<std::complex<double>>& eigenvalues,
+                       std::vector<std::complex<double>>& eigenvectors,
+                       const double delta = 1e-12) const;
+
+    /**
+     * \brief Orthonormal basis of the moment subspace for the SS-RR method.
+     * \details The columns of \f$ [S_0, \dots, S_{K-1}] \f$ are orthonormalized by the SVD,
+     *          and singular vectors below the threshold are dropped.
+     * \param[out] Q     Orthonormal basis (size = matrix_size * rank).
+     * \param[in]  delta Relative threshold of the singular values for the numerical rank.
+     * \return Rank (number of basis vectors).
+     */
+    std::size_t basis(std::vector<std::complex<double>>& Q, const double delta = 1e-12);
+
+    /**
+     * \brief Extract the eigenpairs in the circle by the Rayleigh-Ritz procedure.
+     * \param[in]  AQ           A times the basis from `basis()` (size = matrix_size * rank).
+     * \param[in]  BQ           B times the basis from `basis()` (size = matrix_size * rank).
+     * \param[out] eigenvalues  Eigenvalues in the circle (real, ascending).
+     * \param[out] eigenvectors Corresponding eigenvectors, normalized in the 2-norm (size = matrix_size * count).
+     * \return Number of eigenpairs found in the circle.
+     */
+    std::size_t rayleigh_ritz(const std::vector<std::complex<double>>& AQ,
+                              const std::vector<std::complex<double>>& BQ,
+                              std::vector<double>&                     eigenvalues,
+                              std::vector<std::complex<double>>&       eigenvectors) const;
+
+  private:
+    /**
+     * \brief Add the solution of one shift of the current source to the moments.
+     * \param[in] shift Index of the shift.
+     * \param[in] xm    Solution of the shift (size = matrix_size).
+     */
+    void accumulate(std::size_t shift, const std::complex<double>* xm);
+
+    // Basic parameters
+    std::size_t matrix_size_;     ///< Matrix size \f$ N \f$
+    std::size_t quadrature_size_; ///< Number of quadrature points \f$ M \f$
+    std::size_t source_size_;     ///< Number of source vectors \f$ L \f$
+    std::size_t moment_size_;     ///< Number of moments \f$ K \f$
+    std::complex<double> center_; ///< Center of the circle \f$ \gamma \f$
+    double radius_;               ///< Radius of the circle \f$ \rho \f$
+
+    // Quadrature
+    std::vector<std::complex<double>> sigma_;  ///< Shifts \f$ -z_m \f$
+    std::vector<std::complex<double>> zeta_;   ///< Normalized quadrature points \f$ \zeta_m \f$
+    std::vector<std::complex<double>> weight_; ///< Quadrature weights \f$ \omega_m \f$
+
+    // Moments
+    std::vector<std::complex<double>> V_;  ///< Source vectors (matrix*L)
+    std::vector<std::complex<double>> S_;  ///< Moments \f$ S_k \f$, column k*L+l (matrix*L*K)
+    std::vector<std::complex<double>> mu_; ///< Reduced moments \f$ \mu_k = V^H S_k \f$, k = 0, ..., 2K-1 (L*L*2K)
+    std::vector<std::complex<double>> Q_;  ///< Basis of the SS-RR method (matrix*rank)
+
+    // Current source
+    std::size_t source_;                  ///< Index of the current source
+    std::vector<bool> added_;             ///< Whether the shift has been added to the moments
+    std::vector<std::complex<double>> x_; ///< Solutions of the current source (matrix*M)
+    std::unique_ptr<Solver> solver_;      ///< Shifted solver of the current source
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_CONTOUR_SOLVER_HPP
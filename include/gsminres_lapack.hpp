@@ -11,6 +11,9 @@
  *          The routines include Cholesky factorization (zpptrf), linear solve (zpptrs),
  *          and robust Givens rotation computation (zlartg) as a workaround for known
  *          OpenBLAS issues in zrot.
+ *          Householder QR routines (zgeqrf, zunmqr) are also provided for
+ *          the small dense factorizations in `gsminres::BlockSolver`, and the dense
+ *          SVD and eigensolvers (zgesvd, zgeev, zhegv) for the reduced problems of `gsminres::ContourSolver`.
  */
 
 #ifndef GSMINRES_LAPACK_HPP
@@ -21,11 +24,18 @@
 #include <vector>
 #include <cstddef>
 #include <cstdlib>
+#include "gsminres_blas.hpp"
 
 extern "C" {
   void zpptrf_(char *uplo, int *n, std::complex<double> *ap, int *info);
   void zpptrs_(char *uplo, int *n, int *nrhs, std::complex<double> *ap, std::complex<double> *b, int *ldb, int *info);
   void zlartg_(std::complex<double> *f, std::complex<double> *g, double *c, std::complex<double> *s, std::complex<double> *r);
+  void zgeqrf_(int *m, int *n, std::complex<double> *A, int *lda, std::complex<double> *tau, std::complex<double> *work, int *lwork, int *info);
+  void zunmqr_(char *side, char *trans, int *m, int *n, int *k, std::complex<double> *A, int *lda, std::complex<double> *tau, std::complex<double> *C, int *ldc, std::complex<double> *work, int *lwork, int *info);
+  void dsterf_(int *n, double *d, double *e, int *info);
+  void zgesvd_(char *jobu, char *jobvt, int *m, int *n, std::complex<double> *A, int *lda, double *s, std::complex<double> *U, int *ldu, std::complex<double> *VT, int *ldvt, std::complex<double> *work, int *lwork, double *rwork, int *info);
+  void zgeev_(char *jobvl, char *jobvr, int *n, std::complex<double> *A, int *lda, std::complex<double> *w, std::complex<double> *VL, int *ldvl, std::complex<double> *VR, int *ldvr, std::complex<double> *work, int *lwork, double *rwork, int *info);
+  void zhegv_(int *itype, char *jobz, char *uplo, int *n, std::complex<double> *A, int *lda, std::complex<double> *B, int *ldb, double *w, std::complex<double> *work, int *lwork, double *rwork, int *info);
 }
 
 /**
@@ -96,7 +106,155 @@ namespace gsminres {
       zlartg_(&f, &g, &c, &s, &r);
       f = r;
     }
-      
+
+    /**
+     * \brief Compute a QR factorization of a general complex matrix using Householder reflectors.
+     * \param[in]     m        Number of rows of A.
+     * \param[in]     n        Number of columns of A.
+     * \param[in,out] A        On input, the m x n matrix (column-major). On output, R in the upper triangle
+     *                          and the Householder reflectors below the diagonal.
+     * \param[in]     a_offset Starting index within the A matrix.
+     * \param[in]     lda      Leading dimension of A.
+     * \param[out]    tau      Scalar factors of the reflectors (size >= min(m, n)).
+     * \param[in]     t_offset Starting index within the tau vector.
+     * \note Exits the program on failure.
+     */
+    inline void zgeqrf(int m, int n,
+                       std::vector<std::complex<double>>& A, std::size_t a_offset, int lda,
+                       std::vector<std::complex<double>>& tau, std::size_t t_offset) {
+      int info = 0, lwork = n > 0 ? n : 1;
+      std::vector<std::complex<double>> work(lwork);
+      zgeqrf_(&m, &n, A.data()+a_offset, &lda, tau.data()+t_offset, work.data(), &lwork, &info);
+      if (info != 0) {
+        std::cerr << "zgeqrf: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    /**
+     * \brief Multiply a matrix by the unitary matrix Q computed by `zgeqrf`.
+     * \param[in]     side     'L' for op(Q) C, 'R' for C op(Q).
+     * \param[in]     trans    'N' for Q, 'C' for \f$ Q^H \f$.
+     * \param[in]     m        Number of rows of C.
+     * \param[in]     n        Number of columns of C.
+     * \param[in]     k        Number of reflectors.
+     * \param[in]     A        Householder reflectors as returned by `zgeqrf`.
+     * \param[in]     a_offset Starting index within the A matrix.
+     * \param[in]     lda      Leading dimension of A.
+     * \param[in]     tau      Scalar factors of the reflectors.
+     * \param[in]     t_offset Starting index within the tau vector.
+     * \param[in,out] C        Matrix to be multiplied, overwritten by the result.
+     * \param[in]     c_offset Starting index within the C matrix.
+     * \param[in]     ldc      Leading dimension of C.
+     * \note Exits the program on failure.
+     */
+    inline void zunmqr(char side, char trans, int m, int n, int k,
+                       const std::vector<std::complex<double>>& A, std::size_t a_offset, int lda,
+                       const std::vector<std::complex<double>>& tau, std::size_t t_offset,
+                       std::vector<std::complex<double>>& C, std::size_t c_offset, int ldc) {
+      int info = 0, lwork = (side == 'L' ? n : m);
+      if (lwork < 1) lwork = 1;
+      std::vector<std::complex<double>> work(lwork);
+      zunmqr_(&side, &trans, &m, &n, &k, const_cast<std::complex<double>*>(A.data())+a_offset, &lda,
+              const_cast<std::complex<double>*>(tau.data())+t_offset, C.data()+c_offset, &ldc,
+              work.data(), &lwork, &info);
+      if (info != 0) {
+        std::cerr << "zunmqr: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    /**
+     * \brief Compute all eigenvalues of a real symmetric tridiagonal matrix.
+     * \param[in]     n Dimension of the matrix.
+     * \param[in,out] d On input, the diagonal elements (size = n). On output, the eigenvalues in ascending order.
+     * \param[in,out] e On input, the off-diagonal elements (size >= n-1). Destroyed on output.
+     * \note Exits the program on failure.
+     */
+    inline void dsterf(int n, std::vector<double>& d, std::vector<double>& e) {
+      int info = 0;
+      dsterf_(&n, d.data(), e.data(), &info);
+      if (info != 0) {
+        std::cerr << "dsterf: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    /**
+     * \brief Compute the thin singular value decomposition \f$ A = U \Sigma V^H \f$ of a general complex matrix.
+     * \param[in]     m  Number of rows of A.
+     * \param[in]     n  Number of columns of A.
+     * \param[in,out] A  The m x n matrix (column-major, lda = m). Destroyed on output.
+     * \param[out]    s  Singular values in descending order (size >= min(m, n)).
+     * \param[out]    U  Left singular vectors (m x min(m, n), ldu = m).
+     * \param[out]    VT Right singular vectors \f$ V^H \f$ (min(m, n) x n, ldvt = min(m, n)).
+     * \note Exits the program on failure.
+     */
+    inline void zgesvd(int m, int n, std::vector<std::complex<double>>& A, std::vector<double>& s,
+                       std::vector<std::complex<double>>& U, std::vector<std::complex<double>>& VT) {
+      char job = 'S';
+      int k = m < n ? m : n;
+      int lda = m, ldu = m, ldvt = k > 0 ? k : 1, info = 0, lwork = -1;
+      std::complex<double> query;
+      std::vector<double> rwork(5*k > 0 ? 5*k : 1);
+      zgesvd_(&job, &job, &m, &n, A.data(), &lda, s.data(), U.data(), &ldu, VT.data(), &ldvt, &query, &lwork, rwork.data(), &info);
+      lwork = static_cast<int>(query.real());
+      std::vector<std::complex<double>> work(lwork > 0 ? lwork : 1);
+      zgesvd_(&job, &job, &m, &n, A.data(), &lda, s.data(), U.data(), &ldu, VT.data(), &ldvt, work.data(), &lwork, rwork.data(), &info);
+      if (info != 0) {
+        std::cerr << "zgesvd: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    /**
+     * \brief Compute the eigenvalues and right eigenvectors of a general complex matrix.
+     * \param[in]     n  Dimension of the matrix.
+     * \param[in,out] A  The n x n matrix (column-major, lda = n). Destroyed on output.
+     * \param[out]    w  Eigenvalues (size = n).
+     * \param[out]    VR Right eigenvectors (n x n, column j belongs to w[j]).
+     * \note Exits the program on failure.
+     */
+    inline void zgeev(int n, std::vector<std::complex<double>>& A, std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& VR) {
+      char jobvl = 'N', jobvr = 'V';
+      int lda = n, ldvl = 1, ldvr = n, info = 0, lwork = -1;
+      std::complex<double> query, VL;
+      std::vector<double> rwork(2*n > 0 ? 2*n : 1);
+      zgeev_(&jobvl, &jobvr, &n, A.data(), &lda, w.data(), &VL, &ldvl, VR.data(), &ldvr, &query, &lwork, rwork.data(), &info);
+      lwork = static_cast<int>(query.real());
+      std::vector<std::complex<double>> work(lwork > 0 ? lwork : 1);
+      zgeev_(&jobvl, &jobvr, &n, A.data(), &lda, w.data(), &VL, &ldvl, VR.data(), &ldvr, work.data(), &lwork, rwork.data(), &info);
+      if (info != 0) {
+        std::cerr << "zgeev: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
+    /**
+     * \brief Solve the Hermitian-definite generalized eigenproblem \f$ Ax = \lambda Bx \f$.
+     * \param[in]     n Dimension of the matrices.
+     * \param[in,out] A Hermitian matrix (column-major, upper triangle used). On output, the B-orthonormal eigenvectors.
+     * \param[in,out] B Hermitian positive-definite matrix (upper triangle used). Destroyed on output.
+     * \param[out]    w Eigenvalues in ascending order (size = n).
+     * \note Exits the program on failure.
+     */
+    inline void zhegv(int n, std::vector<std::complex<double>>& A, std::vector<std::complex<double>>& B,
+                      std::vector<double>& w) {
+      char jobz = 'V', uplo = 'U';
+      int itype = 1, lda = n, ldb = n, info = 0, lwork = -1;
+      std::complex<double> query;
+      std::vector<double> rwork(3*n > 2 ? 3*n-2 : 1);
+      zhegv_(&itype, &jobz, &uplo, &n, A.data(), &lda, B.data(), &ldb, w.data(), &query, &lwork, rwork.data(), &info);
+      lwork = static_cast<int>(query.real());
+      std::vector<std::complex<double>> work(lwork > 0 ? lwork : 1);
+      zhegv_(&itype, &jobz, &uplo, &n, A.data(), &lda, B.data(), &ldb, w.data(), work.data(), &lwork, rwork.data(), &info);
+      if (info != 0) {
+        std::cerr << "zhegv: [ERROR] failed INFO = " << std::to_string(info) << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+
   }  // namespace lapack
 }  // namespace gsminres
 
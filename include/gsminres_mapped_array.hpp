@@ -0,0 +1,112 @@
+/**
+ * \file gsminres_mapped_array.hpp
+ * \brief Memory-mapped file storage for large complex arrays in GSMINRES++.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `MappedArray` class, which stores an array of
+ *          `std::complex<double>` in a file mapped into the address space with `mmap`.
+ *          The array is divided into slices of equal length (e.g. one slice per shift).
+ *          Slices are brought into memory ahead of use with `prefetch()` and
+ *          dropped from the resident set with `release()`, so that the resident memory
+ *          stays within a window of a few slices while the whole array may exceed RAM.
+ *
+ *          Only POSIX systems are supported.
+ */
+
+#ifndef GSMINRES_MAPPED_ARRAY_HPP
+#define GSMINRES_MAPPED_ARRAY_HPP
+
+#include <complex>
+#include <string>
+
+namespace gsminres {
+
+  /**
+   * \class MappedArray
+   * \brief Complex array stored in a memory-mapped file.
+   * \details The file is created (or truncated) and filled with zeros by the constructor.
+   *          The mapping is released by the destructor. Errors exit the program.
+   */
+  class MappedArray {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] filename     Path of the backing file.
+     * \param[in] slice_size   Number of elements of one slice.
+     * \param[in] slice_count  Number of slices.
+     * \param[in] remove_file  If true, the backing file is deleted by the destructor.
+     */
+    MappedArray(const std::string& filename, std::size_t slice_size, std::size_t slice_count,
+                bool remove_file = false);
+
+    /**
+     * \brief Destructor.
+     * \details Unmaps the file, and deletes it if requested in the constructor.
+     */
+    ~MappedArray();
+
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator=(const MappedArray&) = delete;
+
+    /**
+     * \brief Pointer to the first element of a slice.
+     * \param[in] s Index of the slice.
+     * \return Pointer to the s-th slice.
+     */
+    std::complex<double>* slice(std::size_t s) { return data_ + s*slice_size_; }
+
+    /**
+     * \brief Pointer to the first element of a slice (read-only).
+     * \param[in] s Index of the slice.
+     * \return Pointer to the s-th slice.
+     */
+    const std::complex<double>* slice(std::size_t s) const { return data_ + s*slice_size_; }
+
+    /**
+     * \brief Hint that slices will be accessed soon (`MADV_WILLNEED`).
+     * \param[in] first First slice index.
+     * \param[in] count Number of slices.
+     */
+    void prefetch(std::size_t first, std::size_t count = 1) const;
+
+    /**
+     * \brief Drop slices from the resident memory (`MADV_DONTNEED`).
+     * \details Modified pages are kept in the file; they are written back by the kernel.
+     * \param[in] first First slice index.
+     * \param[in] count Number of slices.
+     */
+    void release(std::size_t first, std::size_t count = 1) const;
+
+    /**
+     * \brief Fill all slices with zeros, releasing their pages.
+     */
+    void clear();
+
+    /**
+     * \brief Number of elements of one slice.
+     */
+    std::size_t slice_size() const { return slice_size_; }
+
+    /**
+     * \brief Number of slices.
+     */
+    std::size_t slice_count() const { return slice_count_; }
+
+  private:
+    /**
+     * \brief Byte range of slices, extended to page boundaries.
+     */
+    void page_range(std::size_t first, std::size_t count, char*& addr, std::size_t& length) const;
+
+    std::string filename_;        ///< Path of the backing file
+    std::size_t slice_size_;      ///< Number of elements of one slice
+    std::size_t slice_count_;     ///< Number of slices
+    std::size_t bytes_;           ///< Size of the mapping in bytes
+    bool remove_file_;            ///< Delete the file in the destructor
+    int fd_;                      ///< File descriptor of the backing file
+    std::complex<double>* data_;  ///< Start of the mapping
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_MAPPED_ARRAY_HPP
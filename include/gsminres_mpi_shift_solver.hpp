@@ -0,0 +1,156 @@
+/**
+ * \file gsminres_mpi_shift_solver.hpp
+ * \brief Header file for the GSMINRES++ shift-partitioned solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines `gsminres::mpi::ShiftSolver`, which distributes the shifts
+ *          \f$ \sigma^{(m)} \f$ over the MPI processes instead of the rows.
+ *          The Lanczos vectors (O(N)) are replicated, and each process stores and updates
+ *          the auxiliary vectors and the solutions (O(M N)) of its own shifts only,
+ *          so that memory and update cost scale with the number of processes.
+ *
+ *          Two modes are available:
+ *          - Redundant mode (default): every process performs the matrix-vector multiplication
+ *            and the inner solve itself. No vector is communicated.
+ *          - Broadcast mode: only the leader process performs them, and broadcasts
+ *            the Lanczos coefficients and the next Lanczos vector (N elements) every iteration.
+ *
+ *          In both modes, one integer is reduced per iteration to detect global convergence.
+ *          Available only if the library is built with `GSMINRES_ENABLE_MPI`.
+ */
+
+#ifndef GSMINRES_MPI_SHIFT_SOLVER_HPP
+#define GSMINRES_MPI_SHIFT_SOLVER_HPP
+
+#include <mpi.h>
+#include <complex>
+#include <vector>
+#include "gsminres_solver.hpp"
+
+namespace gsminres {
+  namespace mpi {
+
+    /**
+     * \class ShiftSolver
+     * \brief Generalized shifted MINRES solver class with the shifts distributed over processes.
+     * \details The shifts are split into contiguous balanced blocks; this process owns the shifts
+     *          [shift_begin(), shift_begin() + local_shift_size()). The solution vectors passed to
+     *          `initialize()` and `update()` contain these shifts only (size = matrix_size * local_shift_size()).
+     *          The iteration loop is the same as for `gsminres::Solver`; in broadcast mode, the
+     *          matrix-vector multiplication and the inner solve may be skipped when `applies_operators()`
+     *          is false. All processes of the communicator must call every function.
+     */
+    class ShiftSolver {
+    public:
+      /**
+       * \brief Constructor.
+       * \param[in] comm        Communicator over which the shifts are distributed.
+       * \param[in] matrix_size Matrix size.
+       * \param[in] shift_size  Total number of shifts.
+       * \param[in] broadcast   true for broadcast mode, false for redundant mode.
+       * \param[in] leader      Rank of the leader process in broadcast mode.
+       */
+      ShiftSolver(MPI_Comm comm, std::size_t matrix_size, std::size_t shift_size,
+                  bool broadcast = false, int leader = 0);
+
+      /**
+       * \brief Deconstructor.
+       * \details Default destructor. No manual cleanup required.
+       */
+      ~ShiftSolver() = default;
+
+      /**
+       * \brief Initialize the solver with input data and prepare for iteration.
+       * \details In broadcast mode, w is only read on the leader and is broadcast to the others.
+       * \param[out]    x         Approximate solutions of the local shifts (size = matrix_size * local_shift_size()).
+       * \param[in]     b         Right-hand side vector, the same on all processes (size = matrix_size).
+       * \param[in,out] w         Pre-processed right-hand side \f$ B^{-1}b \f$ (size = matrix_size).
+       * \param[in]     sigma     Vector of all shift parameters (size = shift_size).
+       * \param[in]     threshold Convergence threshold for relative residuals.
+       */
+      void initialize(std::vector<std::complex<double>>& x,
+                      const std::vector<std::complex<double>>& b,
+                      std::vector<std::complex<double>>& w,
+                      const std::vector<std::complex<double>>& sigma,
+                      const double threshold);
+
+      /**
+       * \brief Perform the pre-processing step of the generalized Lanczos process.
+       * \details Does nothing on the non-leader processes in broadcast mode.
+       * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+       */
+      void glanczos_pre(std::vector<std::complex<double>>& u);
+
+      /**
+       * \brief Perform the post-processing step of the generalized Lanczos process.
+       * \details In broadcast mode, w and u are only read on the leader, and on exit
+       *          w holds the next Lanczos vector on all processes.
+       * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+       * \param[in]     u Vector which used in `glanczos_pre()`.
+       */
+      void glanczos_pst(std::vector<std::complex<double>>& w,
+                        std::vector<std::complex<double>>& u);
+
+      /**
+       * \brief Update the approximate solutions of the local shifts and check global convergence.
+       * \param[in,out] x Solution vectors of the local shifts (size = matrix_size * local_shift_size()).
+       * \return true if the systems of all shifts on all processes have converged, false otherwise.
+       */
+      bool update(std::vector<std::complex<double>>& x);
+
+      /**
+       * \brief Retrieve converged iteration and converged residual norm of all shifts.
+       * \param[out] conv_itr Number of iterations for each shift (size = shift_size).
+       * \param[out] conv_res Final residual norms in Algorithm for each shift (size = shift_size).
+       */
+      void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+      /**
+       * \brief Retrieve current residual norms in Algorithm of all shifts.
+       * \param[out] res Residual norms in Algorithm for each shift (size = shift_size).
+       */
+      void get_residual(std::vector<double>& res) const;
+
+      /**
+       * \brief Register a callback to hand over each local solution as soon as it has converged.
+       * \details The shift index passed to the callback is the global index.
+       * \param[in] callback Function to be called (an empty function disables the callback).
+       */
+      void set_convergence_callback(Solver::ConvergenceCallback callback);
+
+      /**
+       * \brief First shift owned by this process.
+       * \return Global index of the first local shift.
+       */
+      std::size_t shift_begin() const { return shift_begin_; }
+
+      /**
+       * \brief Number of shifts owned by this process.
+       * \return Number of local shifts.
+       */
+      std::size_t local_shift_size() const { return local_shift_size_; }
+
+      /**
+       * \brief Whether this process has to perform the matrix-vector multiplication and the inner solve.
+       * \return true in redundant mode or on the leader, false otherwise.
+       */
+      bool applies_operators() const { return !broadcast_ || rank_ == leader_; }
+
+    private:
+      MPI_Comm comm_;                  ///< Communicator over which the shifts are distributed
+      int rank_;                       ///< Rank of this process
+      int leader_;                     ///< Rank of the leader in broadcast mode
+      bool broadcast_;                 ///< true for broadcast mode
+      std::size_t matrix_size_;        ///< Matrix size \f$ N \f$
+      std::size_t shift_size_;         ///< Total number of shifts \f$ M \f$
+      std::size_t shift_begin_;        ///< First local shift
+      std::size_t local_shift_size_;   ///< Number of local shifts
+      std::vector<int> counts_;        ///< Number of shifts on each process
+      std::vector<int> displs_;        ///< First shift on each process
+      Solver solver_;                  ///< Solver for the local shifts
+    };
+
+  }  // namespace mpi
+}  // namespace gsminres
+
+#endif // GSMINRES_MPI_SHIFT_SOLVER_HPP
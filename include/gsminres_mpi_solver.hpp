@@ -0,0 +1,66 @@
+/**
+ * \file gsminres_mpi_solver.hpp
+ * \brief Header file for the GSMINRES++ distributed-memory solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines `gsminres::mpi::Solver`, the MPI variant of `gsminres::Solver`.
+ *          All vectors (b, w, u, the solutions x and the internal auxiliary vectors) are
+ *          partitioned by rows, and each process only stores its own row block.
+ *          The iteration loop is the same as for `gsminres::Solver`; the matrix-vector
+ *          multiplications and the inner solves are performed on the distributed vectors,
+ *          e.g. with the routines in \ref gsminres_mpi_util.hpp "gsminres_mpi_util.hpp".
+ *
+ *          The inner products of the generalized Lanczos process are the only global
+ *          operations. They are computed locally in the same sweep as before and summed
+ *          by one `MPI_Allreduce` of a single scalar each.
+ *          The Givens rotations and the residual norms are computed redundantly
+ *          on every process, so that all processes detect convergence at the same iteration.
+ *
+ *          Available only if the library is built with `GSMINRES_ENABLE_MPI`.
+ */
+
+#ifndef GSMINRES_MPI_SOLVER_HPP
+#define GSMINRES_MPI_SOLVER_HPP
+
+#include <mpi.h>
+#include "gsminres_solver.hpp"
+
+namespace gsminres {
+  /**
+   * \namespace gsminres::mpi
+   * \brief Distributed-memory (MPI) variants of the solver and of the utilities.
+   */
+  namespace mpi {
+
+    /**
+     * \class Solver
+     * \brief Generalized shifted MINRES solver class for row-distributed vectors.
+     * \details The interface is that of `gsminres::Solver`, with matrix_size replaced by
+     *          the number of local rows. The convergence callback receives the local row block
+     *          of the solution. All processes of the communicator must call every function.
+     */
+    class Solver : public gsminres::Solver {
+    public:
+      /**
+       * \brief Constructor.
+       * \param[in] comm       Communicator over which the vectors are distributed.
+       * \param[in] local_size Number of rows owned by this process.
+       * \param[in] shift_size Number of shifts.
+       * \param[in] standard   true for the standard shifted systems (\f$ B = I \f$).
+       */
+      Solver(MPI_Comm comm, std::size_t local_size, std::size_t shift_size, bool standard = false);
+
+      /**
+       * \brief Communicator of the solver.
+       * \return Communicator passed to the constructor.
+       */
+      MPI_Comm communicator() const { return comm_; }
+
+    private:
+      MPI_Comm comm_; ///< Communicator over which the vectors are distributed
+    };
+
+  }  // namespace mpi
+}  // namespace gsminres
+
+#endif // GSMINRES_MPI_SOLVER_HPP
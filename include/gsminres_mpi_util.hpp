@@ -0,0 +1,168 @@
+/**
+ * \file gsminres_mpi_util.hpp
+ * \brief Distributed-memory utility functions and data structures for GSMINRES++.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header provides the MPI counterparts of the utilities in
+ *          \ref gsminres_util.hpp "gsminres_util.hpp": a row-distributed sparse matrix in CSR format,
+ *          sparse matrix-vector multiplication with halo exchange, inner products,
+ *          and Conjugate Gradient (CG) and Chebyshev solvers for the inner linear systems with B.
+ *
+ *          Vectors are distributed in contiguous row blocks; each process stores
+ *          the rows [row_begin, row_begin + local_size) of a vector in a `std::vector` of size local_size.
+ *
+ *          As `gsminres::util`, these functions are not used by the solver itself,
+ *          and are provided for sample programs, testing, and exploratory use.
+ *          Available only if the library is built with `GSMINRES_ENABLE_MPI`.
+ */
+
+#ifndef GSMINRES_MPI_UTIL_HPP
+#define GSMINRES_MPI_UTIL_HPP
+
+#include <mpi.h>
+#include <complex>
+#include <vector>
+#include "gsminres_util.hpp"
+
+namespace gsminres {
+  namespace mpi {
+
+    /**
+     * \struct DistCSRMat
+     * \brief Struct representing a row-distributed sparse matrix in CSR format.
+     * \details The local rows are split into the columns owned by this process (`local`,
+     *          with local column indices) and the columns owned by other processes (`ghost`,
+     *          with indices into the halo buffer). The halo is received from the owners
+     *          before the ghost part is applied, and the communication pattern is built once
+     *          by `build_dist_csr()`.
+     */
+    struct DistCSRMat {
+      MPI_Comm      comm;        ///< Communicator.
+      std::size_t   global_size; ///< Dimension of the global square matrix.
+      std::size_t   row_begin;   ///< First global row owned by this process.
+      std::size_t   local_size;  ///< Number of rows owned by this process.
+      util::CSRMat  local;       ///< Entries in the owned columns (local column indices).
+      util::CSRMat  ghost;       ///< Entries in the other columns (halo indices).
+      std::vector<int>         recv_ranks;   ///< Processes from which the halo is received.
+      std::vector<std::size_t> recv_offsets; ///< Range of the halo received from each process.
+      std::vector<int>         send_ranks;   ///< Processes to which local entries are sent.
+      std::vector<std::size_t> send_offsets; ///< Range of send_indices for each process.
+      std::vector<std::size_t> send_indices; ///< Local indices of the entries to be sent.
+      mutable std::vector<std::complex<double>> send_buffer; ///< Packed entries to be sent.
+      mutable std::vector<std::complex<double>> halo;        ///< Received entries.
+      mutable std::vector<MPI_Request>          requests;    ///< Pending requests of the exchange.
+      /**
+       * \brief Constructor for DistCSRMat (empty matrix, filled by `build_dist_csr()`).
+       * \param[in] COMM       Communicator.
+       * \param[in] LOCALSIZE  Number of rows owned by this process.
+       */
+      DistCSRMat(MPI_Comm COMM, std::size_t LOCALSIZE) :
+        comm(COMM), global_size(0), row_begin(0), local_size(LOCALSIZE),
+        local(LOCALSIZE+1, 0), ghost(LOCALSIZE+1, 0) {}
+    };
+
+    /**
+     * \brief Compute a balanced contiguous row partition.
+     * \param[in]  comm        Communicator.
+     * \param[in]  global_size Number of global rows.
+     * \param[out] row_begin   First row owned by this process.
+     * \param[out] local_size  Number of rows owned by this process.
+     */
+    void partition_rows(MPI_Comm comm, const std::size_t global_size,
+                        std::size_t& row_begin, std::size_t& local_size);
+
+    /**
+     * \brief Build a distributed matrix from the rows owned by this process.
+     * \details Collective. The row blocks of the processes must be contiguous and ordered by rank.
+     * \param[in] comm        Communicator.
+     * \param[in] global_size Dimension of the global square matrix.
+     * \param[in] row_begin   First global row owned by this process.
+     * \param[in] rows        Owned rows in CSR format with global column indices
+     *                        (`rows.matrix_size` is the number of owned rows).
+     * \return Distributed matrix.
+     */
+    DistCSRMat build_dist_csr(MPI_Comm comm, const std::size_t global_size,
+                              const std::size_t row_begin, const util::CSRMat& rows);
+
+    /**
+     * \brief Distribute a matrix available on every process with `partition_rows()`.
+     * \details Collective. Convenient for matrices read with `util::load_csr_from_csr()`.
+     * \param[in] comm Communicator.
+     * \param[in] A    Global matrix in CSR format.
+     * \return Distributed matrix.
+     */
+    DistCSRMat distribute_csr(MPI_Comm comm, const util::CSRMat& A);
+
+    /**
+     * \brief Perform distributed sparse matrix-vector multiplication: \f$ y = A x \f$.
+     * \details Collective. The owned part is multiplied while the halo exchange is in progress.
+     * \param[in]  A Distributed matrix.
+     * \param[in]  x Local rows of the input vector.
+     * \param[out] y Local rows of the output vector.
+     */
+    void spmv(const DistCSRMat&                        A,
+              const std::vector<std::complex<double>>& x,
+              std::vector<std::complex<double>>&       y);
+
+    /**
+     * \brief Compute the global inner product \f$ x^H y \f$ of distributed vectors.
+     * \param[in] comm Communicator.
+     * \param[in] x    Local rows of x.
+     * \param[in] y    Local rows of y.
+     * \return Inner product (the same on every process).
+     */
+    std::complex<double> dotc(MPI_Comm comm,
+                              const std::vector<std::complex<double>>& x,
+                              const std::vector<std::complex<double>>& y);
+
+    /**
+     * \brief Compute the global 2-norm of a distributed vector.
+     * \param[in] comm Communicator.
+     * \param[in] x    Local rows of x.
+     * \return 2-norm (the same on every process).
+     */
+    double nrm2(MPI_Comm comm, const std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Solve \f$ Ax=b \f$ using the distributed Conjugate Gradient method.
+     * \details Collective. Two scalar reductions per iteration.
+     * \param[in]  A        Coefficient matrix (distributed CSR format).
+     * \param[out] x        Local rows of the solution vector.
+     * \param[in]  b        Local rows of the right-hand side vector.
+     * \param[in]  tol      Relative residual tolerance.
+     * \param[in]  max_iter Maximum number of iterations.
+     * \return true if converged, false otherwise (the same on every process).
+     */
+    bool cg(const DistCSRMat&                        A,
+            std::vector<std::complex<double>>&       x,
+            const std::vector<std::complex<double>>& b,
+            const double tol, const std::size_t max_iter);
+
+    /**
+     * \brief Estimate the Chebyshev parameters of a distributed Hermitian positive-definite matrix.
+     * \details Collective. Distributed counterpart of `util::chebyshev_setup()`: two scalar reductions
+     *          per Lanczos step, once per matrix.
+     * \param[in] A             Coefficient matrix (distributed CSR format).
+     * \param[in] tol           Relative residual tolerance of the subsequent solves.
+     * \param[in] lanczos_steps Number of Lanczos steps (default = 20).
+     * \return Chebyshev parameters (the same on every process).
+     */
+    util::ChebyshevParam chebyshev_setup(const DistCSRMat& A, const double tol, const std::size_t lanczos_steps = 20);
+
+    /**
+     * \brief Solve \f$ Ax=b \f$ using the distributed Chebyshev iteration.
+     * \details Collective. No reduction at all: the only communication is the halo exchange of `spmv()`.
+     * \param[in]  A     Coefficient matrix (distributed CSR format).
+     * \param[in]  param Parameters from `chebyshev_setup()`.
+     * \param[out] x     Local rows of the solution vector.
+     * \param[in]  b     Local rows of the right-hand side vector.
+     */
+    void chebyshev(const DistCSRMat&                        A,
+                   const util::ChebyshevParam&              param,
+                   std::vector<std::complex<double>>&       x,
+                   const std::vector<std::complex<double>>& b);
+
+  }  // namespace mpi
+}  // namespace gsminres
+
+#endif // GSMINRES_MPI_UTIL_HPP
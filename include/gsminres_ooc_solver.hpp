@@ -0,0 +1,145 @@
+/**
+ * \file gsminres_ooc_solver.hpp
+ * \brief Header file for the GSMINRES++ out-of-core solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `OutOfCoreSolver` class, a variant of `gsminres::Solver`
+ *          whose solution vectors and auxiliary vectors are stored in memory-mapped files
+ *          (`gsminres::MappedArray`) instead of main memory.
+ *          Only a window of a few shifts is kept resident during `update()`,
+ *          so that a single generalized Lanczos run can serve a number of shifts
+ *          whose M x N arrays exceed the main memory.
+ *
+ *          Two files are created from the given prefix:
+ *          - `<prefix>.x` holds the solutions; shift m occupies elements [m*N, (m+1)*N).
+ *            It is kept after the solver is destroyed.
+ *          - `<prefix>.p` holds the auxiliary vectors (three per shift) and is deleted
+ *            by the destructor.
+ */
+
+#ifndef GSMINRES_OOC_SOLVER_HPP
+#define GSMINRES_OOC_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+#include <array>
+#include <string>
+#include "gsminres_mapped_array.hpp"
+
+namespace gsminres {
+
+  /**
+   * \class OutOfCoreSolver
+   * \brief Generalized shifted MINRES solver class with file-backed storage.
+   * \details The iteration loop is the same as for `gsminres::Solver`, except that
+   *          `update()` takes no argument; the solutions are read with `get_solution()`
+   *          or directly from the `<prefix>.x` file.
+   *
+   *          In `update()` the shifts are processed in order, and for each shift the
+   *          auxiliary vectors and the solution are updated in a single sequential sweep.
+   *          The three auxiliary vectors of a shift rotate by the iteration index,
+   *          so no vector is copied.
+   */
+  class OutOfCoreSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] shift_size  Number of shifts.
+     * \param[in] prefix      Path prefix of the backing files.
+     * \param[in] window      Number of shifts kept resident in memory (default = 4).
+     */
+    OutOfCoreSolver(std::size_t matrix_size, std::size_t shift_size,
+                    const std::string& prefix, std::size_t window = 4);
+
+    /**
+     * \brief Deconstructor.
+     * \details Unmaps the backing files and deletes the file of the auxiliary vectors.
+     */
+    ~OutOfCoreSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for iteration.
+     * \param[in]     b         Right-hand side vector (size = matrix_size).
+     * \param[in,out] w         Pre-processed right-hand side \f$ B^{-1}b \f$ (size = matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals.
+     */
+    void initialize(const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in,out] u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the approximate solutions in the backing file and check convergence.
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update();
+
+    /**
+     * \brief Copy the approximate solution of one shift into memory.
+     * \param[in]  m  Index of the shift.
+     * \param[out] xm Approximate solution \f$ x^{(m)} \f$ (size = matrix_size).
+     */
+    void get_solution(std::size_t m, std::vector<std::complex<double>>& xm) const;
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each shift (size = shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each shift (size = shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each shift (shift = shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+  private:
+    // Basic parameters
+    std::size_t iter_;                        ///< Number of iterations
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    std::size_t window_;                      ///< Number of resident shifts
+    double r0_norm_;                          ///< Norm of the initial residual norm
+    std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
+
+    // Generalized Lanczos process variables.
+    double alpha_;                 ///< alpha coeffcient
+    double beta_prev_, beta_curr_; ///< beta coefficients (previous and current)
+    std::vector<std::complex<double>> w_curr_, w_next_;          ///< Lanczos basis vectors
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary vectors
+
+    // Variables for updating the solutions
+    std::vector<std::complex<double>> T_prev2_, T_prev_, T_curr_, T_next_; ///< Elements of the tridiagonal matrix
+    std::vector<std::array<double, 3>>               Gc_; ///< Givens rotation matrixs element "c"
+    std::vector<std::array<std::complex<double>, 3>> Gs_; ///< Givens rotation matrixs element "s"
+    MappedArray x_; ///< Solutions (one slice of N per shift)
+    MappedArray p_; ///< Auxiliary vectors (one slice of 3N per shift)
+    std::vector<std::complex<double>> f_; ///< Auxiliary variables
+    std::vector<double> h_;               ///< Residual norms in Algorithm
+
+    // Convergence-related variables
+    std::size_t conv_num_;             ///< Number of systems that have converged
+    std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    double threshold_;                 ///< Relative reisudal convergence threshold
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_OOC_SOLVER_HPP
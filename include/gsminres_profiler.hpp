@@ -0,0 +1,224 @@
+/**
+ * \file gsminres_profiler.hpp
+ * \brief Per-phase timing instrumentation for GSMINRES++.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header provides a low-overhead recorder of timed phases. `Solver` records
+ *          `glanczos_pre`, `glanczos_pst`, `reorthogonalize`, `update_scalars` (Givens rotations) and
+ *          `update_vectors` with the iteration number, and the utilities record `spmv`, `spmm`, `cg`
+ *          and `block_cg`.
+ *          The records can be exported as a Chrome/Perfetto trace (`write_chrome_trace()`,
+ *          open in chrome://tracing or ui.perfetto.dev) and summarized per phase (`print_summary()`).
+ *
+ *          The instrumentation is compiled in only with `GSMINRES_ENABLE_PROFILING` defined
+ *          (CMake option of the same name, or `ENABLE_PROFILING = 1` in the Makefile); otherwise
+ *          `GSMINRES_PROFILE_SCOPE` expands to nothing. When compiled in, recording is switched on at
+ *          runtime by `enable()` or by the environment variable `GSMINRES_PROFILE=1`; while it is off,
+ *          every phase costs one relaxed atomic load. With `GSMINRES_PROFILE_OUTPUT=<file>` in addition,
+ *          the trace is written to the file and the summary to std::cerr at exit, without changes to the program.
+ *
+ *          Kernels also carry analytical byte and flop counts (`GSMINRES_PROFILE_KERNEL`): the `blas::`
+ *          vector wrappers, `spmv`, `spmm`, `glanczos_pre`, `glanczos_pst` and `apply_block` (the deferred
+ *          update of `Solver::set_update_block_size()`). A phase adds its counts
+ *          to the enclosing phase of the same thread, so that `cg` and `update_vectors` report the traffic
+ *          of the kernels they call. `print_roofline()` combines the counts with the measured times into
+ *          achieved bandwidth, arithmetic intensity and the share of the peak bandwidth (`set_peak()`,
+ *          or measured by `measure_bandwidth()`). On Linux, `GSMINRES_PROFILE_PERF=1` additionally reads
+ *          the hardware cache-miss counter (perf_event) of the recording thread around every phase.
+ *
+ *          Every thread records into its own buffer, so phases running concurrently
+ *          (e.g. `update_vectors` of `Solver::update_begin()`) are recorded on their own track.
+ *          `clear()`, `write_chrome_trace()` and `print_summary()` must not be called while phases are recorded.
+ */
+
+#ifndef GSMINRES_PROFILER_HPP
+#define GSMINRES_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace gsminres {
+  namespace profiler {
+
+    /**
+     * \struct Event
+     * \brief One recorded phase.
+     */
+    struct Event {
+      const char*   name;      ///< Name of the phase (string literal).
+      std::int64_t  iteration; ///< Iteration number (-1 if not applicable).
+      std::uint64_t begin;     ///< Start time [ns] since the first use of the profiler.
+      std::uint64_t end;       ///< End time [ns] since the first use of the profiler.
+      std::uint32_t thread;    ///< Index of the recording thread (in order of first record).
+      double        bytes;     ///< Analytical memory traffic [bytes] (including nested phases).
+      double        flops;     ///< Analytical floating-point operations (including nested phases).
+      std::uint64_t misses;    ///< Cache misses of the recording thread (perf_event; 0 if not available).
+    };
+
+    class Scope;
+
+    namespace detail {
+      /**
+       * \brief Runtime switch of the recording.
+       */
+      std::atomic<bool>& flag();
+
+      /**
+       * \brief Current time [ns] since the first use of the profiler.
+       */
+      std::uint64_t now();
+
+      /**
+       * \brief Start a phase: push it on the stack of the calling thread and read the counters.
+       */
+      void begin(Scope& scope);
+
+      /**
+       * \brief End a phase: append it to the buffer of the calling thread and pass the counts to the parent.
+       */
+      void end(Scope& scope);
+    }  // namespace detail
+
+    /**
+     * \brief Whether the recording is switched on.
+     * \return true if the phases are recorded, false otherwise.
+     */
+    inline bool enabled() {
+      return detail::flag().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Switch the recording on or off.
+     * \param[in] enable true to record the phases.
+     */
+    void enable(bool enable);
+
+    /**
+     * \brief Discard all recorded events.
+     */
+    void clear();
+
+    /**
+     * \brief Collect the recorded events of all threads.
+     * \return Events sorted by start time.
+     */
+    std::vector<Event> events();
+
+    /**
+     * \brief Write the recorded events as a Chrome trace (JSON, complete events).
+     * \param[in] filename Output file name.
+     * \return true if the file was written, false otherwise.
+     */
+    bool write_chrome_trace(const std::string& filename);
+
+    /**
+     * \brief Print the number of calls, total, mean and maximum time of every phase.
+     * \details The share is relative to the wall time from the first to the last event.
+     *          Nested phases (e.g. `spmv` inside `cg`) are counted in both.
+     * \param[in] os Output stream (default = std::cout).
+     */
+    void print_summary(std::ostream& os = std::cout);
+
+    /**
+     * \brief Set the peak performance of the machine for `print_roofline()`.
+     * \param[in] bandwidth Peak memory bandwidth [GB/s].
+     * \param[in] gflops    Peak floating-point performance [GFLOP/s] (0 if unknown).
+     */
+    void set_peak(double bandwidth, double gflops = 0.0);
+
+    /**
+     * \brief Measure the memory bandwidth with a STREAM-like triad over all OpenMP threads.
+     * \param[in] size Length of each of the three arrays of doubles (default = 2^23, i.e. 64 MiB).
+     * \return Best bandwidth of several repetitions [GB/s].
+     */
+    double measure_bandwidth(std::size_t size = std::size_t(1) << 23);
+
+    /**
+     * \brief Print the roofline summary of the phases with byte counts.
+     * \details For every phase: achieved bandwidth and flop rate, arithmetic intensity (flop/byte),
+     *          the share of the peak bandwidth, and the attainable rate \f$ \min(P, I \cdot \beta) \f$ if the
+     *          peak flop rate P is known. If the peak bandwidth has not been set, it is measured first.
+     *          The peak is that of the main memory, so kernels whose vectors stay in cache exceed 100%.
+     *          With perf_event counters, the traffic implied by the cache misses (64 bytes each) is also printed;
+     *          it covers the recording thread only, so it is meaningful for single-threaded runs.
+     * \param[in] os Output stream (default = std::cout).
+     */
+    void print_roofline(std::ostream& os = std::cout);
+
+    /**
+     * \class Scope
+     * \brief Records the lifetime of the object as one phase (if the recording is on at construction).
+     */
+    class Scope {
+    public:
+      /**
+       * \brief Start the phase.
+       * \param[in] name      Name of the phase (must outlive the profiler, e.g. a string literal).
+       * \param[in] iteration Iteration number (-1 if not applicable).
+       * \param[in] bytes     Analytical memory traffic of the phase itself [bytes].
+       * \param[in] flops     Analytical floating-point operations of the phase itself.
+       */
+      explicit Scope(const char* name, std::int64_t iteration = -1, double bytes = 0.0, double flops = 0.0)
+        : name_(name), iteration_(iteration), bytes_(bytes), flops_(flops), active_(enabled()),
+          parent_(nullptr), begin_(0), misses_(0) {
+        if (active_) {
+          detail::begin(*this);
+        }
+      }
+
+      /**
+       * \brief End the phase.
+       */
+      ~Scope() {
+        if (active_) {
+          detail::end(*this);
+        }
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+    private:
+      friend void detail::begin(Scope& scope);
+      friend void detail::end(Scope& scope);
+
+      const char*   name_;      ///< Name of the phase
+      std::int64_t  iteration_; ///< Iteration number
+      double        bytes_;     ///< Memory traffic (own and nested)
+      double        flops_;     ///< Floating-point operations (own and nested)
+      bool          active_;    ///< Whether the phase is recorded
+      Scope*        parent_;    ///< Enclosing phase of the same thread
+      std::uint64_t begin_;     ///< Start time [ns]
+      std::uint64_t misses_;    ///< Cache-miss counter at the start
+    };
+
+  }  // namespace profiler
+}  // namespace gsminres
+
+#define GSMINRES_PROFILE_CONCAT_(a, b) a##b
+#define GSMINRES_PROFILE_CONCAT(a, b) GSMINRES_PROFILE_CONCAT_(a, b)
+
+/**
+ * \def GSMINRES_PROFILE_SCOPE(name, iteration)
+ * \brief Record the rest of the enclosing block as a phase (nothing without `GSMINRES_ENABLE_PROFILING`).
+ */
+/**
+ * \def GSMINRES_PROFILE_KERNEL(name, iteration, bytes, flops)
+ * \brief Same as `GSMINRES_PROFILE_SCOPE` with analytical byte and flop counts (not evaluated when disabled).
+ */
+#ifdef GSMINRES_ENABLE_PROFILING
+#define GSMINRES_PROFILE_SCOPE(name, iteration) \
+  ::gsminres::profiler::Scope GSMINRES_PROFILE_CONCAT(gsminres_profile_scope_, __LINE__)(name, static_cast<std::int64_t>(iteration))
+#define GSMINRES_PROFILE_KERNEL(name, iteration, bytes, flops) \
+  ::gsminres::profiler::Scope GSMINRES_PROFILE_CONCAT(gsminres_profile_scope_, __LINE__)(name, static_cast<std::int64_t>(iteration), \
+                                                                                        static_cast<double>(bytes), static_cast<double>(flops))
+#else
+#define GSMINRES_PROFILE_SCOPE(name, iteration) ((void)0)
+#define GSMINRES_PROFILE_KERNEL(name, iteration, bytes, flops) ((void)0)
+#endif
+
+#endif // GSMINRES_PROFILER_HPP
@@ -0,0 +1,138 @@
+/**
+ * \file gsminres_projected_solver.hpp
+ * \brief Header file for the GSMINRES++ projected-output solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `ProjectedSolver` class, which computes only
+ *          the projections of the solutions of the generalized shifted linear systems
+ *          \f[
+ *            z_k^{(m)} = c_k^H x^{(m)} = c_k^H (A + \sigma^{(m)} B)^{-1} b,
+ *            \quad (m = 1, \dots, M,\ k = 1, \dots, K)
+ *          \f]
+ *          for K projection vectors \f$ c_k \f$ given in advance
+ *          (e.g. elements of Green's functions).
+ *          The solution vectors and the per-shift auxiliary vectors are never formed;
+ *          only their projections are updated, so that the memory and the work
+ *          of the solution part are O(K N + K M) instead of O(M N).
+ *
+ *          The projection vectors are stored column by column,
+ *          i.e. \f$ c_k \f$ occupies the range [k*N, (k+1)*N).
+ *          The projections are stored as z[k*M + m].
+ */
+
+#ifndef GSMINRES_PROJECTED_SOLVER_HPP
+#define GSMINRES_PROJECTED_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+#include <array>
+
+namespace gsminres {
+
+  /**
+   * \class ProjectedSolver
+   * \brief Generalized shifted MINRES solver class with projected outputs.
+   * \details The iteration loop is the same as for `gsminres::Solver`,
+   *          except that `update()` receives the projections instead of the solutions.
+   *          The convergence is judged by the residual norms of the full systems.
+   */
+  class ProjectedSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size     Matrix size.
+     * \param[in] shift_size      Number of shifts.
+     * \param[in] projection_size Number of projection vectors.
+     */
+    ProjectedSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t projection_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~ProjectedSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for iteration.
+     * \param[out]    z         Projections of the approximate solutions (size = projection_size * shift_size).
+     * \param[in]     c         Projection vectors (size = projection_size * matrix_size).
+     * \param[in]     b         Right-hand side vector (size = matrix_size).
+     * \param[in,out] w         Pre-processed right-hand side \f$ B^{-1}b \f$ (size = matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals.
+     */
+    void initialize(std::vector<std::complex<double>>& z,
+                    const std::vector<std::complex<double>>& c,
+                    const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in,out] u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the projections of the approximate solutions and check convergence.
+     * \param[in,out] z Projections to be updated (size = projection_size * shift_size).
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update(std::vector<std::complex<double>>& z);
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each shift (size = shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each shift (size = shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each shift (shift = shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+  private:
+    // Basic parameters
+    std::size_t iter_;                        ///< Number of iterations
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    std::size_t projection_size_;             ///< Number of projection vectors \f$ K \f$
+    double r0_norm_;                          ///< Norm of the initial residual norm
+    std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
+    std::vector<std::complex<double>> c_;     ///< Projection vectors (projection*matrix)
+
+    // Generalized Lanczos process variables.
+    double alpha_;                 ///< alpha coeffcient
+    double beta_prev_, beta_curr_; ///< beta coefficients (previous and current)
+    std::vector<std::complex<double>> w_curr_, w_next_;          ///< Lanczos basis vectors
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary vectors
+    std::vector<std::complex<double>> cw_; ///< Projections of the current Lanczos vector \f$ c_k^H w \f$
+
+    // Variables for updating the projections
+    std::vector<std::complex<double>> T_prev2_, T_prev_, T_curr_, T_next_; ///< Elements of the tridiagonal matrix
+    std::vector<std::array<double, 3>>               Gc_; ///< Givens rotation matrixs element "c"
+    std::vector<std::array<std::complex<double>, 3>> Gs_; ///< Givens rotation matrixs element "s"
+    std::vector<std::complex<double>> q_prev2_, q_prev_, q_curr_; ///< Projections of the auxiliary vectors (shift*projection)
+    std::vector<std::complex<double>> f_; ///< Auxiliary variables
+    std::vector<double> h_;               ///< Residual norms in Algorithm
+
+    // Convergence-related variables
+    std::size_t conv_num_;             ///< Number of systems that have converged
+    std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    double threshold_;                 ///< Relative reisudal convergence threshold
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_PROJECTED_SOLVER_HPP
@@ -19,6 +19,12 @@
 #include <complex>
 #include <vector>
 #include <array>
+#include <string>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 /**
  * \namespace gsminres
@@ -43,16 +49,21 @@ namespace gsminres {
   public:
     /**
      * @brief Constructor.
+     * @details In the standard mode (\f$ B = I \f$), the auxiliary Lanczos vectors
+     *          \f$ u = Bw \f$ are identical to the Lanczos vectors and are not stored,
+     *          and `glanczos()` can be used in place of `glanczos_pre()` and `glanczos_pst()`.
      * @param[in] matrix_size Matrix size.
      * @param[in] shift_size  Number of shifts.
+     * @param[in] standard    true for the standard shifted systems \f$ (A + \sigma^{(m)} I)x^{(m)} = b \f$.
      */
-    Solver(std::size_t matrix_size, std::size_t shift_size);
+    Solver(std::size_t matrix_size, std::size_t shift_size, bool standard = false);
 
     /**
      * @brief Deconstructor.
-     * @details Default destructor. No manual cleanup required.
+     * @details Waits for a pending update and checkpoint, and joins the update threads.
+     *          Convergence callbacks of a pending update are not called.
      */
-    ~Solver() = default;
+    ~Solver();
 
     /**
      * \brief Initialize the solver with input data and prepare for iteration.
@@ -76,19 +87,181 @@ namespace gsminres {
 
     /**
      * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \details w is normalized in place for the next matrix-vector multiplication.
+     *          u is only read; the normalized u is kept inside the solver.
      * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
-     * \param[in,out] u Vector which used in `glanczos_pre()`.
+     * \param[in]     u Vector which used in `glanczos_pre()`.
      */
     void glanczos_pst(std::vector<std::complex<double>>& w,
                       std::vector<std::complex<double>>& u);
 
+    /**
+     * \brief Perform one step of the Lanczos process in the standard mode (\f$ B = I \f$).
+     * \details Replaces the sequence `glanczos_pre(v)`, copy of v to w, `glanczos_pst(w, v)`,
+     *          using the Euclidean inner product and three sweeps over the vectors.
+     *          Exits the program if the solver was not constructed in the standard mode.
+     * \param[in,out] v On input \f$ Aw \f$, on output the next Lanczos vector \f$ w \f$.
+     */
+    void glanczos(std::vector<std::complex<double>>& v);
+
+    /**
+     * \brief Take over one step of the Lanczos process computed by another solver instance.
+     * \details Replaces `glanczos_pre()` and `glanczos_pst()` when the same Lanczos process
+     *          is run elsewhere (e.g. on another process) for other shifts.
+     *          `update()` needs only the Lanczos vectors w, so u is not required.
+     * \param[in] alpha Diagonal coefficient of the step.
+     * \param[in] beta  Off-diagonal coefficient of the step.
+     * \param[in] w      Next Lanczos vector (size >= offset + matrix_size).
+     * \param[in] offset Starting index of the vector within w (default = 0).
+     */
+    void glanczos_set(const double alpha, const double beta,
+                      const std::vector<std::complex<double>>& w, std::size_t offset = 0);
+
+    /**
+     * \brief Retrieve the coefficients of the latest step of the Lanczos process.
+     * \param[out] alpha Diagonal coefficient.
+     * \param[out] beta  Off-diagonal coefficient.
+     */
+    void get_lanczos(double& alpha, double& beta) const;
+
     /**
      * \bried Update the approximate solutions and check convergence.
      * \param[in,out] x Solution vectors to be updated (size = matrix_size * shift_size)
-     * \return true if all systems have converged, false otherwise.
+     * \return true if all systems have converged or stalled (see `set_reorthogonalization()`), false otherwise.
      */
     bool update(std::vector<std::complex<double>>& x);
 
+    /**
+     * \brief Start the update of the approximate solutions asynchronously.
+     * \details The Givens rotations and the convergence check are done immediately,
+     *          and the Lanczos vectors are advanced, so that the next `glanczos_pre()`,
+     *          matrix-vector multiplication and inner solve can be called right away.
+     *          The O(M N) update of the auxiliary vectors and of x runs on the update threads
+     *          (see `set_update_threads()`), which split the shifts among them,
+     *          until `update_wait()` is called. x must not be accessed before that.
+     *          The threads are created by the first call and kept until the solver is destroyed.
+     *          Convergence callbacks are called from `update_wait()`.
+     * \param[in,out] x Solution vectors to be updated (size = matrix_size * shift_size)
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update_begin(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Wait for the update started by `update_begin()`.
+     * \details Does nothing if no update is pending. `update()` and `update_begin()`
+     *          call this function first, so it is needed only before accessing x.
+     */
+    void update_wait();
+
+    /**
+     * \brief Apply all deferred updates to the approximate solutions.
+     * \details Needed only with `set_update_block_size()` greater than 1, when the iteration
+     *          is stopped before all systems have converged. `update()` flushes automatically
+     *          when it returns true.
+     * \param[in,out] x Solution vectors to be updated (size = matrix_size * shift_size)
+     */
+    void flush(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Set the number of iterations whose solution updates are deferred and applied together.
+     * \details With s > 1, `update()` only buffers the Lanczos vector and the scalar coefficients,
+     *          and every s iterations applies them as a small dense (s+2) x 3 transformation per shift.
+     *          This replaces 4s vector operations per shift by one blocked sweep over
+     *          the auxiliary vectors and x, reusing the buffered Lanczos vectors for all shifts.
+     *          The s buffered Lanczos vectors (s matrix_size elements) are allocated, and the third auxiliary
+     *          vector of every shift, which the blocked update does not use, is released, so the auxiliary
+     *          storage is (2 shift_size + s) matrix_size elements instead of 3 shift_size matrix_size.
+     *          The convergence check is not delayed, but x (and the convergence callback) is updated only
+     *          at the end of each block.
+     *          Call this function before the iteration starts.
+     * \param[in] s Block size (default = 1, i.e. no deferral).
+     */
+    void set_update_block_size(std::size_t s);
+
+    /**
+     * \brief Set the number of threads of `update_begin()`.
+     * \details Each thread updates the auxiliary vectors and the solutions of every n-th shift,
+     *          so the result does not depend on n. With `set_update_block_size()` greater than 1,
+     *          the block update is done by one of them (it is parallelized with OpenMP).
+     *          The threads run concurrently with the caller, so n should leave cores
+     *          for the matrix-vector multiplication and the inner solve.
+     * \param[in] n Number of threads (default = 0: half of the hardware threads, at most the number of shifts).
+     */
+    void set_update_threads(std::size_t n);
+
+    /**
+     * \brief Enable partial reorthogonalization of the Lanczos vectors.
+     * \details The three-term recurrence gradually loses the B-orthogonality of the Lanczos vectors,
+     *          which delays the convergence (plateaus of the residual norms) for ill-conditioned pencils.
+     *          When enabled, the loss of orthogonality is estimated by the \f$ \omega \f$-recurrence
+     *          from the Lanczos coefficients only. When the estimate exceeds \f$ \sqrt{\epsilon} \f$,
+     *          the new Lanczos vector and the following one are B-orthogonalized against the previous
+     *          Lanczos vectors whose estimate exceeds \f$ \epsilon^{3/4} \f$.
+     *          All Lanczos vectors (and \f$ Bw \f$ except in the standard mode) are stored, i.e.
+     *          2 matrix_size additional elements per iteration. Call this function before `initialize()`.
+     *          The Gram-Schmidt coefficients are not part of the tridiagonal matrix, and the residual
+     *          they leave in x is not seen by the residual norms in Algorithm. The solver therefore tracks
+     *          the coordinates of x along the affected Lanczos vectors (a few scalars per reorthogonalization
+     *          and shift). A shift converges when the residual in Algorithm plus this loss is below the threshold.
+     *          The loss is about \f$ \sqrt{\epsilon} \|x^{(m)}\|_B \f$ and is not reduced by further iterations,
+     *          so this mode cannot reach true relative residuals below about \f$ \sqrt{\epsilon} \|x^{(m)}\|_B / \|b\|_{B^{-1}} \f$.
+     *          When the loss exceeds the threshold and the residual in Algorithm has dropped below it,
+     *          the shift is stalled instead: it is no longer iterated and its auxiliary vectors are released,
+     *          but it does not count as converged (its iteration count in `finalize()` is 0, and the convergence
+     *          callback is not called); `get_stalled()` returns the iteration. The residual norm reported by
+     *          `finalize()` includes the loss. Use it for pencils on which the plain process stagnates
+     *          at a level above the loss, not for high accuracy.
+     * \param[in] enable true to enable (default = false).
+     */
+    void set_reorthogonalization(bool enable);
+
+    /**
+     * \brief Number of Lanczos vectors that have been reorthogonalized.
+     * \return Number of reorthogonalizations since `initialize()`.
+     */
+    std::size_t get_reorthogonalization_count() const;
+
+    /**
+     * \brief Retrieve the shifts that stalled at the loss of the partial reorthogonalization.
+     * \details See `set_reorthogonalization()`. Their solutions are final, but their true relative residuals
+     *          (the residual norms of `finalize()`) are above the threshold.
+     * \param[out] stalled Iteration at which each shift stalled (0 if not stalled, size = shift_size).
+     */
+    void get_stalled(std::vector<std::size_t>& stalled) const;
+
+    /**
+     * \brief Retrieve the tridiagonal matrix of the generalized Lanczos process.
+     * \details The coefficients of every iteration since `initialize()` are recorded
+     *          (two doubles per iteration). \f$ T_k \f$ is the projection of \f$ B^{-1}A \f$
+     *          onto the Krylov subspace, i.e. its eigenvalues approximate those of the pencil (A, B).
+     * \param[out] alpha Diagonal elements \f$ \alpha_1, \dots, \alpha_k \f$.
+     * \param[out] beta  Subdiagonal elements \f$ \beta_2, \dots, \beta_{k+1} \f$ (the last one couples
+     *                   \f$ T_k \f$ with the next Lanczos vector).
+     */
+    void get_tridiagonal(std::vector<double>& alpha, std::vector<double>& beta) const;
+
+    /**
+     * \brief Compute the Ritz values of the pencil (A, B).
+     * \details Eigenvalues of \f$ T_k \f$ by `dsterf` (\f$ O(k^2) \f$ flops, no vector operation).
+     *          The extreme Ritz values converge first and give inner bounds of the spectrum of the pencil;
+     *          the eigenvalues of \f$ A + \sigma B \f$ (relative to B) are those of the pencil plus \f$ \sigma \f$.
+     * \param[out] ritz Ritz values in ascending order (size = number of iterations).
+     */
+    void get_ritz_values(std::vector<double>& ritz) const;
+
+    /**
+     * \brief Predict the number of iterations to convergence for each shift.
+     * \details The spectrum of the pencil is approximated by the interval [a, b] of the extreme
+     *          Ritz values, and the residual norm of each unconverged shift is extrapolated from its
+     *          current value with the asymptotic convergence factor of polynomials on [a, b] normalized
+     *          at \f$ -\sigma^{(m)} \f$. The prediction is optimistic while the extreme Ritz values
+     *          have not converged, and is most meaningful after a few tens of iterations.
+     * \param[out] itr Predicted total number of iterations for each shift (size = shift_size).
+     *                 The converged iteration for converged shifts, and 0 for stalled shifts and when \f$ -\sigma^{(m)} \f$
+     *                 lies inside [a, b] (indefinite shifted system, no prediction).
+     */
+    void predict_iterations(std::vector<std::size_t>& itr) const;
+
     /**
      * \brief Retrieve converged iteration and converged residual norm.
      * \details This function does not finalize or delete the solver instance.
@@ -105,11 +278,322 @@ namespace gsminres {
      */
     void get_residual(std::vector<double>& res) const;
 
+    /**
+     * \brief Read-only access to the current residual norms in Algorithm without copying.
+     * \details The reference stays valid for the lifetime of the solver; the values change in `update()`.
+     * \return Residual norms for each shift (size = shift_size).
+     */
+    const std::vector<double>& get_residual_view() const;
+
+    /**
+     * \struct HistoryView
+     * \brief Read-only view of the recorded residual history (no copy).
+     * \details Record k (0 = oldest retained) holds the relative residual norms in Algorithm
+     *          \f$ h^{(m)}/\|r_0\| \f$ of all shifts after iteration `iteration(k)`. The view is invalidated
+     *          by the next `update()`, `initialize()` or `set_history()`.
+     */
+    struct HistoryView {
+      const double*      residual;   ///< Ring buffer of the records (capacity x shift_size)
+      const std::size_t* iterations; ///< Ring buffer of the iteration numbers (capacity)
+      std::size_t        capacity;   ///< Number of records the buffer can hold
+      std::size_t        first;      ///< Position of the oldest retained record
+      std::size_t        count;      ///< Number of retained records
+      std::size_t        shift_size; ///< Number of shifts
+      /**
+       * \brief Number of retained records.
+       */
+      std::size_t size() const { return count; }
+      /**
+       * \brief Iteration number of record k.
+       */
+      std::size_t iteration(std::size_t k) const { return iterations[(first+k)%capacity]; }
+      /**
+       * \brief Relative residual norm of shift m in record k.
+       */
+      double operator()(std::size_t k, std::size_t m) const { return residual[((first+k)%capacity)*shift_size + m]; }
+    };
+
+    /**
+     * \struct ShiftDiagnostics
+     * \brief Convergence diagnostics of one shift, computed from the recorded history.
+     */
+    struct ShiftDiagnostics {
+      std::size_t converged;      ///< Converged iteration (0 if not converged)
+      double      residual;       ///< Latest relative residual norm in Algorithm
+      double      rate;           ///< Mean reduction factor of the residual norm per iteration over the retained records
+      std::size_t plateau_begin;  ///< First iteration of the longest plateau
+      std::size_t plateau_length; ///< Length of the longest plateau [iterations]
+    };
+
+    /**
+     * \brief Record the residual history in a preallocated ring buffer.
+     * \details The relative residual norms of all shifts are stored every `stride` iterations and at the
+     *          iterations in which a shift converges, with no allocation and O(M) work per record;
+     *          once `capacity` records are stored, the oldest ones are overwritten.
+     *          The history replaces calls of `get_residual()` in the iteration loop; read it with
+     *          `get_history()`, `get_diagnostics()` or `write_history()`. If `output` is given,
+     *          `finalize()` writes the history to it (binary if the name ends with ".bin", CSV otherwise)
+     *          and the diagnostics to `output` + ".diag.csv". Call this function before `initialize()`.
+     * \param[in] capacity Number of records (0 = disabled, default).
+     * \param[in] stride   Record every stride-th iteration (thinning, default = 1).
+     * \param[in] output   File written by `finalize()` (default = none).
+     */
+    void set_history(std::size_t capacity, std::size_t stride = 1, const std::string& output = "");
+
+    /**
+     * \brief Zero-copy view of the recorded residual history.
+     * \return View of the retained records (empty if the history is disabled).
+     */
+    HistoryView get_history() const;
+
+    /**
+     * \brief Per-shift convergence and stagnation diagnostics from the recorded history.
+     * \details The residual norms in Algorithm do not increase, so a plateau is a range of iterations in which
+     *          the norm decreases by less than the factor `reduction`; the longest one (up to convergence) is reported.
+     * \param[out] diag      Diagnostics for each shift (size = shift_size).
+     * \param[in]  reduction Reduction factor that ends a plateau (default = 0.5).
+     */
+    void get_diagnostics(std::vector<ShiftDiagnostics>& diag, double reduction = 0.5) const;
+
+    /**
+     * \brief Write the recorded residual history.
+     * \details CSV: a header `iteration,shift_0,...` and one line per record.
+     *          Binary (little-endian host order): "GSMH", shift_size and the number of records as uint64,
+     *          then per record the iteration (uint64) and shift_size doubles.
+     * \param[in] filename Output file name.
+     * \param[in] binary   true for the binary format (default = false, CSV).
+     * \return true if the file was written, false otherwise.
+     */
+    bool write_history(const std::string& filename, bool binary = false) const;
+
+    /**
+     * \brief Write the diagnostics of `get_diagnostics()` as CSV.
+     * \details Columns: shift, sigma_re, sigma_im, converged, residual, rate, plateau_begin, plateau_length.
+     * \param[in] filename Output file name.
+     * \return true if the file was written, false otherwise.
+     */
+    bool write_diagnostics(const std::string& filename) const;
+
+    /**
+     * \brief Enable the periodic audit of the true residuals.
+     * \details The residual norms in Algorithm are computed by the recurrence and may drift from the true
+     *          residuals \f$ \|b - (A + \sigma^{(m)} B)x^{(m)}\| \f$ in finite precision. The solver does not know
+     *          A and B, so the audit is done by the caller: when `audit_due()` returns true after `update()`,
+     *          compute the true relative residuals of the returned shifts in one batched pass
+     *          (e.g. `util::shifted_residuals()`, which reads A and B once for all shifts) and pass them to `audit()`.
+     *          A shift is flagged when its true relative residual exceeds `drift` times the larger of its
+     *          relative residual in Algorithm and the threshold. The two are measured in different norms
+     *          (2-norm and \f$ B^{-1} \f$-norm), so `drift` should leave room for the conditioning of B.
+     * \param[in] interval Audit every interval iterations, and whenever shifts have converged (0 = at convergence only).
+     * \param[in] drift    Factor above which a shift is flagged (default = 100).
+     * \param[in] stop     true to stop iterating flagged shifts that have not converged (default = false).
+     */
+    void set_audit(std::size_t interval, double drift = 100.0, bool stop = false);
+
+    /**
+     * \brief Whether an audit is due.
+     * \details Waits for an update started by `update_begin()` first (see `update_wait()`), so that x is up to date
+     *          when this function returns true. Never due while deferred updates are buffered
+     *          (`set_update_block_size()`), since x is updated only at the end of each block.
+     * \param[out] shifts Shifts to be audited: the unconverged ones and those converged since the last audit.
+     * \return true if the true residuals of `shifts` should be computed and passed to `audit()`.
+     */
+    bool audit_due(std::vector<std::size_t>& shifts);
+
+    /**
+     * \brief Compare the true residuals with the residuals in Algorithm and flag drifting shifts.
+     * \details With `stop`, a flagged unconverged shift is treated as converged from now on
+     *          (its iteration count in `finalize()` is the audit iteration): its auxiliary vectors are released and
+     *          the convergence callback is called with its x as for a converged shift. Its x can be refined by a new
+     *          solve of the residual equation. If all shifts are then converged, the next `update()` returns true.
+     * \param[in]     shifts   Shifts returned by `audit_due()`.
+     * \param[in]     true_res True relative residual norms \f$ \|b - (A + \sigma^{(m)} B)x^{(m)}\|/\|b\| \f$ (size = shifts.size()).
+     * \param[in,out] x        Solution vectors passed to the convergence callback (size = matrix_size * shift_size).
+     * \return Number of newly flagged shifts.
+     */
+    std::size_t audit(const std::vector<std::size_t>& shifts, const std::vector<double>& true_res,
+                      std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Retrieve the results of the audits.
+     * \param[out] true_res Latest audited true relative residual norm for each shift (-1 if never audited).
+     * \param[out] flagged  Iteration at which each shift was flagged (0 if not flagged).
+     */
+    void get_audit(std::vector<double>& true_res, std::vector<std::size_t>& flagged) const;
+
+    /**
+     * \brief Start writing a checkpoint of the complete solver state and of x asynchronously.
+     * \details Call between `update()` and the next `glanczos_pre()`. The O(N) part of the state (iteration
+     *          counter, Lanczos coefficients and vectors, Givens rotations, f, h, convergence flags, deferred
+     *          updates, recorded tridiagonal matrix, reorthogonalization, history and audit state) is copied
+     *          into a compact binary image, and a worker thread writes the image followed by the auxiliary
+     *          vectors of the unconverged shifts and x, directly from the live buffers, while the iteration
+     *          continues. `update()`, `update_begin()`, `flush()`, `audit()` and `initialize()` wait for
+     *          the write before modifying them, so x must be kept alive and unchanged until then. The file is written to
+     *          `filename` + ".tmp" first and renamed at the end, so an interrupted write leaves the previous
+     *          checkpoint intact. A previous checkpoint still being written is waited for first.
+     *          Callbacks and the reduction are not part of the state.
+     * \param[in] filename Output file name.
+     * \param[in] x        Solution vectors (size = matrix_size * shift_size).
+     */
+    void checkpoint_begin(const std::string& filename, const std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Wait for the checkpoint started by `checkpoint_begin()`.
+     * \return true if the checkpoint was written (or none is pending), false otherwise.
+     */
+    bool checkpoint_wait();
+
+    /**
+     * \brief Write a checkpoint and wait for it (`checkpoint_begin()` followed by `checkpoint_wait()`).
+     * \param[in] filename Output file name.
+     * \param[in] x        Solution vectors (size = matrix_size * shift_size).
+     * \return true if the checkpoint was written, false otherwise.
+     */
+    bool checkpoint(const std::string& filename, const std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Restore the solver state and x from a checkpoint.
+     * \details Replaces `initialize()`: the solver must have been constructed with the same matrix size,
+     *          number of shifts and mode. The iteration continues with the multiplication \f$ Aw \f$ of the
+     *          returned w, and with the same number of threads (and processes) it reproduces the uninterrupted
+     *          run bit for bit. Register the callbacks and the reduction again before continuing.
+     *          If false is returned, the solver state is undefined until the next `initialize()` or `restore()`.
+     * \param[in]  filename Checkpoint file written by `checkpoint_begin()`.
+     * \param[out] x        Solution vectors (size = matrix_size * shift_size).
+     * \param[out] w        Lanczos vector for the next iteration (size = matrix_size).
+     * \return true if the state was restored, false otherwise.
+     */
+    bool restore(const std::string& filename, std::vector<std::complex<double>>& x,
+                 std::vector<std::complex<double>>& w);
+
+    /**
+     * \brief Number of completed iterations.
+     * \return Number of `update()` calls since `initialize()` (restored by `restore()`).
+     */
+    std::size_t get_iteration() const;
+
+    /**
+     * \brief Callback type called when a shifted system has converged.
+     * \details The arguments are the index of the shift, a pointer to its final solution
+     *          \f$ x^{(m)} \f$ inside the solution vectors passed to `update()`, and the matrix size.
+     */
+    using ConvergenceCallback = std::function<void(std::size_t shift,
+                                                   const std::complex<double>* xm,
+                                                   std::size_t n)>;
+
+    /**
+     * \brief Register a callback to hand over each solution as soon as it has converged.
+     * \details The callback is called from `update()` right after the convergence of the shift
+     *          is detected, so that post-processing (e.g. writing to a file) can overlap with
+     *          the remaining iterations. The slice of the solution vectors is not modified afterwards.
+     *          The auxiliary vectors of a converged shift are released regardless of the callback.
+     * \param[in] callback Function to be called (an empty function disables the callback).
+     */
+    void set_convergence_callback(ConvergenceCallback callback);
+
+    /**
+     * \brief Function type that sums the given values over all processes in place.
+     */
+    using Reduction = std::function<void(double* values, std::size_t count)>;
+
+    /**
+     * \brief Register a global reduction for the inner products.
+     * \details For distributed-memory use every process holds a row block of all vectors,
+     *          matrix_size being the local number of rows, and the local parts of the inner
+     *          products are summed by this function. It is called once in `initialize()`,
+     *          once in each of `glanczos_pre()` and `glanczos_pst()`, and twice in `glanczos()`.
+     *          All other operations are row-local.
+     * \param[in] reduction Function to be called (an empty function means a single process).
+     */
+    void set_reduction(Reduction reduction);
+
   private:
+    /**
+     * \brief Sum a local partial inner product over all processes.
+     * \param[in] value Local value.
+     * \return Global value.
+     */
+    double allsum(double value) const;
+
+    /**
+     * \brief Scalar part of the update: Givens rotations, residual norms and convergence check.
+     * \details Records the coefficients for `update_vectors()` and advances the Lanczos vectors.
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update_scalars();
+
+    /**
+     * \brief Vector part of the update: auxiliary vectors and approximate solutions.
+     * \param[in,out] x     Solution vectors to be updated.
+     * \param[in]     part  Index of this part: the shifts part, part+parts, ... are updated.
+     * \param[in]     parts Number of parts.
+     */
+    void update_vectors(std::vector<std::complex<double>>& x, std::size_t part = 0, std::size_t parts = 1);
+
+    /**
+     * \brief Body of an update thread: run its part of `update_vectors()` for every posted update.
+     * \param[in] part  Index of the thread.
+     * \param[in] parts Number of threads.
+     * \param[in] seen  Update generation at the creation of the thread.
+     */
+    void update_loop(std::size_t part, std::size_t parts, std::size_t seen);
+
+    /**
+     * \brief Wait for the update threads to finish and join them.
+     */
+    void stop_workers();
+
+    /**
+     * \brief Release the auxiliary vectors of newly converged shifts and call the callback.
+     * \param[in] x Solution vectors.
+     */
+    void release_converged(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Apply the deferred updates of the current block.
+     * \param[in,out] x Solution vectors to be updated.
+     */
+    void apply_block(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Update the orthogonality estimates, and reorthogonalize the new Lanczos vector if needed.
+     * \details Called at the end of the generalized Lanczos step. Stores the new Lanczos vector.
+     * \param[in,out] w New Lanczos vector passed back to the caller.
+     */
+    void reorthogonalize(std::vector<std::complex<double>>& w);
+
+    /**
+     * \brief Norm of the residual left by the discarded reorthogonalization coefficients.
+     * \param[in] m Shift index.
+     * \return \f$ \|C y^{(m)}\| \f$, where C holds the coefficients and \f$ y^{(m)} \f$ the coordinates of \f$ x^{(m)} \f$.
+     */
+    double reorth_loss(std::size_t m) const;
+
+    /**
+     * \brief Store the relative residual norms of the current iteration in the history.
+     */
+    void record_history();
+
+    /**
+     * \brief Pass the iteration state except the auxiliary vectors to the archive (checkpoint and restore).
+     * \details The archive is called with references to scalars, vectors and strings in a fixed order.
+     * \param[in,out] ar Archive that measures, writes or reads the state.
+     */
+    template <typename Archive>
+    void transfer(Archive& ar);
+
+    /**
+     * \brief Wait until a pending checkpoint has stopped reading x and the auxiliary vectors.
+     * \details Unlike `checkpoint_wait()`, the result of the write is kept for `checkpoint_wait()`.
+     */
+    void checkpoint_sync();
+
     // Basic parameters
     std::size_t iter_;                        ///< Number of iterations
     std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
     std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    bool standard_;                           ///< Standard mode (\f$ B = I \f$)
     double r0_norm_;                          ///< Norm of the initial residual norm
     std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
 
@@ -117,7 +601,7 @@ namespace gsminres {
     double alpha_;                 ///< alpha coeffcient
     double beta_prev_, beta_curr_; ///< beta coefficients (previous and current)
     std::vector<std::complex<double>> w_prev_, w_curr_, w_next_; ///< Lanczos basis vectors
-    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary vectors
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary vectors (empty in the standard mode)
 
     // Variables for updating the solutions
     /**
@@ -130,14 +614,75 @@ namespace gsminres {
     std::vector<std::complex<double>> T_prev2_, T_prev_, T_curr_, T_next_;
     std::vector<std::array<double, 3>>               Gc_; ///< Givens rotation matrixs element "c"
     std::vector<std::array<std::complex<double>, 3>> Gs_; ///< Givens rotation matrixs element "s"
-    std::vector<std::complex<double>> p_prev2_, p_prev_, p_curr_; ///< Auxiliary vectors (shift*matrix)
+    std::vector<std::vector<std::complex<double>>> p_prev2_, p_prev_, p_curr_; ///< Auxiliary vectors (one per shift, released on convergence)
     std::vector<std::complex<double>> f_; ///< Auxiliary variables
     std::vector<double> h_;               ///< Residual norms in Algorithm
 
     // Convergence-related variables
     unsigned int conv_num_;            ///< Number of systems that have converged
     std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    unsigned int stall_num_;           ///< Number of systems that have stalled at the reorthogonalization loss
+    std::vector<std::size_t> stall_;   ///< Iterations at which the systems stalled (0 if not stalled)
     double threshold_;                 ///< Relative reisudal convergence threshold
+    ConvergenceCallback on_converged_; ///< Called when a shift has converged
+    Reduction reduce_;                 ///< Global sum of the inner products (empty on a single process)
+
+    // Variables passed from the scalar part to the vector part of the update
+    std::vector<std::size_t> upd_shift_;  ///< Shifts to be updated
+    std::vector<std::array<std::complex<double>, 4>> upd_coef_; ///< Coefficients (T_prev2, T_prev, 1/T_curr, x coefficient)
+    std::vector<std::size_t> conv_shift_; ///< Converged (or stalled) shifts whose storage has not been released yet
+
+    // Variables for the deferred (blocked) update
+    std::size_t block_size_; ///< Number of deferred iterations \f$ s \f$
+    std::size_t blk_len_;    ///< Number of iterations buffered in the current block
+    std::vector<std::complex<double>> W_; ///< Buffered Lanczos vectors (matrix*s)
+    std::vector<std::array<std::complex<double>, 4>> blk_coef_; ///< Buffered coefficients (shift*s)
+    std::vector<std::size_t> blk_count_;  ///< Number of buffered iterations for each shift
+
+    // Recorded tridiagonal matrix
+    std::vector<double> lz_alpha_, lz_beta_; ///< All alpha and beta coefficients (beta_1 = 0)
+
+    // Residual history (ring buffer)
+    std::size_t log_capacity_;           ///< Number of records (0 = disabled)
+    std::size_t log_stride_;             ///< Record every stride-th iteration
+    std::size_t log_count_;              ///< Number of records since `initialize()`
+    std::vector<double> log_res_;        ///< Relative residual norms (capacity*shift)
+    std::vector<std::size_t> log_iter_;  ///< Iteration numbers (capacity)
+    std::string log_output_;             ///< File written by `finalize()`
+
+    // True-residual audit
+    std::size_t aud_interval_;           ///< Audit interval (0 = at convergence only)
+    double aud_drift_;                   ///< Factor above which a shift is flagged (0 = disabled)
+    bool aud_stop_;                      ///< Stop iterating flagged shifts
+    std::size_t aud_last_;               ///< Iteration of the last audit
+    std::vector<double> aud_res_;        ///< Latest audited true relative residual norms
+    std::vector<std::size_t> aud_flag_;  ///< Iterations at which the shifts were flagged
+
+    // Variables for the partial reorthogonalization
+    bool reorth_;                ///< Partial reorthogonalization enabled
+    bool reorth_next_;           ///< Reorthogonalize the next Lanczos vector too
+    std::size_t reorth_count_;   ///< Number of reorthogonalized Lanczos vectors
+    std::vector<std::size_t> reorth_set_;   ///< Previous Lanczos vectors to orthogonalize against
+    std::vector<std::size_t> reorth_col_;   ///< Iteration of each reorthogonalization (column of the coefficients)
+    std::vector<std::size_t> reorth_ptr_;   ///< Start of the coefficients of each reorthogonalization (size = count+1)
+    std::vector<std::size_t> reorth_row_;   ///< Lanczos vectors the coefficients belong to
+    std::vector<std::complex<double>> reorth_coef_; ///< Discarded coefficients (beta times the Gram-Schmidt coefficients)
+    std::vector<std::vector<std::complex<double>>> reorth_xi_; ///< Per shift and reorthogonalization: coordinates of p_prev, p_curr and x
+    std::vector<double> omega_prev_, omega_curr_; ///< Estimated B-inner products of the last two Lanczos vectors with the previous ones
+    std::vector<std::complex<double>> hist_w_, hist_u_; ///< Stored Lanczos vectors and B times them (matrix*k)
+    std::future<bool> ckpt_pending_;      ///< Pending checkpoint write
+
+    // Update threads of update_begin()
+    std::size_t work_threads_;            ///< Requested number of threads (0 = automatic)
+    std::vector<std::thread> workers_;    ///< Update threads (created by the first update_begin())
+    std::mutex work_mtx_;                 ///< Guards the fields below
+    std::condition_variable work_cv_;     ///< Signals a posted update or the stop request
+    std::condition_variable done_cv_;     ///< Signals that all threads have finished their parts
+    std::size_t work_gen_;                ///< Number of posted updates
+    std::size_t work_left_;               ///< Number of threads still working on the posted update
+    bool work_stop_;                      ///< Stop request
+    std::vector<std::complex<double>>* pending_x_; ///< Solution vectors of the pending update
+    bool pending_;                        ///< An update posted by update_begin() has not been waited for
   };
 
 }  // namespace gsminres
@@ -0,0 +1,204 @@
+/**
+ * \file gsminres_sstep_solver.hpp
+ * \brief Header file for the GSMINRES++ s-step solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `SStepSolver` class, a communication-avoiding variant of
+ *          `gsminres::Solver` for the generalized shifted linear systems
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)} = b, \quad (m = 1, 2, \dots, M).
+ *          \f]
+ *          `Solver` computes two B-inner products per iteration, each of which is a global
+ *          synchronization point when the vectors are distributed or threaded.
+ *          `SStepSolver` generates s basis vectors per block with the Newton basis
+ *          \f[
+ *            v_{j+1} = (B^{-1}A - \theta_j)v_j / \gamma, \quad v_0 = w_k,
+ *          \f]
+ *          which needs no inner product, and then computes the full B-Gram matrix of the basis and
+ *          the last s Lanczos vectors in a single block reduction. The s Lanczos coefficients and
+ *          vectors are recovered from the Gram matrix by running the Lanczos process on coordinate
+ *          vectors, and are passed to the shifted MINRES recurrences of `gsminres::Solver`.
+ *
+ *          The first block is the classical generalized Lanczos process; the eigenvalues of its
+ *          tridiagonal matrix (Ritz values) in Leja order are used as the Newton shifts \f$ \theta_j \f$,
+ *          and \f$ \gamma \f$ is the capacity of their interval. The shifts and the scaling are refreshed
+ *          from the whole recorded tridiagonal matrix whenever the number of iterations has doubled.
+ *          The three-term relations of the previous vectors used in the recovery hold only up to rounding
+ *          errors, which are amplified within a block and from block to block. The block is truncated when
+ *          the basis becomes numerically rank deficient, or when a recovered vector drifts from
+ *          B-orthogonality to the previous ones by more than \f$ 10^3 \epsilon_d \f$, where the drift
+ *          tolerance \f$ \epsilon_d \f$ is the convergence threshold (at least \f$ 10^6 \f$ machine epsilon).
+ *          The first vector of the next block is checked against \f$ \epsilon_d \f$ itself. The Lanczos vectors
+ *          recovered so far are kept, the remaining basis vectors are discarded, and the process restarts
+ *          from the last two vectors with a block of size one, which needs no previous relation. The block
+ *          size is doubled up to s after each complete block, so that a restart costs a few reductions.
+ *          Without `set_b_product()`, the restart is s classical steps, which also refresh the B-images.
+ *
+ *          The number of reductions is at best one per s iterations instead of two per iteration, and
+ *          depends on the matrices through the conditioning of the basis. On the pencils of `bench/`
+ *          (threshold 1e-13), the blocks of size 2 and 4 are mostly completed, but on two of them those
+ *          of size 8 are often truncated, and s = 8 saves little over s = 4. The drift also limits the attainable
+ *          relative residual, about 1e-12 to 5e-11 on these pencils versus 1e-13 for `Solver`; looser
+ *          thresholds are reached as with `Solver` (see README.md).
+ *          The price is about 4s N extra flops per iteration and 4(s+1) N additional storage.
+ */
+
+#ifndef GSMINRES_SSTEP_SOLVER_HPP
+#define GSMINRES_SSTEP_SOLVER_HPP
+
+#include <complex>
+#include <functional>
+#include <vector>
+#include "gsminres_solver.hpp"
+
+namespace gsminres {
+
+  /**
+   * \class SStepSolver
+   * \brief Generalized shifted MINRES solver class with the s-step generalized Lanczos process.
+   * \details The iteration loop is the same as for `gsminres::Solver`. Within a block,
+   *          `glanczos_pre()` and `glanczos_pst()` only extend the Newton basis, and `update()`
+   *          returns false without touching x. At the end of each block, `glanczos_pst()` performs
+   *          the block reduction and returns the next Lanczos vector in w, and `update()` applies
+   *          the s iterations of the shifted MINRES method. Convergence is detected at the exact
+   *          iteration, but up to s-1 extra matrix-vector multiplications may have been performed,
+   *          and those of the basis vectors discarded by truncated blocks are not counted as iterations.
+   */
+  class SStepSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] shift_size  Number of shifts.
+     * \param[in] block_size  Number of iterations per reduction s (>= 1).
+     */
+    SStepSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t block_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~SStepSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for iteration.
+     * \param[out]    x         Approximate solutions (size = matrix_size * shift_size).
+     * \param[in]     b         Right-hand side vector (size = matrix_size).
+     * \param[in,out] w         Pre-processed right-hand side \f$ B^{-1}b \f$ (size = matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals (also the drift tolerance).
+     */
+    void initialize(std::vector<std::complex<double>>& x,
+                    const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the (s-step) generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the (s-step) generalized Lanczos process.
+     * \details On exit, w is the vector to which the next matrix-vector multiplication is applied.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in]     u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the approximate solutions and check convergence.
+     * \details Does nothing until the coefficients of the current block are available.
+     * \param[in,out] x Solution vectors to be updated (size = matrix_size * shift_size)
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each shift (size = shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each shift (size = shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each shift (shift = shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+    /**
+     * \brief Register a global reduction for the inner products (see `Solver::set_reduction()`).
+     * \details Called twice per iteration in the first block, and once per block afterwards
+     *          with \f$ 2(2b+1)^2 \f$ values, where \f$ b \le s \f$ is the size of the block.
+     * \param[in] reduction Function to be called (an empty function means a single process).
+     */
+    void set_reduction(Solver::Reduction reduction);
+
+    /**
+     * \brief Function computing \f$ out = B\,in \f$ (size = matrix_size).
+     */
+    using Product = std::function<void(const std::vector<std::complex<double>>& in,
+                                       std::vector<std::complex<double>>& out)>;
+
+    /**
+     * \brief Register the multiplication by B.
+     * \details The B-images of the Lanczos vectors recovered from the Gram matrix are linear
+     *          combinations of the images of the basis, and their mismatch with the vectors
+     *          (the inner solves are inexact) is amplified by the three-term recurrence from block
+     *          to block. When registered, the image of the first vector of each block is recomputed,
+     *          one product per s iterations without a reduction, and the iteration counts stay within
+     *          a few percent of those of `Solver`. Without it, the convergence may be delayed.
+     * \param[in] product Function to be called (an empty function disables the recomputation).
+     */
+    void set_b_product(Product product);
+
+  private:
+    /**
+     * \brief Block reduction and recovery of the Lanczos coefficients and vectors of one block.
+     * \param[out] w Next Lanczos vector.
+     */
+    void finish_block(std::vector<std::complex<double>>& w);
+
+    /**
+     * \brief Newton shifts and scaling from the Ritz values of the recorded tridiagonal matrix.
+     */
+    void compute_shifts();
+
+    // Basic parameters
+    std::size_t matrix_size_; ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;  ///< Number of shift \f$ M \f$
+    std::size_t s_;           ///< Block size \f$ s \f$
+    std::size_t step_;        ///< Step within the current block
+    bool classical_;          ///< true during classical steps (first block, or after a breakdown of size one)
+    std::size_t classical_end_; ///< Value of step_ at which the classical steps end
+    std::size_t block_;       ///< Size of the current block (doubled up to s after a restart)
+    double threshold_;        ///< Convergence threshold (tolerance of the drift of the Lanczos vectors)
+    double drift_tol_;        ///< Tolerance of the drift of v_0 (raised to the drift kept by restarts)
+
+    // Lanczos process variables
+    std::vector<double> alpha_; ///< Recorded alpha coefficients \f$ \alpha_1, \alpha_2, \dots \f$
+    std::vector<double> beta_;  ///< Recorded beta coefficients \f$ \beta_1 = 0, \beta_2, \dots \f$
+    std::vector<std::complex<double>> Y_;  ///< Last s Lanczos vectors (oldest first) and the Newton basis (matrix*(2s+1))
+    std::vector<std::complex<double>> BY_; ///< B times Y_ (matrix*(2s+1))
+    std::vector<std::complex<double>> Wn_; ///< Lanczos vectors recovered in the last block (matrix*s)
+    std::vector<std::complex<double>> Un_; ///< B times Wn_ (matrix*s)
+    std::vector<std::complex<double>> G_;  ///< Gram matrix of Y_ with respect to B ((2s+1)*(2s+1))
+    std::vector<double> theta_;            ///< Newton shifts
+    double gamma_;                         ///< Scaling of the Newton basis
+    std::size_t refresh_at_;               ///< Number of iterations at which the shifts are refreshed
+
+    // Shifted MINRES part
+    std::size_t ready_;        ///< Number of iterations whose coefficients are not yet passed to solver_
+    std::size_t first_ready_;  ///< Index (0-based) of the first of these iterations
+    Solver::Reduction reduce_; ///< Global sum of the inner products (empty on a single process)
+    Product b_product_;        ///< Multiplication by B (empty: images from the recurrences only)
+    Solver solver_;            ///< Shifted MINRES recurrences (standard mode storage)
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_SSTEP_SOLVER_HPP
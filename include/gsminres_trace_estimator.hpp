@@ -0,0 +1,204 @@
+/**
+ * \file gsminres_trace_estimator.hpp
+ * \brief Header file for the GSMINRES++ stochastic trace and diagonal estimator.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `TraceEstimator` class, which estimates
+ *          \f[
+ *            \mathrm{Tr}\left[(A + \sigma^{(m)} B)^{-1} B\right], \quad (m=1,\dots,M)
+ *          \f]
+ *          (e.g. for the density of states) and optionally the diagonals of these matrices,
+ *          using `gsminres::Solver`. For a probe vector z, the shifted systems
+ *          \f$ (A + \sigma^{(m)} B)x^{(m)} = Bz \f$ are solved together, and
+ *          \f$ z^H x^{(m)} \f$ and \f$ \bar{z} \odot x^{(m)} \f$ are accumulated when the shifts converge.
+ *          For the trace only, `gsminres::ProjectedSolver` with the single projection vector z is used,
+ *          so that only M scalars are kept per probe instead of the M solution vectors.
+ *          With the diagonals, the solutions of the current probe are kept.
+ *
+ *          Two kinds of probe vectors are supported:
+ *          - Rademacher vectors (Hutchinson estimator). The sample variance is tracked for every shift,
+ *            and a shift stops when the standard error of its estimate falls below the tolerance.
+ *            The next probes are solved for the remaining shifts only.
+ *          - Indicator vectors of a colouring of the graph of A (probing, see `util::greedy_coloring()`).
+ *            One probe per colour; the estimate is deterministic.
+ */
+
+#ifndef GSMINRES_TRACE_ESTIMATOR_HPP
+#define GSMINRES_TRACE_ESTIMATOR_HPP
+
+#include <complex>
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include "gsminres_solver.hpp"
+#include "gsminres_projected_solver.hpp"
+
+namespace gsminres {
+
+  /**
+   * \class TraceEstimator
+   * \brief Stochastic trace and diagonal estimator driving the generalized shifted MINRES solver.
+   * \details For each probe, the caller takes the probe vector from `next_probe()`, computes
+   *          \f$ b = Bz \f$, calls `initialize()`, and runs the usual iteration loop (matrix-vector
+   *          multiplication with A and inner solve with B) until `update()` returns true.
+   *          No inner solve is needed for the initial vector, since \f$ B^{-1}b = z \f$.
+   *          `next_probe()` returns false when all shifts have stopped or the probes are exhausted.
+   */
+  class TraceEstimator {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] sigma       Shifts (size = shift_size).
+     * \param[in] diagonal    If true, the diagonals are also estimated (the solutions of a probe and
+     *                        the sums of the diagonals are stored, 2 * matrix_size * shift_size).
+     *                        Otherwise only O(matrix_size + shift_size) is stored per probe.
+     * \param[in] seed        Seed of the Rademacher probe vectors.
+     */
+    TraceEstimator(std::size_t matrix_size,
+                   const std::vector<std::complex<double>>& sigma,
+                   bool diagonal = false,
+                   std::uint64_t seed = 20240501);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~TraceEstimator() = default;
+
+    /**
+     * \brief Set the stopping criterion of the Hutchinson estimator.
+     * \details A shift stops when at least `min_probes` probes have been used and
+     *          the standard error \f$ \sqrt{s^2/n} \f$ is at most `tolerance` times the modulus of the estimate.
+     * \param[in] tolerance  Relative standard error (default = 1e-2).
+     * \param[in] min_probes Minimum number of probes (default = 10).
+     * \param[in] max_probes Maximum number of probes (default = 1000).
+     */
+    void set_stopping(double tolerance, std::size_t min_probes, std::size_t max_probes);
+
+    /**
+     * \brief Use probing vectors of a colouring instead of Rademacher vectors.
+     * \details The probe of colour c is the indicator vector of the nodes with colour c.
+     *          Must be called before the first probe.
+     * \param[in] color      Colour of each node (size = matrix_size), e.g. from `util::greedy_coloring()`.
+     * \param[in] color_size Number of colours.
+     */
+    void set_coloring(const std::vector<std::size_t>& color, std::size_t color_size);
+
+    /**
+     * \brief Generate the next probe vector.
+     * \param[out] z Probe vector (size = matrix_size).
+     * \return false if no probe is needed any more, true otherwise.
+     */
+    bool next_probe(std::vector<std::complex<double>>& z);
+
+    /**
+     * \brief Start the shifted systems of the current probe (for the shifts which have not stopped).
+     * \param[in]  b         Right-hand side \f$ Bz \f$ (size = matrix_size).
+     * \param[out] w         Vector to which the first matrix-vector multiplication is applied (size = matrix_size).
+     * \param[in]  threshold Convergence threshold for relative residuals.
+     */
+    void initialize(const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in]     u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Update the solutions and accumulate the newly converged ones.
+     * \details When all shifts of the probe have converged, the probe is added to the estimates
+     *          and the stopping criterion is checked.
+     * \return true if all shifts of the current probe have converged, false otherwise.
+     */
+    bool update();
+
+    /**
+     * \brief Accumulate the current approximations of the unconverged shifts and finish the probe.
+     * \details Only needed if the iteration of a probe is stopped before `update()` returns true.
+     */
+    void flush();
+
+    /**
+     * \brief Retrieve the trace estimates.
+     * \param[out] trace Estimates of \f$ \mathrm{Tr}[(A + \sigma^{(m)} B)^{-1} B] \f$ (size = shift_size).
+     * \param[out] error Standard errors of the estimates (size = shift_size; zero for probing).
+     */
+    void get_trace(std::vector<std::complex<double>>& trace, std::vector<double>& error) const;
+
+    /**
+     * \brief Retrieve the diagonal estimates (only if enabled in the constructor).
+     * \param[out] diag Estimates of the diagonals, \f$ d^{(m)}_i \f$ at diag[m*matrix_size+i] (size = matrix_size * shift_size).
+     */
+    void get_diagonal(std::vector<std::complex<double>>& diag) const;
+
+    /**
+     * \brief Retrieve the state of every shift.
+     * \param[out] probes  Number of probes used for each shift (size = shift_size).
+     * \param[out] stopped Whether the stopping criterion has been met (size = shift_size).
+     */
+    void get_status(std::vector<std::size_t>& probes, std::vector<bool>& stopped) const;
+
+  private:
+    /**
+     * \brief Accumulate the solution of one shift of the current probe.
+     * \param[in] shift Index in the current solver (i.e. in `active_`).
+     * \param[in] xm    Solution of the shift (size = matrix_size).
+     */
+    void accumulate(std::size_t shift, const std::complex<double>* xm);
+
+    /**
+     * \brief Add the samples of the current probe to the estimates and check the stopping criterion.
+     */
+    void commit();
+
+    // Basic parameters
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shifts \f$ M \f$
+    std::vector<std::complex<double>> sigma_; ///< Shifts
+    bool diagonal_;                           ///< Whether the diagonals are estimated
+
+    // Stopping criterion
+    double tolerance_;       ///< Relative standard error
+    std::size_t min_probes_; ///< Minimum number of probes
+    std::size_t max_probes_; ///< Maximum number of probes
+
+    // Probes
+    std::mt19937_64 gen_;             ///< Generator of the Rademacher vectors
+    std::vector<std::size_t> color_;  ///< Colour of each node (empty for Rademacher probes)
+    std::size_t color_size_;          ///< Number of colours
+    std::size_t probe_count_;         ///< Number of probes generated
+    std::vector<std::complex<double>> z_; ///< Current probe vector
+
+    // Estimates (Welford's algorithm)
+    std::vector<std::size_t> count_;          ///< Number of samples of each shift
+    std::vector<std::complex<double>> mean_;  ///< Mean of \f$ z^H x^{(m)} \f$
+    std::vector<double> m2_;                  ///< Sum of squared deviations from the mean
+    std::vector<bool> stopped_;               ///< Whether the shift has stopped
+    std::vector<std::complex<double>> diag_;  ///< Sum of \f$ \bar{z} \odot x^{(m)} \f$ (matrix*M, if enabled)
+
+    // Current probe
+    std::vector<std::size_t> active_;             ///< Shifts solved for the current probe
+    std::vector<std::complex<double>> sample_;    ///< \f$ z^H x^{(m)} \f$ of the current probe (per active shift)
+    std::vector<bool> added_;                     ///< Whether the active shift has been accumulated
+    std::vector<std::complex<double>> x_;         ///< Solutions of the current probe (matrix*active, with diagonals)
+    std::vector<std::complex<double>> zx_;        ///< \f$ z^H x^{(m)} \f$ of the current probe (active, trace only)
+    std::unique_ptr<Solver> solver_;              ///< Shifted solver of the current probe (with diagonals)
+    std::unique_ptr<ProjectedSolver> projected_;  ///< Projected solver of the current probe (trace only)
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_TRACE_ESTIMATOR_HPP
@@ -0,0 +1,151 @@
+/**
+ * \file gsminres_twopass_solver.hpp
+ * \brief Header file for the GSMINRES++ two-pass solver class.
+ * \author Shuntaro Hidaka
+ *
+ * \details This header defines the `TwoPassSolver` class, a low-memory variant of
+ *          `gsminres::Solver` for the generalized shifted linear systems
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)} = b, \quad (m = 1, 2, \dots, M).
+ *          \f]
+ *          `Solver` keeps three auxiliary vectors of size N for every shift.
+ *          `TwoPassSolver` keeps none of them, at the cost of running
+ *          the generalized Lanczos process twice:
+ *          - Pass 1 records the Lanczos coefficients and the factors of the projected
+ *            problems, and detects the convergence of every shift from scalar recurrences.
+ *          - Pass 2 regenerates the Lanczos vectors from the recorded coefficients
+ *            and accumulates the solutions \f$ x^{(m)} = W y^{(m)} \f$ directly.
+ *
+ *          The extra memory is O(M k) scalars, where k is the number of iterations.
+ */
+
+#ifndef GSMINRES_TWOPASS_SOLVER_HPP
+#define GSMINRES_TWOPASS_SOLVER_HPP
+
+#include <complex>
+#include <vector>
+#include <array>
+
+namespace gsminres {
+
+  /**
+   * \class TwoPassSolver
+   * \brief Two-pass generalized shifted MINRES solver class.
+   * \details The iteration loop is the same as for `gsminres::Solver` in both passes.
+   *          In pass 1 `update()` is called without solution vectors.
+   *          After pass 1, `restart()` prepares pass 2, in which `accumulate()`
+   *          is called instead of `update()`. In pass 2 the inner products are not
+   *          computed again; the recorded coefficients are used instead.
+   */
+  class TwoPassSolver {
+  public:
+    /**
+     * \brief Constructor.
+     * \param[in] matrix_size Matrix size.
+     * \param[in] shift_size  Number of shifts.
+     */
+    TwoPassSolver(std::size_t matrix_size, std::size_t shift_size);
+
+    /**
+     * \brief Deconstructor.
+     * \details Default destructor. No manual cleanup required.
+     */
+    ~TwoPassSolver() = default;
+
+    /**
+     * \brief Initialize the solver with input data and prepare for pass 1.
+     * \param[in]     b         Right-hand side vector (size = matrix_size).
+     * \param[in,out] w         Pre-processed right-hand side \f$ B^{-1}b \f$ (size = matrix_size).
+     * \param[in]     sigma     Vector of shift parameters (size = shift_size).
+     * \param[in]     threshold Convergence threshold for relative residuals.
+     */
+    void initialize(const std::vector<std::complex<double>>& b,
+                    std::vector<std::complex<double>>& w,
+                    const std::vector<std::complex<double>>& sigma,
+                    const double threshold);
+
+    /**
+     * \brief Perform the pre-processing step of the generalized Lanczos process.
+     * \param[in,out] u Vector to which is matrix-vector multiplication is applied, \f$ u=Aw\f$.
+     */
+    void glanczos_pre(std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Perform the post-processing step of the generalized Lanczos process.
+     * \param[in,out] w Pre-processed vector \f$ w = B^{-1}u \f$.
+     * \param[in,out] u Vector which used in `glanczos_pre()`.
+     */
+    void glanczos_pst(std::vector<std::complex<double>>& w,
+                      std::vector<std::complex<double>>& u);
+
+    /**
+     * \brief Pass 1: update the projected problems and check convergence.
+     * \return true if all systems have converged, false otherwise.
+     */
+    bool update();
+
+    /**
+     * \brief Finish pass 1 and prepare pass 2.
+     * \details Computes the coefficients \f$ y^{(m)} \f$ by back substitution.
+     *          Shifts that did not converge in pass 1 use all recorded iterations.
+     * \param[out] x Approximate solutions, set to zero (size = matrix_size * shift_size).
+     * \param[out] w Initial Lanczos vector for pass 2 (size = matrix_size).
+     */
+    void restart(std::vector<std::complex<double>>& x,
+                 std::vector<std::complex<double>>& w);
+
+    /**
+     * \brief Pass 2: accumulate the current Lanczos vector into the solutions.
+     * \param[in,out] x Solution vectors to be updated (size = matrix_size * shift_size).
+     * \return true if all solutions are complete, false otherwise.
+     */
+    bool accumulate(std::vector<std::complex<double>>& x);
+
+    /**
+     * \brief Retrieve converged iteration and converged residual norm.
+     * \param[out] conv_itr Number of iterations for each shift (size = shift_size).
+     * \param[out] conv_res Final residual norms in Algorithm for each shift (size = shift_size).
+     */
+    void finalize(std::vector<std::size_t>& conv_itr, std::vector<double>& conv_res);
+
+    /**
+     * \brief Retrieve current residual norms in Algorithm.
+     * \param[out] res Residual norms in Algorithm for each shift (shift = shift_size).
+     */
+    void get_residual(std::vector<double>& res) const;
+
+  private:
+    // Basic parameters
+    std::size_t iter_;                        ///< Number of iterations in the current pass
+    std::size_t matrix_size_;                 ///< Matrix size \f$ N \f$
+    std::size_t shift_size_;                  ///< Number of shift \f$ M \f$
+    double r0_norm_;                          ///< Norm of the initial residual norm
+    std::vector<std::complex<double>> sigma_; ///< Shift values \f$ \sigma^{(m)} \f$
+    bool second_pass_;                        ///< true during pass 2
+
+    // Generalized Lanczos process variables.
+    std::vector<double> alpha_;    ///< Recorded alpha coefficients
+    std::vector<double> beta_;     ///< Recorded beta coefficients
+    std::vector<std::complex<double>> w_curr_, w_next_;          ///< Lanczos basis vectors
+    std::vector<std::complex<double>> u_prev_, u_curr_, u_next_; ///< Auxiliary vectors
+    std::vector<std::complex<double>> w_init_, u_init_;          ///< Initial Lanczos vectors for pass 2
+
+    // Variables for the projected problems
+    std::vector<std::complex<double>> T_prev2_, T_prev_, T_curr_, T_next_; ///< Elements of the tridiagonal matrix
+    std::vector<std::array<double, 3>>               Gc_; ///< Givens rotation matrixs element "c"
+    std::vector<std::array<std::complex<double>, 3>> Gs_; ///< Givens rotation matrixs element "s"
+    std::vector<std::vector<std::array<std::complex<double>, 3>>> R_; ///< Columns of the triangular factors (per shift)
+    std::vector<std::vector<std::complex<double>>> y_; ///< Right-hand sides, then solutions of the projected problems
+    std::vector<std::complex<double>> f_; ///< Auxiliary variables
+    std::vector<double> h_;               ///< Residual norms in Algorithm
+
+    // Convergence-related variables
+    std::size_t conv_num_;             ///< Number of systems that have converged
+    std::vector<std::size_t> is_conv_; ///< Flags indicating convergence for each system
+    std::size_t max_iter_;             ///< Number of iterations needed in pass 2
+    double threshold_;                 ///< Relative reisudal convergence threshold
+  };
+
+}  // namespace gsminres
+
+#endif // GSMINRES_TWOPASS_SOLVER_HPP
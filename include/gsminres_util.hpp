@@ -20,6 +20,7 @@
 #include <string>
 #include <complex>
 #include <vector>
+#include <functional>
 
 /**
  * \namespace gsminres::util
@@ -103,6 +104,41 @@ namespace gsminres {
               const std::vector<std::complex<double>>& x,
               std::vector<std::complex<double>>&       y);
 
+    /**
+     * \brief Perform sparse matrix-multivector multiplication: \f$ Y = A X \f$.
+     * \details The matrix is read once for all vectors.
+     *          The k-th vector of X and Y occupies the range [k*N, (k+1)*N).
+     * \param[in]  A           Matrix in CSR format.
+     * \param[in]  X           Input vectors (size = N * num_vectors).
+     * \param[out] Y           Output vectors where result is stored (size = N * num_vectors).
+     * \param[in]  num_vectors Number of vectors.
+     */
+    void spmm(const CSRMat&                            A,
+              const std::vector<std::complex<double>>& X,
+              std::vector<std::complex<double>>&       Y,
+              const std::size_t num_vectors);
+
+    /**
+     * \brief Compute the true residual norms \f$ \|b - (A + \sigma^{(m)} B)x^{(m)}\| \f$ of several shifts at once.
+     * \details A and B are read once for all selected shifts (fused SpMM of both matrices with the solution block),
+     *          and the residuals are reduced on the fly, so no vector of size N x M is allocated.
+     *          The m-th solution occupies the range [m*N, (m+1)*N) of X.
+     * \param[in]  A      Hermitian matrix (CSR format).
+     * \param[in]  B      Hermitian positive-definite matrix (CSR format, size of A).
+     * \param[in]  X      Solution vectors (size = N * number of shifts).
+     * \param[in]  b      Right-hand side vector (size = N).
+     * \param[in]  sigma  Shift parameters.
+     * \param[in]  shifts Indices of the shifts to compute.
+     * \param[out] res    Residual norms for each selected shift (size = shifts.size()).
+     */
+    void shifted_residuals(const CSRMat&                            A,
+                           const CSRMat&                            B,
+                           const std::vector<std::complex<double>>& X,
+                           const std::vector<std::complex<double>>& b,
+                           const std::vector<std::complex<double>>& sigma,
+                           const std::vector<std::size_t>&          shifts,
+                           std::vector<double>&                     res);
+
     /**
      * \brief Solve \f$ Ax=b \f$ using the Conjugate Gradient method.
      * \param[in]  A        Coefficient matrix (CSR format).
@@ -117,6 +153,129 @@ namespace gsminres {
             const std::vector<std::complex<double>>& b,
             const double tol, const std::size_t max_iter);
 
+    /**
+     * \brief Function type that applies a preconditioner: \f$ z = M^{-1} r \f$.
+     * \details \f$ M^{-1} \f$ must be Hermitian positive-definite (e.g. `amg_vcycle()`).
+     */
+    using Preconditioner = std::function<void(const std::vector<std::complex<double>>& r,
+                                              std::vector<std::complex<double>>&       z)>;
+
+    /**
+     * \brief Solve \f$ Ax=b \f$ using the preconditioned Conjugate Gradient method.
+     * \param[in]  A        Coefficient matrix (CSR format).
+     * \param[out] x        Solution vector.
+     * \param[in]  b        Right-hand side vector.
+     * \param[in]  tol      Relative residual tolerance.
+     * \param[in]  max_iter Maximum number of iterations.
+     * \param[in]  precond  Preconditioner applied once per iteration.
+     * \return true if converged, false otherwise.
+     */
+    bool cg(const CSRMat&                            A,
+            std::vector<std::complex<double>>&       x,
+            const std::vector<std::complex<double>>& b,
+            const double tol, const std::size_t max_iter,
+            const Preconditioner&                    precond);
+
+    /**
+     * \brief Solve \f$ AX=B \f$ using the Conjugate Gradient method for several right-hand sides in lockstep.
+     * \details Each column is an independent CG iteration, but the matrix is applied to
+     *          all columns at once with `spmm()`.
+     *          Converged columns are frozen, and zero right-hand sides give zero solutions.
+     * \param[in]  A           Coefficient matrix (CSR format).
+     * \param[out] X           Solution vectors (size = N * num_vectors).
+     * \param[in]  B           Right-hand side vectors (size = N * num_vectors).
+     * \param[in]  num_vectors Number of right-hand sides.
+     * \param[in]  tol         Relative residual tolerance.
+     * \param[in]  max_iter    Maximum number of iterations.
+     * \return true if all columns converged, false otherwise.
+     */
+    bool block_cg(const CSRMat&                            A,
+                  std::vector<std::complex<double>>&       X,
+                  const std::vector<std::complex<double>>& B,
+                  const std::size_t num_vectors,
+                  const double tol, const std::size_t max_iter);
+
+    /**
+     * \struct ChebyshevParam
+     * \brief Parameters of the Chebyshev iteration for a Hermitian positive-definite matrix.
+     */
+    struct ChebyshevParam {
+      double      lambda_min; ///< Lower bound of the spectrum used by the iteration.
+      double      lambda_max; ///< Upper bound of the spectrum used by the iteration.
+      std::size_t iterations; ///< Fixed number of iterations.
+    };
+
+    /**
+     * \brief Chebyshev parameters from the Lanczos coefficients of a Hermitian positive-definite matrix.
+     * \details The extreme Ritz values are widened by 10% (they lie inside the spectrum), and the
+     *          number of iterations is the smallest k with \f$ 2\rho^k \le \f$ tol, where
+     *          \f$ \rho = (\sqrt{\kappa}-1)/(\sqrt{\kappa}+1) \f$ bounds the residual reduction per iteration.
+     * \param[in] alpha Diagonal elements of the Lanczos tridiagonal matrix (size = k).
+     * \param[in] beta  Subdiagonal elements (size >= k-1).
+     * \param[in] tol   Relative residual tolerance.
+     * \return Chebyshev parameters.
+     */
+    ChebyshevParam chebyshev_param(const std::vector<double>& alpha,
+                                   const std::vector<double>& beta,
+                                   const double tol);
+
+    /**
+     * \brief Estimate the Chebyshev parameters of a Hermitian positive-definite matrix.
+     * \details Runs a short Lanczos process (the only inner products) and calls `chebyshev_param()`.
+     *          The result depends only on the matrix and the tolerance, so it should be computed once
+     *          and reused for all solves with the same matrix.
+     * \param[in] A             Coefficient matrix (CSR format).
+     * \param[in] tol           Relative residual tolerance of the subsequent solves.
+     * \param[in] lanczos_steps Number of Lanczos steps (default = 20).
+     * \return Chebyshev parameters.
+     */
+    ChebyshevParam chebyshev_setup(const CSRMat& A, const double tol, const std::size_t lanczos_steps = 20);
+
+    /**
+     * \brief Solve \f$ Ax=b \f$ using the Chebyshev iteration.
+     * \details Performs `param.iterations` iterations without any inner product or norm,
+     *          i.e. without global synchronization apart from the matrix-vector multiplications.
+     * \param[in]  A     Coefficient matrix (CSR format).
+     * \param[in]  param Parameters from `chebyshev_setup()`.
+     * \param[out] x     Solution vector.
+     * \param[in]  b     Right-hand side vector.
+     */
+    void chebyshev(const CSRMat&                            A,
+                   const ChebyshevParam&                    param,
+                   std::vector<std::complex<double>>&       x,
+                   const std::vector<std::complex<double>>& b);
+
+    /**
+     * \brief Solve \f$ AX=B \f$ using the Chebyshev iteration for several right-hand sides at once.
+     * \details The coefficients do not depend on the right-hand side, so every iteration is
+     *          one `spmm()` and two vector updates of the whole block.
+     * \param[in]  A           Coefficient matrix (CSR format).
+     * \param[in]  param       Parameters from `chebyshev_setup()`.
+     * \param[out] X           Solution vectors (size = N * num_vectors).
+     * \param[in]  B           Right-hand side vectors (size = N * num_vectors).
+     * \param[in]  num_vectors Number of right-hand sides.
+     */
+    void block_chebyshev(const CSRMat&                            A,
+                         const ChebyshevParam&                    param,
+                         std::vector<std::complex<double>>&       X,
+                         const std::vector<std::complex<double>>& B,
+                         const std::size_t num_vectors);
+
+    /**
+     * \brief Greedy distance-k colouring of the adjacency graph of a sparse matrix.
+     * \details Two nodes get different colours if they are connected by a path of at most
+     *          `distance` edges of the graph of A. The indicator vectors of the colours are the
+     *          probing vectors of `gsminres::TraceEstimator::set_coloring()`: the diagonal of a matrix
+     *          function is then exact up to the entries between nodes farther apart than `distance`.
+     * \param[in]  A        Matrix (CSR format), whose sparsity pattern defines the graph.
+     * \param[in]  distance Colouring distance (>= 1).
+     * \param[out] color    Colour of each node (size = N).
+     * \return Number of colours.
+     */
+    std::size_t greedy_coloring(const CSRMat&             A,
+                                const std::size_t         distance,
+                                std::vector<std::size_t>& color);
+
   }  // namespace util
 }  //namespace gsminres
 
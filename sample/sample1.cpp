@@ -76,7 +76,6 @@ int main(int argc, char* argv[]) {
       std::cout << "converged in " << j << std::endl;
       break;
     }
-    solver.get_residual(res);
     /*
     if(j % 10 == 1) {
       std::cout << j;
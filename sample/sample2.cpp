@@ -27,8 +27,12 @@
  *
  * \par Usage:
  * \code
- *  $ ./sample2 ../data/A.mtx ../data/B.mtx
+ *  $ ./sample2 ../data/A.mtx ../data/B.mtx [history.csv]
  * \endcode
+ *          With the third argument, the residual history of all shifts is recorded by the solver
+ *          and written at `finalize()` together with per-shift diagnostics (history.csv.diag.csv).
+ *          The true residuals of all unconverged shifts are audited every 100 iterations and at convergence
+ *          with `util::shifted_residuals()`, which reads A and B once for all shifts.
  */
 
 #include <iostream>
@@ -43,7 +47,7 @@
 int main(int argc, char* argv[]) {
   std::size_t N, M;
   if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> [history_file]" << std::endl;
     return 1;
   }
   std::string Aname = argv[1], Bname = argv[2];
@@ -65,6 +69,14 @@ int main(int argc, char* argv[]) {
   std::vector<double> res(M);
 
   gsminres::Solver solver(N, M);
+  if (argc > 3) {
+    solver.set_history(10000, 1, argv[3]);
+  }
+  // Audit the true residuals every 100 iterations and at convergence
+  const double bnrm = gsminres::blas::dznrm2(N, b);
+  std::vector<std::size_t> audit_shifts;
+  std::vector<double> audit_res;
+  solver.set_audit(100);
   if (!gsminres::util::cg(B, w, b, 1e-13, 10000)) {
     std::cerr << "Failed" << std::endl;
     std::exit(1);
@@ -78,11 +90,21 @@ int main(int argc, char* argv[]) {
       std::exit(1);
     }
     solver.glanczos_pst(w, u);
-    if(solver.update(x)) {
+    const bool converged = solver.update(x);
+    if (solver.audit_due(audit_shifts)) {
+      // True residuals of all audited shifts in one pass over A and B
+      gsminres::util::shifted_residuals(A, B, x, b, sigma, audit_shifts, audit_res);
+      for (double& r : audit_res) {
+        r /= bnrm;
+      }
+      if (solver.audit(audit_shifts, audit_res, x) > 0) {
+        std::cerr << "audit: true residual drifted at iteration " << j << std::endl;
+      }
+    }
+    if(converged) {
       std::cout << "converged in " << j << std::endl;
       break;
     }
-    solver.get_residual(res);
     /*
     if(j % 10 == 1) {
       std::cout << j;
@@ -102,15 +124,15 @@ int main(int argc, char* argv[]) {
   }
   solver.finalize(itr, res);
 
+  // True residual norms of all shifts (A and B are read once)
+  std::vector<std::size_t> all(M);
+  std::vector<double> true_res;
+  for(std::size_t j=0; j<M; ++j){
+    all[j] = j;
+  }
+  gsminres::util::shifted_residuals(A, B, x, b, sigma, all, true_res);
   for(std::size_t j=0; j<M; ++j){
-    std::vector<std::complex<double>> ans(x.begin()+j*N, x.begin()+(j+1)*N);
-    std::vector<std::complex<double>> tmp1(N, {0.0, 0.0}), tmp2(N, {0.0, 0.0});
-    double tmp_nrm = 0.0;
-    gsminres::util::spmv(A, ans, tmp1);
-    gsminres::util::spmv(B, ans, tmp2);
-    gsminres::blas::zaxpy(N, sigma[j], tmp2, 0, tmp1, 0);
-    gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, 0, tmp1, 0);
-    tmp_nrm = gsminres::blas::dznrm2(N, tmp1);
+    const double tmp_nrm = true_res[j];
     std::cout << std::right
               << std::setw(2) << j << " "
               << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
@@ -0,0 +1,102 @@
+/**
+ * \file sample_async.cpp
+ * \brief C++ example of using GSMINRES++ with asynchronous solution updates.
+ * \example sample_async.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example solves a set of generalized shifted linear systems of the form:
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)} = b, \quad (m=1,\dots,M)
+ *          \f]
+ *          using the GSMINRES++ solver, as in `sample2.cpp`.
+ *
+ *          `update_begin()` is used instead of `update()`, so that the update of
+ *          the solution vectors runs on the update threads of the solver, which split
+ *          the shifts among them, while the matrix-vector multiplication and the inner CG
+ *          of the next iteration proceed. The number of update threads can be given as
+ *          the third argument (`set_update_threads()`; default = automatic).
+ *          `update_wait()` must be called before the solutions are used.
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_async ../data/A.csr ../data/B.csr [threads]
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include "gsminres_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+int main(int argc, char* argv[]) {
+  std::size_t N, M;
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> [threads]" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  N = A.matrix_size;
+  const std::vector<std::complex<double>>     b = gsminres::util::generate_ones(N);
+  std::vector<std::complex<double>> sigma(10);
+  for(std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    std::complex<double> tmp = 2 * M_PI * I * (i+0.5) / 10.0;
+    sigma[i] = 0.1 * std::exp(tmp);
+  }
+  M = sigma.size();
+
+  std::vector<std::complex<double>> x(M*N, {0.0, 0.0});
+  std::vector<std::complex<double>> w(N, {0.0, 0.0}), u(N, {0.0, 0.0});
+  std::vector<std::size_t> itr(M);
+  std::vector<double> res(M);
+
+  gsminres::Solver solver(N, M);
+  if (argc > 3) {
+    solver.set_update_threads(std::stoul(argv[3]));
+  }
+  if (!gsminres::util::cg(B, w, b, 1e-13, 10000)) {
+    std::cerr << "Failed" << std::endl;
+    std::exit(1);
+  }
+  solver.initialize(x, b, w, sigma, 1e-13);
+  for(std::size_t j=1; j<10000; ++j) {
+    gsminres::util::spmv(A, w, u);
+    solver.glanczos_pre(u);
+    if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+      std::cerr << "Failed" << std::endl;
+      std::exit(1);
+    }
+    solver.glanczos_pst(w, u);
+    if(solver.update_begin(x)) {
+      std::cout << "converged in " << j << std::endl;
+      break;
+    }
+  }
+  solver.update_wait();
+  solver.finalize(itr, res);
+
+  for(std::size_t j=0; j<M; ++j){
+    std::vector<std::complex<double>> ans(x.begin()+j*N, x.begin()+(j+1)*N);
+    std::vector<std::complex<double>> tmp1(N, {0.0, 0.0}), tmp2(N, {0.0, 0.0});
+    double tmp_nrm = 0.0;
+    gsminres::util::spmv(A, ans, tmp1);
+    gsminres::util::spmv(B, ans, tmp2);
+    gsminres::blas::zaxpy(N, sigma[j], tmp2, 0, tmp1, 0);
+    gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, 0, tmp1, 0);
+    tmp_nrm = gsminres::blas::dznrm2(N, tmp1);
+    std::cout << std::right
+              << std::setw(2) << j << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].imag() << " "
+              << std::setw(5) << itr[j] << " "
+              << std::scientific << std::setw(12) << std::setprecision(5) << res[j] << " "
+              << std::scientific << std::setw(12) << std::setprecision(5) << tmp_nrm
+              << std::endl;
+  }
+}
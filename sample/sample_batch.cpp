@@ -0,0 +1,105 @@
+/**
+ * \file sample_batch.cpp
+ * \brief C++ example of using GSMINRES++ batched solver with CSR format input and built-in SpMM+CG.
+ * \example sample_batch.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example solves sets of generalized shifted linear systems
+ *          for several right-hand sides of the form:
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)}_k = b_k, \quad (m=1,\dots,M,\ k=1,\dots,K)
+ *          \f]
+ *          using the `gsminres::BatchSolver`.
+ *
+ *          All right-hand sides advance in lockstep, so that the matrix-vector
+ *          multiplication and the inner linear solve are performed once per iteration
+ *          on a block of K vectors using the built-in routines (`spmm` and `block_cg`).
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_batch ../data/A.csr ../data/B.csr
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "gsminres_batch_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+int main(int argc, char* argv[]) {
+  std::size_t N, M, K = 4;
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)>" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  N = A.matrix_size;
+  std::vector<std::complex<double>> b(K*N, {0.0, 0.0});
+  for (std::size_t k=0; k<K; k++) {
+    for (std::size_t i=0; i<N; i++) {
+      b[k*N+i] = std::exp(std::complex<double>(0.0, 2 * M_PI * k * i / N));
+    }
+  }
+  std::vector<std::complex<double>> sigma(10);
+  for (std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    sigma[i] = 0.1 * std::exp(2 * M_PI * I * (i+0.5) / 10.0);
+  }
+  M = sigma.size();
+
+  std::vector<std::complex<double>> x(K*M*N, {0.0, 0.0});
+  std::vector<std::complex<double>> w(K*N, {0.0, 0.0}), u(K*N, {0.0, 0.0});
+  std::vector<std::size_t> itr(K*M);
+  std::vector<double> res(K*M);
+
+  gsminres::BatchSolver solver(N, M, K);
+  if (!gsminres::util::block_cg(B, w, b, K, 1e-13, 10000)) {
+    std::cerr << "Failed" << std::endl;
+    std::exit(1);
+  }
+  solver.initialize(x, b, w, sigma, 1e-13);
+  for (std::size_t j=1; j<10000; ++j) {
+    gsminres::util::spmm(A, w, u, K);
+    solver.glanczos_pre(u);
+    if (!gsminres::util::block_cg(B, w, u, K, 1e-13, 10000)) {
+      std::cerr << "Failed" << std::endl;
+      std::exit(1);
+    }
+    solver.glanczos_pst(w, u);
+    if (solver.update(x)) {
+      std::cout << "converged in " << j << std::endl;
+      break;
+    }
+  }
+  solver.finalize(itr, res);
+
+  for (std::size_t k=0; k<K; ++k) {
+    for (std::size_t j=0; j<M; ++j) {
+      std::size_t offset = (k*M+j)*N;
+      std::vector<std::complex<double>> ans(x.begin()+offset, x.begin()+offset+N);
+      std::vector<std::complex<double>> tmp1(N, {0.0, 0.0}), tmp2(N, {0.0, 0.0});
+      double tmp_nrm = 0.0;
+      gsminres::util::spmv(A, ans, tmp1);
+      gsminres::util::spmv(B, ans, tmp2);
+      gsminres::blas::zaxpy(N, sigma[j], tmp2, 0, tmp1, 0);
+      gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, k*N, tmp1, 0);
+      tmp_nrm = gsminres::blas::dznrm2(N, tmp1);
+      std::cout << std::right
+                << std::setw(2) << k << " "
+                << std::setw(2) << j << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].imag() << " "
+                << std::setw(5) << itr[k*M+j] << " "
+                << std::scientific << std::setw(12) << std::setprecision(5) << res[k*M+j] << " "
+                << std::scientific << std::setw(12) << std::setprecision(5) << tmp_nrm
+                << std::endl;
+    }
+  }
+}
@@ -0,0 +1,122 @@
+/**
+ * \file sample_checkpoint.cpp
+ * \brief C++ example of checkpointing and restarting the GSMINRES++ solver.
+ * \example sample_checkpoint.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example solves a set of generalized shifted linear systems of the form:
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)} = b, \quad (m=1,\dots,M)
+ *          \f]
+ *          using the GSMINRES++ solver, as in `sample2.cpp`.
+ *
+ *          Every `interval` iterations the complete solver state and x are written to the checkpoint file
+ *          with `checkpoint_begin()`, which streams the file on a worker thread while the iteration continues.
+ *          If the checkpoint file exists at start, the run is resumed from it with `restore()`
+ *          instead of `initialize()`, and continues exactly as the uninterrupted run would.
+ *          The optional `stop` argument ends the run after that many iterations (to simulate a pre-emption).
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_checkpoint ../data/A.csr ../data/B.csr state.ckpt [interval [stop]]
+ *  $ ./sample_checkpoint ../data/A.csr ../data/B.csr state.ckpt 100 250   # stopped after 250 iterations
+ *  $ ./sample_checkpoint ../data/A.csr ../data/B.csr state.ckpt 100       # resumed from iteration 200
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <complex>
+#include <string>
+#include <vector>
+#include "gsminres_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+int main(int argc, char* argv[]) {
+  std::size_t N, M;
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> <checkpoint_file> [interval [stop]]" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2], Cname = argv[3];
+  const std::size_t interval = (argc > 4) ? std::stoul(argv[4]) : 100;
+  const std::size_t stop     = (argc > 5) ? std::stoul(argv[5]) : 10000;
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  N = A.matrix_size;
+  const std::vector<std::complex<double>>     b = gsminres::util::generate_ones(N);
+  std::vector<std::complex<double>> sigma(10);
+  for(std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    std::complex<double> tmp = 2 * M_PI * I * (i+0.5) / 10.0;
+    sigma[i] = 0.1 * std::exp(tmp);
+  }
+  M = sigma.size();
+
+  std::vector<std::complex<double>> x(M*N, {0.0, 0.0});
+  std::vector<std::complex<double>> w(N, {0.0, 0.0}), u(N, {0.0, 0.0});
+  std::vector<std::size_t> itr(M);
+  std::vector<double> res(M);
+
+  gsminres::Solver solver(N, M);
+  if (std::ifstream(Cname).good()) {
+    if (!solver.restore(Cname, x, w)) {
+      std::exit(1);
+    }
+    std::cout << "resumed from iteration " << solver.get_iteration() << std::endl;
+  } else {
+    if (!gsminres::util::cg(B, w, b, 1e-13, 10000)) {
+      std::cerr << "Failed" << std::endl;
+      std::exit(1);
+    }
+    solver.initialize(x, b, w, sigma, 1e-13);
+  }
+  bool converged = false;
+  for(std::size_t j=solver.get_iteration()+1; j<=stop; ++j) {
+    gsminres::util::spmv(A, w, u);
+    solver.glanczos_pre(u);
+    if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+      std::cerr << "Failed" << std::endl;
+      std::exit(1);
+    }
+    solver.glanczos_pst(w, u);
+    if(solver.update(x)) {
+      std::cout << "converged in " << j << std::endl;
+      converged = true;
+      break;
+    }
+    if (j % interval == 0) {
+      solver.checkpoint_begin(Cname, x);
+    }
+  }
+  if (!solver.checkpoint_wait()) {
+    std::exit(1);
+  }
+  if (!converged) {
+    std::cout << "stopped after " << solver.get_iteration() << " iterations" << std::endl;
+    return 0;
+  }
+  solver.finalize(itr, res);
+
+  for(std::size_t j=0; j<M; ++j){
+    std::vector<std::complex<double>> ans(x.begin()+j*N, x.begin()+(j+1)*N);
+    std::vector<std::complex<double>> tmp1(N, {0.0, 0.0}), tmp2(N, {0.0, 0.0});
+    double tmp_nrm = 0.0;
+    gsminres::util::spmv(A, ans, tmp1);
+    gsminres::util::spmv(B, ans, tmp2);
+    gsminres::blas::zaxpy(N, sigma[j], tmp2, 0, tmp1, 0);
+    gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, 0, tmp1, 0);
+    tmp_nrm = gsminres::blas::dznrm2(N, tmp1);
+    std::cout << std::right
+              << std::setw(2) << j << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].imag() << " "
+              << std::setw(5) << itr[j] << " "
+              << std::scientific << std::setw(12) << std::setprecision(5) << res[j] << " "
+              << std::scientific << std::setw(12) << std::setprecision(5) << tmp_nrm
+              << std::endl;
+  }
+}
@@ -0,0 +1,112 @@
+/**
+ * \file sample_contour.cpp
+ * \brief C++ example of the contour-integral eigensolver of GSMINRES++.
+ * \example sample_contour.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example computes the eigenpairs of the generalized eigenvalue problem
+ *          \f[
+ *            Ax = \lambda Bx, \quad |\lambda - \gamma| < \rho
+ *          \f]
+ *          using `gsminres::ContourSolver`. For each source vector, the shifted systems at the
+ *          quadrature points are solved by the shifted solver, with the inner linear systems
+ *          with B solved by CG. The eigenpairs are extracted by both the SS-Hankel and the SS-RR
+ *          methods, and their residual norms \f$ \|Ax - \lambda Bx\| \f$ are printed.
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_contour ../data/A.csr ../data/B.csr [center radius]
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include <string>
+#include "gsminres_contour_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+// Residual norm ||Ax - lambda Bx|| of a normalized eigenvector
+static double eig_residual(const gsminres::util::CSRMat& A, const gsminres::util::CSRMat& B,
+                           std::complex<double> lambda, const std::vector<std::complex<double>>& X,
+                           std::size_t j) {
+  const std::size_t N = A.matrix_size;
+  std::vector<std::complex<double>> x(X.begin()+j*N, X.begin()+(j+1)*N);
+  std::vector<std::complex<double>> Ax(N), Bx(N);
+  gsminres::util::spmv(A, x, Ax);
+  gsminres::util::spmv(B, x, Bx);
+  gsminres::blas::zaxpy(N, -lambda, Bx, 0, Ax, 0);
+  return gsminres::blas::dznrm2(N, Ax);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> [center radius]" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const double center = (argc > 3) ? std::stod(argv[3]) : 0.0255;
+  const double radius = (argc > 4) ? std::stod(argv[4]) : 0.002;
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  const std::size_t N = A.matrix_size;
+  const std::size_t M = 16, L = 8, K = 4;
+
+  gsminres::ContourSolver solver(N, center, radius, M, L, K);
+  std::vector<std::complex<double>> v(N), b(N), w(N), u(N);
+  for (std::size_t l=0; l<L; l++) {
+    solver.get_source(l, v);
+    gsminres::util::spmv(B, v, b);
+    solver.initialize(l, b, w, 1e-12);
+    for (std::size_t j=1; j<10000; ++j) {
+      gsminres::util::spmv(A, w, u);
+      solver.glanczos_pre(u);
+      if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+        std::cerr << "Failed" << std::endl;
+        std::exit(1);
+      }
+      solver.glanczos_pst(w, u);
+      if (solver.update()) {
+        std::cout << "source " << l << " converged in " << j << std::endl;
+        break;
+      }
+    }
+  }
+
+  // SS-Hankel: no further matrix-vector multiplications
+  std::vector<std::complex<double>> lambda_h, X_h;
+  const std::size_t nh = solver.hankel(lambda_h, X_h, 1e-10);
+  std::cout << "SS-Hankel: " << nh << " eigenvalues" << std::endl;
+  for (std::size_t j=0; j<nh; j++) {
+    std::cout << std::right << std::setw(3) << j << " "
+              << std::fixed << std::setw(14) << std::setprecision(10) << lambda_h[j].real() << " "
+              << std::scientific << std::setw(12) << std::setprecision(3) << lambda_h[j].imag() << " "
+              << std::scientific << std::setw(12) << std::setprecision(5)
+              << eig_residual(A, B, lambda_h[j], X_h, j) << std::endl;
+  }
+
+  // SS-RR: AQ and BQ are computed here
+  std::vector<std::complex<double>> Q;
+  const std::size_t r = solver.basis(Q, 1e-10);
+  std::vector<std::complex<double>> AQ(N*r), BQ(N*r), q(N), tmp(N);
+  for (std::size_t j=0; j<r; j++) {
+    gsminres::blas::zcopy(N, Q, j*N, q, 0);
+    gsminres::util::spmv(A, q, tmp);
+    gsminres::blas::zcopy(N, tmp, 0, AQ, j*N);
+    gsminres::util::spmv(B, q, tmp);
+    gsminres::blas::zcopy(N, tmp, 0, BQ, j*N);
+  }
+  std::vector<double> lambda_r;
+  std::vector<std::complex<double>> X_r;
+  const std::size_t nr = solver.rayleigh_ritz(AQ, BQ, lambda_r, X_r);
+  std::cout << "SS-RR: " << nr << " eigenvalues (rank " << r << ")" << std::endl;
+  for (std::size_t j=0; j<nr; j++) {
+    std::cout << std::right << std::setw(3) << j << " "
+              << std::fixed << std::setw(14) << std::setprecision(10) << lambda_r[j] << " "
+              << std::scientific << std::setw(12) << std::setprecision(5)
+              << eig_residual(A, B, lambda_r[j], X_r, j) << std::endl;
+  }
+}
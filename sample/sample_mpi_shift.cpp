@@ -0,0 +1,120 @@
+/**
+ * \file sample_mpi_shift.cpp
+ * \brief Example of using GSMINRES++ with the shifts distributed over MPI processes.
+ * \example sample_mpi_shift.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example solves the same generalized shifted linear systems as sample2.cpp:
+ *          \f[
+ *            (A + \sigma^{(m)} B)x^{(m)} = b, \quad (m=1,\dots,M)
+ *          \f]
+ *          using `gsminres::mpi::ShiftSolver`. Every process holds the whole matrices and
+ *          Lanczos vectors, but only the solutions of its own shifts.
+ *
+ *          Without the third argument, every process performs the matrix-vector multiplications
+ *          and the inner solves itself (redundant mode). With `bcast`, only rank 0 performs them
+ *          and broadcasts the Lanczos vectors (broadcast mode).
+ *
+ *          The library must be built with `-DGSMINRES_ENABLE_MPI=ON`.
+ *
+ * \par Usage:
+ * \code
+ *  $ mpirun -np 4 ./sample_mpi_shift ../data/A.csr ../data/B.csr [bcast]
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include <string>
+#include <mpi.h>
+#include "gsminres_mpi_shift_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  std::size_t N, M;
+  if (argc < 3) {
+    if (rank == 0) {
+      std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> [bcast]" << std::endl;
+    }
+    MPI_Finalize();
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const bool broadcast = (argc > 3 && std::string(argv[3]) == "bcast");
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  N = A.matrix_size;
+  const std::vector<std::complex<double>> b = gsminres::util::generate_ones(N);
+  std::vector<std::complex<double>> sigma(10);
+  for(std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    std::complex<double> tmp = 2 * M_PI * I * (i+0.5) / 10.0;
+    sigma[i] = 0.1 * std::exp(tmp);
+  }
+  M = sigma.size();
+
+  gsminres::mpi::ShiftSolver solver(MPI_COMM_WORLD, N, M, broadcast);
+  const std::size_t M_local = solver.local_shift_size();
+  const std::size_t m_begin = solver.shift_begin();
+  std::vector<std::complex<double>> x(M_local*N, {0.0, 0.0});
+  std::vector<std::complex<double>> w(N, {0.0, 0.0}), u(N, {0.0, 0.0});
+  std::vector<std::size_t> itr(M);
+  std::vector<double> res(M);
+
+  if (solver.applies_operators() && !gsminres::util::cg(B, w, b, 1e-13, 10000)) {
+    std::cerr << "Failed" << std::endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  solver.initialize(x, b, w, sigma, 1e-13);
+  for(std::size_t j=1; j<10000; ++j) {
+    if (solver.applies_operators()) {
+      gsminres::util::spmv(A, w, u);
+      solver.glanczos_pre(u);
+      if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+        std::cerr << "Failed" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+    solver.glanczos_pst(w, u);
+    if(solver.update(x)) {
+      if (rank == 0) {
+        std::cout << "converged in " << j << std::endl;
+      }
+      break;
+    }
+  }
+  solver.finalize(itr, res);
+
+  // True residual norms of the local shifts, collected on rank 0
+  std::vector<double> true_res(M, 0.0);
+  for(std::size_t j=0; j<M_local; ++j){
+    std::vector<std::complex<double>> ans(x.begin()+j*N, x.begin()+(j+1)*N);
+    std::vector<std::complex<double>> tmp1(N, {0.0, 0.0}), tmp2(N, {0.0, 0.0});
+    gsminres::util::spmv(A, ans, tmp1);
+    gsminres::util::spmv(B, ans, tmp2);
+    gsminres::blas::zaxpy(N, sigma[m_begin+j], tmp2, 0, tmp1, 0);
+    gsminres::blas::zaxpy(N, {-1.0, 0.0}, b, 0, tmp1, 0);
+    true_res[m_begin+j] = gsminres::blas::dznrm2(N, tmp1);
+  }
+  MPI_Allreduce(MPI_IN_PLACE, true_res.data(), static_cast<int>(M), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  if (rank == 0) {
+    for(std::size_t j=0; j<M; ++j){
+      std::cout << std::right
+                << std::setw(2) << j << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].imag() << " "
+                << std::setw(5) << itr[j] << " "
+                << std::scientific << std::setw(12) << std::setprecision(5) << res[j] << " "
+                << std::scientific << std::setw(12) << std::setprecision(5) << true_res[j]
+                << std::endl;
+    }
+  }
+  MPI_Finalize();
+}
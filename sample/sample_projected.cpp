@@ -0,0 +1,96 @@
+/**
+ * \file sample_projected.cpp
+ * \brief C++ example of using GSMINRES++ projected-output solver with CSR format input and built-in SpMV+CG.
+ * \example sample_projected.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example computes a few elements of the solutions of
+ *          generalized shifted linear systems of the form:
+ *          \f[
+ *            z_k^{(m)} = e_{i_k}^H (A + \sigma^{(m)} B)^{-1} b, \quad (m=1,\dots,M,\ k=1,\dots,K)
+ *          \f]
+ *          using the `gsminres::ProjectedSolver`.
+ *          The solution vectors themselves are never formed.
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_projected ../data/A.csr ../data/B.csr
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include "gsminres_projected_solver.hpp"
+#include "gsminres_util.hpp"
+#include "gsminres_blas.hpp"
+
+
+int main(int argc, char* argv[]) {
+  std::size_t N, M, K = 3;
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)>" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  N = A.matrix_size;
+  const std::vector<std::complex<double>>     b = gsminres::util::generate_ones(N);
+  std::vector<std::complex<double>> sigma(10);
+  for(std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    std::complex<double> tmp = 2 * M_PI * I * (i+0.5) / 10.0;
+    sigma[i] = 0.1 * std::exp(tmp);
+  }
+  M = sigma.size();
+
+  // Projection vectors: unit vectors of the first, middle and last elements
+  std::vector<std::complex<double>> c(K*N, {0.0, 0.0});
+  const std::size_t index[3] = {0, N/2, N-1};
+  for(std::size_t k=0; k<K; ++k) {
+    c[k*N+index[k]] = {1.0, 0.0};
+  }
+
+  std::vector<std::complex<double>> z(K*M, {0.0, 0.0});
+  std::vector<std::complex<double>> w(N, {0.0, 0.0}), u(N, {0.0, 0.0});
+  std::vector<std::size_t> itr(M);
+  std::vector<double> res(M);
+
+  gsminres::ProjectedSolver solver(N, M, K);
+  if (!gsminres::util::cg(B, w, b, 1e-13, 10000)) {
+    std::cerr << "Failed" << std::endl;
+    std::exit(1);
+  }
+  solver.initialize(z, c, b, w, sigma, 1e-13);
+  for(std::size_t j=1; j<10000; ++j) {
+    gsminres::util::spmv(A, w, u);
+    solver.glanczos_pre(u);
+    if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+      std::cerr << "Failed" << std::endl;
+      std::exit(1);
+    }
+    solver.glanczos_pst(w, u);
+    if(solver.update(z)) {
+      std::cout << "converged in " << j << std::endl;
+      break;
+    }
+  }
+  solver.finalize(itr, res);
+
+  for(std::size_t k=0; k<K; ++k){
+    for(std::size_t j=0; j<M; ++j){
+      std::cout << std::right
+                << std::setw(6) << index[k] << " "
+                << std::setw(2) << j << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].real() << " "
+                << std::fixed << std::setw(10) << std::setprecision(6) << sigma[j].imag() << " "
+                << std::setw(5) << itr[j] << " "
+                << std::scientific << std::setw(12) << std::setprecision(5) << res[j] << " "
+                << std::scientific << std::setw(14) << std::setprecision(7) << z[k*M+j].real() << " "
+                << std::scientific << std::setw(14) << std::setprecision(7) << z[k*M+j].imag()
+                << std::endl;
+    }
+  }
+}
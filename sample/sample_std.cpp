@@ -11,6 +11,8 @@
  *          where \f$ I \f$ is identity matrix.
  *          Unlike the generalized shifted linear systems, this version assumes that
  *          \f$ B = I \f$, so the solver simplifies to the (standard) shifted MINRES method.
+ *          The solver is constructed in the standard mode, in which the inner linear solve
+ *          is unnecessary and `glanczos()` performs one whole Lanczos step.
  *
  *          Matrices A is given in Matrix Market format (`.mtx`) and
  *          are loaded as packed `U` Hermitian matrices.
@@ -60,18 +62,16 @@ int main(int argc, char* argv[]) {
   std::vector<std::size_t> itr(M);
   std::vector<double> res(M);
 
-  gsminres::Solver solver(N, M);
+  gsminres::Solver solver(N, M, true);
   gsminres::blas::zcopy(N, b, 0, v, 0);
   solver.initialize(x, b, v, sigma, 1e-13);
   for (std::size_t j=0; j<10000; ++j) {
     gsminres::blas::zhpmv({1.0, 0.0}, A, v, {0.0, 0.0}, Av);
-    solver.glanczos_pre(Av);
-  gsminres::blas::zcopy(N, Av, 0, v, 0);
-    solver.glanczos_pst(v, Av);
+    solver.glanczos(Av);
+    v.swap(Av);
     if (solver.update(x)) {
       break;
     }
-    solver.get_residual(res);
   }
   solver.finalize(itr, res);
 
@@ -0,0 +1,107 @@
+/**
+ * \file sample_trace.cpp
+ * \brief C++ example of the stochastic trace and diagonal estimator of GSMINRES++.
+ * \example sample_trace.cpp
+ * \author Shuntaro Hidaka
+ *
+ * \details This example estimates
+ *          \f[
+ *            \mathrm{Tr}\left[(A + \sigma^{(m)} B)^{-1} B\right], \quad (m=1,\dots,M)
+ *          \f]
+ *          using `gsminres::TraceEstimator`, with the shifts of `sample2.cpp`.
+ *          By default, Rademacher probe vectors are used until the relative standard error of every
+ *          shift is below 1%, with at most 32 probes (or the given number). Only the projections
+ *          \f$ z^H x^{(m)} \f$ are computed for the trace. With `probing`, the probe vectors are the colours of a distance-k colouring
+ *          of the graph of A (default k = 16), and the diagonals are estimated as well.
+ *          The estimates, their standard errors and the numbers of probes are printed.
+ *
+ * \par Usage:
+ * \code
+ *  $ ./sample_trace ../data/A.csr ../data/B.csr [max_probes | probing [distance]]
+ * \endcode
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include <string>
+#include "gsminres_trace_estimator.hpp"
+#include "gsminres_util.hpp"
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <CSR_file(A)> <CSR_file(B)> [max_probes | probing [distance]]" << std::endl;
+    return 1;
+  }
+  std::string Aname = argv[1], Bname = argv[2];
+  const bool probing = (argc > 3) && std::string(argv[3]) == "probing";
+  const std::size_t distance = (argc > 4) ? std::stoul(argv[4]) : 16;
+  const std::size_t max_probes = (argc > 3 && !probing) ? std::stoul(argv[3]) : 32;
+  const gsminres::util::CSRMat A = gsminres::util::load_csr_from_csr(Aname);
+  const gsminres::util::CSRMat B = gsminres::util::load_csr_from_csr(Bname);
+  const std::size_t N = A.matrix_size;
+  std::vector<std::complex<double>> sigma(10);
+  for(std::size_t i=0; i<10; i++) {
+    std::complex<double> I(0.0, 1.0);
+    std::complex<double> tmp = 2 * M_PI * I * (i+0.5) / 10.0;
+    sigma[i] = 0.1 * std::exp(tmp);
+  }
+  const std::size_t M = sigma.size();
+
+  gsminres::TraceEstimator estimator(N, sigma, probing);
+  if (probing) {
+    std::vector<std::size_t> color;
+    const std::size_t colors = gsminres::util::greedy_coloring(A, distance, color);
+    std::cout << "distance-" << distance << " colouring: " << colors << " colours" << std::endl;
+    estimator.set_coloring(color, colors);
+  } else {
+    estimator.set_stopping(1e-2, 10, max_probes);
+  }
+
+  std::vector<std::complex<double>> z(N), b(N), w(N), u(N);
+  std::size_t probes = 0, iterations = 0;
+  while (estimator.next_probe(z)) {
+    gsminres::util::spmv(B, z, b);
+    estimator.initialize(b, w, 1e-10);
+    for (std::size_t j=1; j<10000; ++j) {
+      gsminres::util::spmv(A, w, u);
+      estimator.glanczos_pre(u);
+      if (!gsminres::util::cg(B, w, u, 1e-13, 10000)) {
+        std::cerr << "Failed" << std::endl;
+        std::exit(1);
+      }
+      estimator.glanczos_pst(w, u);
+      iterations++;
+      if (estimator.update()) {
+        break;
+      }
+    }
+    probes++;
+  }
+  std::cout << probes << " probes, " << iterations << " iterations" << std::endl;
+
+  std::vector<std::complex<double>> trace;
+  std::vector<double> error;
+  std::vector<std::size_t> count;
+  std::vector<bool> stopped;
+  estimator.get_trace(trace, error);
+  estimator.get_status(count, stopped);
+  for (std::size_t m=0; m<M; ++m) {
+    std::cout << std::right
+              << std::setw(2) << m << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[m].real() << " "
+              << std::fixed << std::setw(10) << std::setprecision(6) << sigma[m].imag() << " "
+              << std::scientific << std::setw(14) << std::setprecision(6) << trace[m].real() << " "
+              << std::scientific << std::setw(14) << std::setprecision(6) << trace[m].imag() << " "
+              << std::scientific << std::setw(12) << std::setprecision(3) << error[m] << " "
+              << std::setw(5) << count[m]
+              << std::endl;
+  }
+  if (probing) {
+    std::vector<std::complex<double>> diag;
+    estimator.get_diagonal(diag);
+    std::cout << "diagonal of shift 0: " << diag[0] << " " << diag[1] << " ... " << diag[N-1] << std::endl;
+  }
+}
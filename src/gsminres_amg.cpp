@@ -0,0 +1,396 @@
+/**
+ * \file gsminres_amg.cpp
+ * \brief Implementation of the smoothed aggregation AMG preconditioner for GSMINRES++.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_amg.hpp"
+#include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace gsminres {
+  namespace util {
+
+    namespace {
+      constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+      /**
+       * \brief Sparse matrix product \f$ C = XY \f$ (Gustavson's algorithm, rows in parallel).
+       * \param[in] X    Left matrix.
+       * \param[in] Y    Right matrix.
+       * \param[in] cols Number of columns of Y.
+       * \return Product (column indices unsorted within a row).
+       */
+      CSRMat spgemm(const CSRMat& X, const CSRMat& Y, std::size_t cols) {
+        const std::size_t rows = X.matrix_size;
+        std::vector<std::size_t> count(rows+1, 0);
+        // Symbolic phase: number of entries of every row
+        #pragma omp parallel
+        {
+          std::vector<std::size_t> marker(cols, npos);
+          #pragma omp for schedule(dynamic, 64)
+          for (std::size_t i=0; i < rows; ++i) {
+            std::size_t nnz = 0;
+            for (std::size_t jx=X.row_pointer[i]; jx < X.row_pointer[i+1]; ++jx) {
+              const std::size_t k = X.col_indices[jx];
+              for (std::size_t jy=Y.row_pointer[k]; jy < Y.row_pointer[k+1]; ++jy) {
+                const std::size_t c = Y.col_indices[jy];
+                if (marker[c] != i) {
+                  marker[c] = i;
+                  nnz++;
+                }
+              }
+            }
+            count[i+1] = nnz;
+          }
+        }
+        for (std::size_t i=0; i < rows; ++i) {
+          count[i+1] += count[i];
+        }
+        CSRMat C(rows+1, count[rows]);
+        C.row_pointer = count;
+        // Numeric phase: position of column c in the current row
+        #pragma omp parallel
+        {
+          std::vector<std::size_t> marker(cols, npos), position(cols, 0);
+          #pragma omp for schedule(dynamic, 64)
+          for (std::size_t i=0; i < rows; ++i) {
+            std::size_t pos = C.row_pointer[i];
+            for (std::size_t jx=X.row_pointer[i]; jx < X.row_pointer[i+1]; ++jx) {
+              const std::size_t          k = X.col_indices[jx];
+              const std::complex<double> a = X.values[jx];
+              for (std::size_t jy=Y.row_pointer[k]; jy < Y.row_pointer[k+1]; ++jy) {
+                const std::size_t c = Y.col_indices[jy];
+                if (marker[c] != i) {
+                  marker[c]          = i;
+                  position[c]        = pos;
+                  C.col_indices[pos] = c;
+                  C.values[pos]      = a*Y.values[jy];
+                  pos++;
+                } else {
+                  C.values[position[c]] += a*Y.values[jy];
+                }
+              }
+            }
+          }
+        }
+        return C;
+      }
+
+      /**
+       * \brief Conjugate transpose of a sparse matrix.
+       * \param[in] X    Matrix.
+       * \param[in] cols Number of columns of X.
+       * \return \f$ X^H \f$.
+       */
+      CSRMat conj_transpose(const CSRMat& X, std::size_t cols) {
+        const std::size_t rows = X.matrix_size;
+        const std::size_t nnz  = X.row_pointer[rows];
+        CSRMat T(cols+1, nnz);
+        for (std::size_t j=0; j < nnz; ++j) {
+          T.row_pointer[X.col_indices[j]+1]++;
+        }
+        for (std::size_t c=0; c < cols; ++c) {
+          T.row_pointer[c+1] += T.row_pointer[c];
+        }
+        std::vector<std::size_t> pos(T.row_pointer.begin(), T.row_pointer.end()-1);
+        for (std::size_t i=0; i < rows; ++i) {
+          for (std::size_t j=X.row_pointer[i]; j < X.row_pointer[i+1]; ++j) {
+            const std::size_t p = pos[X.col_indices[j]]++;
+            T.col_indices[p] = i;
+            T.values[p]      = std::conj(X.values[j]);
+          }
+        }
+        return T;
+      }
+
+      /**
+       * \brief Diagonal of a Hermitian matrix.
+       */
+      std::vector<double> diagonal(const CSRMat& A, const char* caller) {
+        const std::size_t n = A.matrix_size;
+        std::vector<double> d(n, 0.0);
+        bool positive = true;
+        #pragma omp parallel for reduction(&&:positive)
+        for (std::size_t i=0; i < n; ++i) {
+          for (std::size_t j=A.row_pointer[i]; j < A.row_pointer[i+1]; ++j) {
+            if (A.col_indices[j] == i) {
+              d[i] += A.values[j].real();
+            }
+          }
+          positive = positive && (d[i] > 0.0);
+        }
+        if (!positive) {
+          std::cerr << caller << ": [ERROR] The matrix has a non-positive diagonal element" << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+        return d;
+      }
+
+      /**
+       * \brief Estimate the spectral radius of \f$ D^{-1}A \f$ by the power method.
+       */
+      double spectral_radius(const CSRMat& A, const std::vector<double>& inv_diag) {
+        const std::size_t n = A.matrix_size;
+        std::vector<std::complex<double>> v(n), Av(n);
+        for (std::size_t i=0; i < n; ++i) {
+          v[i] = std::sin(1.0 + static_cast<double>(i));
+        }
+        blas::zdscal(n, 1.0/blas::dznrm2(n, v), v);
+        double rho = 0.0;
+        for (int it=0; it < 15; ++it) {
+          spmv(A, v, Av);
+          #pragma omp parallel for
+          for (std::size_t i=0; i < n; ++i) {
+            Av[i] *= inv_diag[i];
+          }
+          rho = blas::dznrm2(n, Av);
+          if (rho == 0.0) {
+            break;
+          }
+          blas::zcopy(n, Av, 0, v, 0);
+          blas::zdscal(n, 1.0/rho, v);
+        }
+        // The power method approaches the spectral radius from below
+        return 1.1*rho;
+      }
+
+      /**
+       * \brief Greedy aggregation of the strength graph.
+       * \param[in]  A        Matrix.
+       * \param[in]  d        Diagonal of A.
+       * \param[in]  theta    Strength threshold.
+       * \param[out] agg      Aggregate of every node.
+       * \param[out] agg_size Size of every aggregate.
+       */
+      void aggregate(const CSRMat& A, const std::vector<double>& d, double theta,
+                     std::vector<std::size_t>& agg, std::vector<std::size_t>& agg_size) {
+        const std::size_t n = A.matrix_size;
+        const double theta2 = theta*theta;
+        // Strength graph (threaded: count, then fill)
+        std::vector<std::size_t> S_ptr(n+1, 0);
+        #pragma omp parallel for
+        for (std::size_t i=0; i < n; ++i) {
+          std::size_t cnt = 0;
+          for (std::size_t j=A.row_pointer[i]; j < A.row_pointer[i+1]; ++j) {
+            const std::size_t c = A.col_indices[j];
+            if (c != i && std::norm(A.values[j]) >= theta2*d[i]*d[c]) {
+              cnt++;
+            }
+          }
+          S_ptr[i+1] = cnt;
+        }
+        for (std::size_t i=0; i < n; ++i) {
+          S_ptr[i+1] += S_ptr[i];
+        }
+        std::vector<std::size_t> S_idx(S_ptr[n]);
+        std::vector<double>      S_val(S_ptr[n]);
+        #pragma omp parallel for
+        for (std::size_t i=0; i < n; ++i) {
+          std::size_t pos = S_ptr[i];
+          for (std::size_t j=A.row_pointer[i]; j < A.row_pointer[i+1]; ++j) {
+            const std::size_t c = A.col_indices[j];
+            const double      s = std::norm(A.values[j]);
+            if (c != i && s >= theta2*d[i]*d[c]) {
+              S_idx[pos] = c;
+              S_val[pos] = s/(d[i]*d[c]);
+              pos++;
+            }
+          }
+        }
+
+        agg.assign(n, npos);
+        agg_size.clear();
+        // Phase 1: nodes whose strong neighborhood is entirely free form an aggregate with it
+        for (std::size_t i=0; i < n; ++i) {
+          if (agg[i] != npos) {
+            continue;
+          }
+          bool free = true;
+          for (std::size_t j=S_ptr[i]; j < S_ptr[i+1] && free; ++j) {
+            free = (agg[S_idx[j]] == npos);
+          }
+          if (!free) {
+            continue;
+          }
+          const std::size_t a = agg_size.size();
+          agg[i] = a;
+          for (std::size_t j=S_ptr[i]; j < S_ptr[i+1]; ++j) {
+            agg[S_idx[j]] = a;
+          }
+          agg_size.push_back(1 + S_ptr[i+1]-S_ptr[i]);
+        }
+        // Phase 2: remaining nodes join the aggregate of their strongest phase-1 neighbor
+        const std::vector<std::size_t> agg1(agg);
+        for (std::size_t i=0; i < n; ++i) {
+          if (agg1[i] != npos) {
+            continue;
+          }
+          double best = -1.0;
+          for (std::size_t j=S_ptr[i]; j < S_ptr[i+1]; ++j) {
+            if (agg1[S_idx[j]] != npos && S_val[j] > best) {
+              best   = S_val[j];
+              agg[i] = agg1[S_idx[j]];
+            }
+          }
+          if (agg[i] != npos) {
+            agg_size[agg[i]]++;
+          }
+        }
+        // Phase 3: the rest form aggregates with their free strong neighbors
+        for (std::size_t i=0; i < n; ++i) {
+          if (agg[i] != npos) {
+            continue;
+          }
+          const std::size_t a = agg_size.size();
+          agg[i] = a;
+          agg_size.push_back(1);
+          for (std::size_t j=S_ptr[i]; j < S_ptr[i+1]; ++j) {
+            if (agg[S_idx[j]] == npos) {
+              agg[S_idx[j]] = a;
+              agg_size[a]++;
+            }
+          }
+        }
+      }
+
+      /**
+       * \brief Smoothed prolongator \f$ P = (I - \omega D^{-1}A)T \f$ with the tentative prolongator T.
+       */
+      CSRMat smoothed_prolongator(const CSRMat& A, const std::vector<double>& inv_diag, double omega,
+                                  const std::vector<std::size_t>& agg,
+                                  const std::vector<std::size_t>& agg_size) {
+        const std::size_t n  = A.matrix_size;
+        const std::size_t nc = agg_size.size();
+        CSRMat T(n+1, n);
+        for (std::size_t i=0; i < n; ++i) {
+          T.row_pointer[i+1] = i+1;
+          T.col_indices[i]   = agg[i];
+          T.values[i]        = 1.0/std::sqrt(static_cast<double>(agg_size[agg[i]]));
+        }
+        CSRMat P = spgemm(A, T, nc);
+        #pragma omp parallel for
+        for (std::size_t i=0; i < n; ++i) {
+          const double s = -omega*inv_diag[i];
+          for (std::size_t j=P.row_pointer[i]; j < P.row_pointer[i+1]; ++j) {
+            P.values[j] *= s;
+            if (P.col_indices[j] == agg[i]) {
+              P.values[j] += T.values[i];
+            }
+          }
+        }
+        return P;
+      }
+
+      /**
+       * \brief Damped Jacobi sweeps \f$ x \leftarrow x + \omega D^{-1}(b - Ax) \f$.
+       */
+      void jacobi(const AMGLevel& L, std::size_t steps, bool zero_guess) {
+        const std::size_t n = L.A.matrix_size;
+        for (std::size_t s=0; s < steps; ++s) {
+          if (s == 0 && zero_guess) {
+            #pragma omp parallel for
+            for (std::size_t i=0; i < n; ++i) {
+              L.x[i] = L.omega*L.inv_diag[i]*L.b[i];
+            }
+            continue;
+          }
+          spmv(L.A, L.x, L.r);
+          #pragma omp parallel for
+          for (std::size_t i=0; i < n; ++i) {
+            L.x[i] += L.omega*L.inv_diag[i]*(L.b[i]-L.r[i]);
+          }
+        }
+      }
+
+      void vcycle(const AMGHierarchy& H, std::size_t l) {
+        const AMGLevel&   L = H.levels[l];
+        const std::size_t n = L.A.matrix_size;
+        if (l+1 == H.levels.size()) {
+          if (!H.coarse_factor.empty()) {
+            lapack::zpptrs(static_cast<int>(n), H.coarse_factor, L.x, L.b);
+          } else {
+            jacobi(L, 2*H.smoothing_steps, true);
+          }
+          return;
+        }
+        const AMGLevel& C = H.levels[l+1];
+        jacobi(L, H.smoothing_steps, true);
+        spmv(L.A, L.x, L.r);
+        #pragma omp parallel for
+        for (std::size_t i=0; i < n; ++i) {
+          L.r[i] = L.b[i]-L.r[i];
+        }
+        spmv(L.R, L.r, C.b);
+        vcycle(H, l+1);
+        spmv(L.P, C.x, L.r);
+        blas::zaxpy(n, {1.0, 0.0}, L.r, 0, L.x, 0);
+        jacobi(L, H.smoothing_steps, false);
+      }
+    }
+
+    AMGHierarchy amg_setup(const CSRMat& A, const AMGParam& param) {
+      AMGHierarchy H;
+      H.smoothing_steps = param.smoothing_steps > 0 ? param.smoothing_steps : 1;
+      H.levels.emplace_back();
+      H.levels[0].A = A;
+      while (true) {
+        AMGLevel&         L = H.levels.back();
+        const std::size_t n = L.A.matrix_size;
+        const std::vector<double> d = diagonal(L.A, "amg_setup");
+        L.inv_diag.resize(n);
+        for (std::size_t i=0; i < n; ++i) {
+          L.inv_diag[i] = 1.0/d[i];
+        }
+        L.omega = 4.0/(3.0*spectral_radius(L.A, L.inv_diag));
+        L.x.assign(n, {0.0, 0.0});
+        L.b.assign(n, {0.0, 0.0});
+        L.r.assign(n, {0.0, 0.0});
+        if (n <= param.coarse_size || H.levels.size() >= param.max_levels) {
+          break;
+        }
+        std::vector<std::size_t> agg, agg_size;
+        aggregate(L.A, d, param.strength, agg, agg_size);
+        const std::size_t nc = agg_size.size();
+        if (10*nc > 9*n) {
+          // Coarsening stalled: the matrix is strongly diagonally dominant, Jacobi suffices
+          break;
+        }
+        L.P = smoothed_prolongator(L.A, L.inv_diag, L.omega, agg, agg_size);
+        L.R = conj_transpose(L.P, nc);
+        CSRMat Ac = spgemm(L.R, spgemm(L.A, L.P, nc), nc);
+        H.levels.emplace_back();
+        H.levels.back().A = std::move(Ac);
+      }
+      // Dense Cholesky factorization of the coarsest matrix (packed upper triangle)
+      const CSRMat&     Ac = H.levels.back().A;
+      const std::size_t nc = Ac.matrix_size;
+      if (nc <= param.coarse_size) {
+        H.coarse_factor.assign(nc*(nc+1)/2, {0.0, 0.0});
+        for (std::size_t i=0; i < nc; ++i) {
+          for (std::size_t j=Ac.row_pointer[i]; j < Ac.row_pointer[i+1]; ++j) {
+            const std::size_t c = Ac.col_indices[j];
+            if (i <= c) {
+              H.coarse_factor[i + c*(c+1)/2] += Ac.values[j];
+            }
+          }
+        }
+        lapack::zpptrf(static_cast<int>(nc), H.coarse_factor);
+      }
+      return H;
+    }
+
+    void amg_vcycle(const AMGHierarchy& H, const std::vector<std::complex<double>>& r, std::vector<std::complex<double>>& z) {
+      const std::size_t n = H.levels[0].A.matrix_size;
+      blas::zcopy(n, r, 0, H.levels[0].b, 0);
+      vcycle(H, 0);
+      blas::zcopy(n, H.levels[0].x, 0, z, 0);
+    }
+
+  }  // namespace util
+}  // namespace gsminres
@@ -0,0 +1,176 @@
+/**
+ * \file gsminres_batch_solver.cpp
+ * \brief Implementation of the GSMINRES++ batched solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_batch_solver.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace gsminres {
+
+  BatchSolver::BatchSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t rhs_size)
+    : iter_(1),
+      matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      rhs_size_(rhs_size),
+      r0_norm_(rhs_size, 0.0),
+      sigma_(shift_size, {0.0, 0.0}),
+      alpha_(rhs_size, 0.0),
+      beta_prev_(rhs_size, 0.0),
+      beta_curr_(rhs_size, 0.0),
+      w_prev_(rhs_size*matrix_size, {0.0, 0.0}),
+      w_curr_(rhs_size*matrix_size, {0.0, 0.0}),
+      w_next_(rhs_size*matrix_size, {0.0, 0.0}),
+      u_prev_(rhs_size*matrix_size, {0.0, 0.0}),
+      u_curr_(rhs_size*matrix_size, {0.0, 0.0}),
+      u_next_(rhs_size*matrix_size, {0.0, 0.0}),
+      T_prev2_(1, {0.0, 0.0}),
+      T_prev_( 1, {0.0, 0.0}),
+      T_curr_( 1, {0.0, 0.0}),
+      T_next_( 1, {0.0, 0.0}),
+      Gc_(rhs_size*shift_size, std::array<double, 3>{0.0, 0.0, 0.0}),
+      Gs_(rhs_size*shift_size, std::array<std::complex<double>, 3>{{{0.0,0.0}, {0.0,0.0}, {0.0,0.0}}}),
+      p_prev2_(rhs_size*shift_size*matrix_size, {0.0, 0.0}),
+      p_prev_( rhs_size*shift_size*matrix_size, {0.0, 0.0}),
+      p_curr_( rhs_size*shift_size*matrix_size, {0.0, 0.0}),
+      f_(rhs_size*shift_size, {1.0, 0.0}),
+      h_(rhs_size*shift_size, 1.0),
+      conv_num_(0),
+      is_conv_(rhs_size*shift_size, 0),
+      rhs_conv_num_(rhs_size, 0),
+      threshold_(1e-12) {
+  }
+
+  void BatchSolver::initialize(std::vector<std::complex<double>>& x,
+                               const std::vector<std::complex<double>>& b,
+                               std::vector<std::complex<double>>& w,
+                               const std::vector<std::complex<double>>& sigma,
+                               const double threshold) {
+    blas::zdscal(rhs_size_*shift_size_*matrix_size_, 0.0, x);
+    blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
+    threshold_ = threshold;
+    for (std::size_t k=0; k<rhs_size_; k++) {
+      std::size_t offset = k*matrix_size_;
+      r0_norm_[k] = std::sqrt((blas::zdotc(matrix_size_, b, offset, w, offset)).real());
+      if (r0_norm_[k] == 0.0) {
+        // x = 0 is the exact solution for a zero right-hand side
+        for (std::size_t m=0; m<shift_size_; m++) {
+          is_conv_[k*shift_size_+m] = iter_;
+          h_[k*shift_size_+m] = 0.0;
+        }
+        conv_num_ += shift_size_;
+        rhs_conv_num_[k] = shift_size_;
+        blas::zdscal(matrix_size_, 0.0, w, offset);
+        continue;
+      }
+      blas::zcopy(matrix_size_, w, offset, w_curr_, offset);
+      blas::zcopy(matrix_size_, b, offset, u_curr_, offset);
+      blas::zdscal(matrix_size_, 1.0/r0_norm_[k], w_curr_, offset);
+      blas::zdscal(matrix_size_, 1.0/r0_norm_[k], u_curr_, offset);
+      blas::zcopy(matrix_size_, w_curr_, offset, w, offset);
+      blas::dscal(shift_size_, r0_norm_[k], h_, k*shift_size_);
+    }
+  }
+
+  void BatchSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    for (std::size_t k=0; k<rhs_size_; k++) {
+      if (is_converged(k)) {
+        continue;
+      }
+      std::size_t offset = k*matrix_size_;
+      alpha_[k] = (blas::zdotc(matrix_size_, w_curr_, offset, u, offset)).real();
+      blas::zaxpy(matrix_size_, -alpha_[k],     u_curr_, offset, u, offset);
+      blas::zaxpy(matrix_size_, -beta_prev_[k], u_prev_, offset, u, offset);
+    }
+  }
+
+  void BatchSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                 std::vector<std::complex<double>>& u) {
+    for (std::size_t k=0; k<rhs_size_; k++) {
+      std::size_t offset = k*matrix_size_;
+      if (is_converged(k)) {
+        // Keep the columns of finished systems at zero so that they cost nothing meaningful
+        // in the user's multi-vector operations and cannot produce a breakdown.
+        blas::zdscal(matrix_size_, 0.0, w, offset);
+        blas::zdscal(matrix_size_, 0.0, u, offset);
+        continue;
+      }
+      beta_curr_[k] = std::sqrt((blas::zdotc(matrix_size_, u, offset, w, offset)).real());
+      blas::zdscal(matrix_size_, 1.0/beta_curr_[k], w, offset);
+      blas::zdscal(matrix_size_, 1.0/beta_curr_[k], u, offset);
+    }
+    blas::zcopy(rhs_size_*matrix_size_, w, 0, w_next_, 0);
+    blas::zcopy(rhs_size_*matrix_size_, u, 0, u_next_, 0);
+  }
+
+  bool BatchSolver::update(std::vector<std::complex<double>>& x) {
+    for (std::size_t k=0; k<rhs_size_; k++) {
+      if (is_converged(k)) {
+        continue;
+      }
+      for (std::size_t m=0; m<shift_size_; m++) {
+        std::size_t km = k*shift_size_ + m;
+        if (is_conv_[km] != 0) {
+          continue;
+        }
+        T_prev2_[0] = 0.0;
+        T_prev_[0]  = beta_prev_[k];
+        T_curr_[0]  = alpha_[k] + sigma_[m];
+        T_next_[0]  = beta_curr_[k];
+        if (iter_ >= 3) {
+          blas::zrot(1, T_prev2_, 0, T_prev_, 0, Gc_[km][0], Gs_[km][0]);
+        }
+        if (iter_ >= 2) {
+          blas::zrot(1, T_prev_,  0, T_curr_, 0, Gc_[km][1], Gs_[km][1]);
+        }
+        blas::zrotg(T_curr_[0], T_next_[0], Gc_[km][2], Gs_[km][2]);
+        std::size_t offset = km*matrix_size_;
+        blas::zcopy(matrix_size_, p_prev_, offset, p_prev2_, offset);
+        blas::zcopy(matrix_size_, p_curr_, offset, p_prev_,  offset);
+        blas::zcopy(matrix_size_, w_curr_, k*matrix_size_, p_curr_, offset);
+        blas::zaxpy(matrix_size_, -T_prev2_[0], p_prev2_, offset, p_curr_, offset);
+        blas::zaxpy(matrix_size_, -T_prev_[0],  p_prev_,  offset, p_curr_, offset);
+        blas::zscal(matrix_size_, 1.0/T_curr_[0], p_curr_, offset);
+        blas::zaxpy(matrix_size_, r0_norm_[k]*Gc_[km][2]*f_[km], p_curr_, offset, x, offset);
+        f_[km] = -std::conj(Gs_[km][2]) * f_[km];
+        h_[km] = std::abs(-std::conj(Gs_[km][2])) * h_[km];
+        if (h_[km]/r0_norm_[k] < threshold_) {
+          conv_num_++;
+          rhs_conv_num_[k]++;
+          is_conv_[km] = iter_;
+          continue;
+        }
+        Gc_[km][0] = Gc_[km][1]; Gc_[km][1] = Gc_[km][2];
+        Gs_[km][0] = Gs_[km][1]; Gs_[km][1] = Gs_[km][2];
+      }
+    }
+    beta_prev_ = beta_curr_;
+    blas::zcopy(rhs_size_*matrix_size_, w_curr_, 0, w_prev_, 0);
+    blas::zcopy(rhs_size_*matrix_size_, w_next_, 0, w_curr_, 0);
+    blas::zcopy(rhs_size_*matrix_size_, u_curr_, 0, u_prev_, 0);
+    blas::zcopy(rhs_size_*matrix_size_, u_next_, 0, u_curr_, 0);
+    iter_++;
+    if (conv_num_ >= rhs_size_*shift_size_) {
+      return true;
+    }
+    return false;
+  }
+
+  void BatchSolver::finalize(std::vector<std::size_t>& conv_itr,
+                             std::vector<double>&      conv_res) {
+    conv_itr = is_conv_;
+    conv_res = h_;
+  }
+
+  void BatchSolver::get_residual(std::vector<double>& res) const {
+    blas::dcopy(rhs_size_*shift_size_, h_, 0, res, 0);
+  }
+
+  bool BatchSolver::is_converged(std::size_t k) const {
+    return rhs_conv_num_[k] >= shift_size_;
+  }
+
+}  // namespace gsminres
@@ -0,0 +1,278 @@
+/**
+ * \file gsminres_block_solver.cpp
+ * \brief Implementation of the GSMINRES++ block solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_block_solver.hpp"
+#include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include <iostream>
+#include <cmath>
+#include <utility>
+
+namespace gsminres {
+
+  BlockSolver::BlockSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t block_size)
+    : iter_(1),
+      matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      block_size_(block_size),
+      r0_norm_(block_size, 0.0),
+      sigma_(shift_size, {0.0, 0.0}),
+      alpha_(block_size*block_size, {0.0, 0.0}),
+      beta_prev_(block_size*block_size, {0.0, 0.0}),
+      beta_curr_(block_size*block_size, {0.0, 0.0}),
+      w_prev_(block_size*matrix_size, {0.0, 0.0}),
+      w_curr_(block_size*matrix_size, {0.0, 0.0}),
+      w_next_(block_size*matrix_size, {0.0, 0.0}),
+      u_prev_(block_size*matrix_size, {0.0, 0.0}),
+      u_curr_(block_size*matrix_size, {0.0, 0.0}),
+      u_next_(block_size*matrix_size, {0.0, 0.0}),
+      deflated_(block_size, false),
+      deflation_tol_(1e-14),
+      Q_prev2_(shift_size*2*block_size*block_size, {0.0, 0.0}),
+      Q_prev_( shift_size*2*block_size*block_size, {0.0, 0.0}),
+      tau_prev2_(shift_size*block_size, {0.0, 0.0}),
+      tau_prev_( shift_size*block_size, {0.0, 0.0}),
+      p_prev2_(shift_size*matrix_size*block_size, {0.0, 0.0}),
+      p_prev_( shift_size*matrix_size*block_size, {0.0, 0.0}),
+      work_(matrix_size*block_size, {0.0, 0.0}),
+      g_(shift_size*block_size*block_size, {0.0, 0.0}),
+      h_(block_size*shift_size, 1.0),
+      conv_num_(0),
+      is_conv_(block_size*shift_size, 0),
+      shift_conv_num_(shift_size, 0),
+      threshold_(1e-12) {
+  }
+
+  void BlockSolver::initialize(std::vector<std::complex<double>>& x,
+                               const std::vector<std::complex<double>>& b,
+                               std::vector<std::complex<double>>& w,
+                               const std::vector<std::complex<double>>& sigma,
+                               const double threshold) {
+    const std::size_t N = matrix_size_, L = block_size_;
+    blas::zdscal(L*shift_size_*N, 0.0, x);
+    blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
+    threshold_ = threshold;
+    // B-orthonormalize the right-hand sides, b = U_1 R_0
+    std::vector<std::complex<double>> G(L*L), R0(L*L);
+    blas::zgemm('C', 'N', L, L, N, {1.0, 0.0}, b, 0, N, w, 0, N, {0.0, 0.0}, G, 0, L);
+    cholesky_deflate(G, R0);
+    blas::zcopy(L*N, w, 0, w_curr_, 0);
+    blas::zcopy(L*N, b, 0, u_curr_, 0);
+    normalize_block(R0, w_curr_);
+    normalize_block(R0, u_curr_);
+    blas::zcopy(L*N, w_curr_, 0, w, 0);
+    for (std::size_t m=0; m<shift_size_; m++) {
+      blas::zcopy(L*L, R0, 0, g_, m*L*L);
+    }
+    for (std::size_t l=0; l<L; l++) {
+      r0_norm_[l] = std::sqrt(G[l*L+l].real());
+      for (std::size_t m=0; m<shift_size_; m++) {
+        h_[l*shift_size_+m] = r0_norm_[l];
+        if (r0_norm_[l] == 0.0) {
+          // x = 0 is the exact solution for a zero right-hand side
+          is_conv_[l*shift_size_+m] = iter_;
+          shift_conv_num_[m]++;
+          conv_num_++;
+        }
+      }
+    }
+  }
+
+  void BlockSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    const std::size_t N = matrix_size_, L = block_size_;
+    blas::zgemm('C', 'N', L, L, N, {1.0, 0.0}, w_curr_, 0, N, u, 0, N, {0.0, 0.0}, alpha_, 0, L);
+    // alpha is Hermitian in exact arithmetic
+    for (std::size_t j=0; j<L; j++) {
+      alpha_[j*L+j] = alpha_[j*L+j].real();
+      for (std::size_t i=0; i<j; i++) {
+        std::complex<double> a = 0.5 * (alpha_[j*L+i] + std::conj(alpha_[i*L+j]));
+        alpha_[j*L+i] = a;
+        alpha_[i*L+j] = std::conj(a);
+      }
+    }
+    blas::zgemm('N', 'N', N, L, L, {-1.0, 0.0}, u_curr_, 0, N, alpha_,    0, L, {1.0, 0.0}, u, 0, N);
+    blas::zgemm('N', 'C', N, L, L, {-1.0, 0.0}, u_prev_, 0, N, beta_prev_, 0, L, {1.0, 0.0}, u, 0, N);
+  }
+
+  void BlockSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                 std::vector<std::complex<double>>& u) {
+    const std::size_t N = matrix_size_, L = block_size_;
+    std::vector<std::complex<double>> G(L*L), R(L*L);
+    // Cholesky QR twice: the second pass restores the B-orthogonality lost by the first
+    // when the block is ill-conditioned. Since U = BW, no additional inner solve is needed.
+    blas::zgemm('C', 'N', L, L, N, {1.0, 0.0}, u, 0, N, w, 0, N, {0.0, 0.0}, G, 0, L);
+    cholesky_deflate(G, beta_curr_);
+    normalize_block(beta_curr_, w);
+    normalize_block(beta_curr_, u);
+    blas::zgemm('C', 'N', L, L, N, {1.0, 0.0}, u, 0, N, w, 0, N, {0.0, 0.0}, G, 0, L);
+    cholesky_deflate(G, R);
+    normalize_block(R, w);
+    normalize_block(R, u);
+    blas::ztrmm('L', 'U', 'N', 'N', L, L, {1.0, 0.0}, R, 0, L, beta_curr_, 0, L);
+    blas::zcopy(L*N, w, 0, w_next_, 0);
+    blas::zcopy(L*N, u, 0, u_next_, 0);
+  }
+
+  bool BlockSolver::update(std::vector<std::complex<double>>& x) {
+    const std::size_t N = matrix_size_, L = block_size_, M = shift_size_;
+    const int L1 = static_cast<int>(L), L2 = static_cast<int>(2*L);
+    std::vector<std::complex<double>> top(2*L*L), mid(2*L*L), rhs(2*L*L);
+    std::vector<std::complex<double>> R2(L*L), R1(L*L), Rjj(L*L);
+    for (std::size_t m=0; m<M; m++) {
+      if (shift_conv_num_[m] >= L) {
+        continue;
+      }
+      const std::size_t q_off = m*2*L*L, t_off = m*L, g_off = m*L*L, p_off = m*N*L;
+      // Apply the last two block reflectors to the new block column of T
+      for (std::size_t j=0; j<L; j++) {
+        for (std::size_t i=0; i<L; i++) {
+          top[j*2*L+i]   = {0.0, 0.0};
+          top[j*2*L+L+i] = std::conj(beta_prev_[i*L+j]);
+        }
+      }
+      if (iter_ >= 3) {
+        lapack::zunmqr('L', 'C', L2, L1, L1, Q_prev2_, q_off, L2, tau_prev2_, t_off, top, 0, L2);
+      }
+      for (std::size_t j=0; j<L; j++) {
+        for (std::size_t i=0; i<L; i++) {
+          R2[j*L+i]      = top[j*2*L+i];
+          mid[j*2*L+i]   = top[j*2*L+L+i];
+          mid[j*2*L+L+i] = alpha_[j*L+i] + (i == j ? sigma_[m] : 0.0);
+        }
+      }
+      if (iter_ >= 2) {
+        lapack::zunmqr('L', 'C', L2, L1, L1, Q_prev_, q_off, L2, tau_prev_, t_off, mid, 0, L2);
+      }
+      // New block reflector, stored in the slot of the oldest one
+      for (std::size_t j=0; j<L; j++) {
+        for (std::size_t i=0; i<L; i++) {
+          R1[j*L+i] = mid[j*2*L+i];
+          Q_prev2_[q_off+j*2*L+i]   = mid[j*2*L+L+i];
+          Q_prev2_[q_off+j*2*L+L+i] = beta_curr_[j*L+i];
+        }
+      }
+      lapack::zgeqrf(L2, L1, Q_prev2_, q_off, L2, tau_prev2_, t_off);
+      for (std::size_t j=0; j<L; j++) {
+        for (std::size_t i=0; i<L; i++) {
+          Rjj[j*L+i]     = (i <= j) ? Q_prev2_[q_off+j*2*L+i] : 0.0;
+          rhs[j*2*L+i]   = g_[g_off+j*L+i];
+          rhs[j*2*L+L+i] = {0.0, 0.0};
+        }
+      }
+      lapack::zunmqr('L', 'C', L2, L1, L1, Q_prev2_, q_off, L2, tau_prev2_, t_off, rhs, 0, L2);
+      // P_j = (W_j - P_{j-2} R_{j-2,j} - P_{j-1} R_{j-1,j}) R_{j,j}^{-1}
+      blas::zcopy(N*L, w_curr_, 0, work_, 0);
+      if (iter_ >= 3) {
+        blas::zgemm('N', 'N', N, L, L, {-1.0, 0.0}, p_prev2_, p_off, N, R2, 0, L, {1.0, 0.0}, work_, 0, N);
+      }
+      if (iter_ >= 2) {
+        blas::zgemm('N', 'N', N, L, L, {-1.0, 0.0}, p_prev_,  p_off, N, R1, 0, L, {1.0, 0.0}, work_, 0, N);
+      }
+      blas::ztrsm('R', 'U', 'N', 'N', N, L, {1.0, 0.0}, Rjj, 0, L, work_, 0, N);
+      blas::zcopy(N*L, work_, 0, p_prev2_, p_off);
+      // X^{(m)} += P_j tau_j for the columns that have not converged yet
+      for (std::size_t l=0; l<L; l++) {
+        std::size_t lm = l*M + m;
+        if (is_conv_[lm] != 0) {
+          continue;
+        }
+        blas::zgemm('N', 'N', N, 1, L, {1.0, 0.0}, p_prev2_, p_off, N, rhs, l*2*L, L, {1.0, 0.0}, x, lm*N, N);
+        h_[lm] = blas::dznrm2(L, rhs, l*2*L+L);
+        if (h_[lm]/r0_norm_[l] < threshold_) {
+          conv_num_++;
+          shift_conv_num_[m]++;
+          is_conv_[lm] = iter_;
+        }
+      }
+      for (std::size_t j=0; j<L; j++) {
+        blas::zcopy(L, rhs, j*2*L+L, g_, g_off+j*L);
+      }
+    }
+    // The newest reflectors and direction blocks were written into the oldest slots
+    std::swap(Q_prev2_,   Q_prev_);
+    std::swap(tau_prev2_, tau_prev_);
+    std::swap(p_prev2_,   p_prev_);
+    beta_prev_ = beta_curr_;
+    std::swap(w_prev_, w_curr_);
+    std::swap(w_curr_, w_next_);
+    std::swap(u_prev_, u_curr_);
+    std::swap(u_curr_, u_next_);
+    iter_++;
+    if (conv_num_ >= block_size_*shift_size_) {
+      return true;
+    }
+    return false;
+  }
+
+  void BlockSolver::finalize(std::vector<std::size_t>& conv_itr,
+                             std::vector<double>&      conv_res) {
+    conv_itr = is_conv_;
+    conv_res = h_;
+  }
+
+  void BlockSolver::get_residual(std::vector<double>& res) const {
+    blas::dcopy(block_size_*shift_size_, h_, 0, res, 0);
+  }
+
+  std::size_t BlockSolver::get_deflated() const {
+    std::size_t num = 0;
+    for (std::size_t l=0; l<block_size_; l++) {
+      if (deflated_[l]) num++;
+    }
+    return num;
+  }
+
+  void BlockSolver::set_deflation_tolerance(const double tol) {
+    deflation_tol_ = tol;
+  }
+
+  void BlockSolver::cholesky_deflate(const std::vector<std::complex<double>>& G,
+                                     std::vector<std::complex<double>>& R) {
+    const std::size_t L = block_size_;
+    for (std::size_t j=0; j<L; j++) {
+      for (std::size_t i=0; i<j; i++) {
+        std::complex<double> s = G[j*L+i];
+        for (std::size_t k=0; k<i; k++) {
+          s -= std::conj(R[i*L+k]) * R[j*L+k];
+        }
+        R[j*L+i] = deflated_[i] ? std::complex<double>(0.0, 0.0) : s / R[i*L+i];
+      }
+      double d = G[j*L+j].real();
+      for (std::size_t k=0; k<j; k++) {
+        d -= std::norm(R[j*L+k]);
+      }
+      if (deflated_[j] || d <= deflation_tol_ * G[j*L+j].real()) {
+        deflated_[j] = true;
+        R[j*L+j] = {0.0, 0.0};
+      } else {
+        R[j*L+j] = std::sqrt(d);
+      }
+      for (std::size_t i=j+1; i<L; i++) {
+        R[j*L+i] = {0.0, 0.0};
+      }
+    }
+  }
+
+  void BlockSolver::normalize_block(const std::vector<std::complex<double>>& R,
+                                    std::vector<std::complex<double>>& V) {
+    const std::size_t N = matrix_size_, L = block_size_;
+    // Deflated columns get a unit diagonal so that the triangular solve is well defined,
+    // and are zeroed afterwards. Their rows of R are zero, so the other columns are unaffected.
+    std::vector<std::complex<double>> Rt(R);
+    for (std::size_t l=0; l<L; l++) {
+      if (deflated_[l]) {
+        Rt[l*L+l] = {1.0, 0.0};
+      }
+    }
+    blas::ztrsm('R', 'U', 'N', 'N', N, L, {1.0, 0.0}, Rt, 0, L, V, 0, N);
+    for (std::size_t l=0; l<L; l++) {
+      if (deflated_[l]) {
+        blas::zdscal(N, 0.0, V, l*N);
+      }
+    }
+  }
+
+}  // namespace gsminres
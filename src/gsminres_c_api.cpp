@@ -27,6 +27,10 @@ extern "C" {
     return new gsminres::Solver(n, m);
   }
 
+  gsminres_handle gsminres_create_std(size_t n, size_t m) {
+    return new gsminres::Solver(n, m, true);
+  }
+
   void gsminres_destroy(gsminres_handle handle) {
     delete as_solver(handle);
   }
@@ -72,6 +76,15 @@ extern "C" {
     from_cpp_vector(uvec, as_cmplx(u));
   }
 
+  void gsminres_glanczos(gsminres_handle handle,
+                         void*           v,
+                         const size_t    n) {
+    gsminres::Solver* solver = as_solver(handle);
+    std::vector<std::complex<double>> vvec = to_cpp_vector(as_cmplx(v), n);
+    solver->glanczos(vvec);
+    from_cpp_vector(vvec, as_cmplx(v));
+  }
+
   int gsminres_update(gsminres_handle handle,
                       void*           x,
                       const size_t    n,
@@ -108,4 +121,18 @@ extern "C" {
     }
   }
 
+  void gsminres_set_convergence_callback(gsminres_handle               handle,
+                                         gsminres_convergence_callback callback,
+                                         void*                         user_data) {
+    gsminres::Solver* solver = as_solver(handle);
+    if (callback == nullptr) {
+      solver->set_convergence_callback(nullptr);
+      return;
+    }
+    solver->set_convergence_callback(
+      [callback, user_data](std::size_t shift, const std::complex<double>* xm, std::size_t n) {
+        callback(shift, static_cast<const void*>(xm), n, user_data);
+      });
+  }
+
 }
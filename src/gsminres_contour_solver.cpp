@@ -0,0 +1,236 @@
+/**
+ * \file gsminres_contour_solver.cpp
+ * \brief Implementation of the GSMINRES++ contour-integral eigensolver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_contour_solver.hpp"
+#include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+
+namespace gsminres {
+
+  ContourSolver::ContourSolver(std::size_t matrix_size, std::complex<double> center, double radius,
+                               std::size_t quadrature_size, std::size_t source_size, std::size_t moment_size)
+    : matrix_size_(matrix_size),
+      quadrature_size_(quadrature_size),
+      source_size_(source_size),
+      moment_size_(moment_size),
+      center_(center),
+      radius_(radius),
+      sigma_(quadrature_size),
+      zeta_(quadrature_size),
+      weight_(quadrature_size),
+      V_(matrix_size*source_size),
+      S_(matrix_size*source_size*moment_size, {0.0, 0.0}),
+      mu_(source_size*source_size*2*moment_size, {0.0, 0.0}),
+      Q_(),
+      source_(0),
+      added_(quadrature_size, false),
+      x_(matrix_size*quadrature_size, {0.0, 0.0}),
+      solver_() {
+    if (quadrature_size == 0 || source_size == 0 || moment_size == 0 || !(radius > 0.0)) {
+      std::cerr << "ContourSolver: [ERROR] Invalid quadrature, source or moment size, or radius" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    const double pi = std::acos(-1.0);
+    for (std::size_t m=0; m<quadrature_size; m++) {
+      const double theta = 2.0*pi*(static_cast<double>(m)+0.5)/static_cast<double>(quadrature_size);
+      zeta_[m]   = std::polar(1.0, theta);
+      sigma_[m]  = -(center + radius*zeta_[m]);
+      weight_[m] = radius*zeta_[m]/static_cast<double>(quadrature_size);
+    }
+    // Fixed seed: the same sources (and results) in every run
+    std::mt19937_64 gen(20240501);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (std::size_t i=0; i<V_.size(); i++) {
+      const double re = dist(gen);
+      const double im = dist(gen);
+      V_[i] = {re, im};
+    }
+  }
+
+  void ContourSolver::get_source(std::size_t source, std::vector<std::complex<double>>& v) const {
+    blas::zcopy(matrix_size_, V_, source*matrix_size_, v, 0);
+  }
+
+  void ContourSolver::initialize(std::size_t source,
+                                 const std::vector<std::complex<double>>& b,
+                                 std::vector<std::complex<double>>& w,
+                                 const double threshold) {
+    if (source >= source_size_) {
+      std::cerr << "ContourSolver::initialize: [ERROR] Source index out of range" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    // Solver is used once per right-hand side
+    source_ = source;
+    added_.assign(quadrature_size_, false);
+    solver_.reset(new Solver(matrix_size_, quadrature_size_));
+    solver_->set_convergence_callback([this](std::size_t shift, const std::complex<double>* xm, std::size_t) {
+      accumulate(shift, xm);
+    });
+    get_source(source, w);
+    solver_->initialize(x_, b, w, sigma_, threshold);
+  }
+
+  void ContourSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    solver_->glanczos_pre(u);
+  }
+
+  void ContourSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                   std::vector<std::complex<double>>& u) {
+    solver_->glanczos_pst(w, u);
+  }
+
+  bool ContourSolver::update() {
+    return solver_->update(x_);
+  }
+
+  void ContourSolver::flush() {
+    for (std::size_t m=0; m<quadrature_size_; m++) {
+      if (!added_[m]) {
+        accumulate(m, x_.data()+m*matrix_size_);
+      }
+    }
+  }
+
+  void ContourSolver::finalize(std::vector<std::size_t>& conv_itr,
+                               std::vector<double>&      conv_res) {
+    solver_->finalize(conv_itr, conv_res);
+  }
+
+  void ContourSolver::accumulate(std::size_t shift, const std::complex<double>* xm) {
+    const std::size_t N = matrix_size_;
+    const std::size_t L = source_size_;
+    const std::size_t K = moment_size_;
+    const std::size_t l = source_;
+    // (A + sigma B)^{-1} B v = -(z B - A)^{-1} B v
+    std::vector<std::complex<double>> y(xm, xm+N);
+    std::vector<std::complex<double>> g(L);
+    blas::zgemm('C', 'N', L, 1, N, {1.0, 0.0}, V_, 0, N, y, 0, N, {0.0, 0.0}, g, 0, L);
+    std::complex<double> c = -weight_[shift];
+    for (std::size_t k=0; k<2*K; k++) {
+      if (k < K) {
+        blas::zaxpy(N, c, y, 0, S_, (k*L+l)*N);
+      }
+      for (std::size_t a=0; a<L; a++) {
+        mu_[k*L*L + a + l*L] += c*g[a];
+      }
+      c *= zeta_[shift];
+    }
+    added_[shift] = true;
+  }
+
+  std::size_t ContourSolver::hankel(std::vector<std::complex<double>>& eigenvalues,
+                                    std::vector<std::complex<double>>& eigenvectors,
+                                    const double delta) const {
+    const std::size_t N  = matrix_size_;
+    const std::size_t L  = source_size_;
+    const std::size_t K  = moment_size_;
+    const std::size_t LK = L*K;
+    // Block Hankel matrices H = [mu_{i+j}] and H< = [mu_{i+j+1}]
+    std::vector<std::complex<double>> H(LK*LK), Hs(LK*LK);
+    for (std::size_t i=0; i<K; i++) {
+      for (std::size_t j=0; j<K; j++) {
+        for (std::size_t b=0; b<L; b++) {
+          for (std::size_t a=0; a<L; a++) {
+            const std::size_t pos = (i*L+a) + (j*L+b)*LK;
+            H[pos]  = mu_[(i+j)*L*L   + a + b*L];
+            Hs[pos] = mu_[(i+j+1)*L*L + a + b*L];
+          }
+        }
+      }
+    }
+    // Truncated SVD H = U_r Sigma_r W_r^H
+    std::vector<double> s(LK);
+    std::vector<std::complex<double>> U(LK*LK), VT(LK*LK);
+    lapack::zgesvd(static_cast<int>(LK), static_cast<int>(LK), H, s, U, VT);
+    std::size_t r = 0;
+    while (r < LK && s[r] > delta*s[0]) {
+      r++;
+    }
+    eigenvalues.clear();
+    eigenvectors.clear();
+    if (r == 0) {
+      return 0;
+    }
+    // T = U_r^H H< W_r Sigma_r^{-1}
+    std::vector<std::complex<double>> tmp(LK*r), T(r*r);
+    blas::zgemm('N', 'C', LK, r, LK, {1.0, 0.0}, Hs, 0, LK, VT, 0, LK, {0.0, 0.0}, tmp, 0, LK);
+    for (std::size_t j=0; j<r; j++) {
+      blas::zdscal(LK, 1.0/s[j], tmp, j*LK);
+    }
+    blas::zgemm('C', 'N', r, r, LK, {1.0, 0.0}, U, 0, LK, tmp, 0, LK, {0.0, 0.0}, T, 0, r);
+    std::vector<std::complex<double>> zeta(r), t(r*r);
+    lapack::zgeev(static_cast<int>(r), T, zeta, t);
+    // Eigenvectors x = [S_0, ..., S_{K-1}] W_r Sigma_r^{-1} t
+    for (std::size_t i=0; i<r; i++) {
+      for (std::size_t j=0; j<r; j++) {
+        t[i+j*r] /= s[i];
+      }
+    }
+    std::vector<std::complex<double>> Y(LK*r), X(N*r);
+    blas::zgemm('C', 'N', LK, r, r, {1.0, 0.0}, VT, 0, LK, t, 0, r, {0.0, 0.0}, Y, 0, LK);
+    blas::zgemm('N', 'N', N, r, LK, {1.0, 0.0}, S_, 0, N, Y, 0, LK, {0.0, 0.0}, X, 0, N);
+    for (std::size_t j=0; j<r; j++) {
+      if (std::abs(zeta[j]) >= 1.0) {
+        continue;
+      }
+      eigenvalues.push_back(center_ + radius_*zeta[j]);
+      const std::size_t col = eigenvectors.size();
+      eigenvectors.insert(eigenvectors.end(), X.begin()+j*N, X.begin()+(j+1)*N);
+      blas::zdscal(N, 1.0/blas::dznrm2(N, eigenvectors, col), eigenvectors, col);
+    }
+    return eigenvalues.size();
+  }
+
+  std::size_t ContourSolver::basis(std::vector<std::complex<double>>& Q, const double delta) {
+    const std::size_t N  = matrix_size_;
+    const std::size_t LK = source_size_*moment_size_;
+    const std::size_t k  = N < LK ? N : LK;
+    std::vector<std::complex<double>> S(S_), U(N*k), VT(k*LK);
+    std::vector<double> s(k);
+    lapack::zgesvd(static_cast<int>(N), static_cast<int>(LK), S, s, U, VT);
+    std::size_t r = 0;
+    while (r < k && s[r] > delta*s[0]) {
+      r++;
+    }
+    Q_.assign(U.begin(), U.begin()+r*N);
+    Q = Q_;
+    return r;
+  }
+
+  std::size_t ContourSolver::rayleigh_ritz(const std::vector<std::complex<double>>& AQ,
+                                           const std::vector<std::complex<double>>& BQ,
+                                           std::vector<double>&                     eigenvalues,
+                                           std::vector<std::complex<double>>&       eigenvectors) const {
+    const std::size_t N = matrix_size_;
+    const std::size_t r = Q_.size()/N;
+    eigenvalues.clear();
+    eigenvectors.clear();
+    if (r == 0) {
+      return 0;
+    }
+    std::vector<std::complex<double>> Ar(r*r), Br(r*r), X(N*r);
+    std::vector<double> lambda(r);
+    blas::zgemm('C', 'N', r, r, N, {1.0, 0.0}, Q_, 0, N, AQ, 0, N, {0.0, 0.0}, Ar, 0, r);
+    blas::zgemm('C', 'N', r, r, N, {1.0, 0.0}, Q_, 0, N, BQ, 0, N, {0.0, 0.0}, Br, 0, r);
+    lapack::zhegv(static_cast<int>(r), Ar, Br, lambda);
+    blas::zgemm('N', 'N', N, r, r, {1.0, 0.0}, Q_, 0, N, Ar, 0, r, {0.0, 0.0}, X, 0, N);
+    for (std::size_t j=0; j<r; j++) {
+      if (std::abs(lambda[j]-center_) >= radius_) {
+        continue;
+      }
+      eigenvalues.push_back(lambda[j]);
+      const std::size_t col = eigenvectors.size();
+      eigenvectors.insert(eigenvectors.end(), X.begin()+j*N, X.begin()+(j+1)*N);
+      blas::zdscal(N, 1.0/blas::dznrm2(N, eigenvectors, col), eigenvectors, col);
+    }
+    return eigenvalues.size();
+  }
+
+}  // namespace gsminres
@@ -24,9 +24,9 @@ module gsminres_mod
   private
 
   public :: gsminres_handle
-  public :: gsminres_create, gsminres_destroy
+  public :: gsminres_create, gsminres_create_std, gsminres_destroy
   public :: gsminres_initialize
-  public :: gsminres_glanczos_pre, gsminres_glanczos_pst
+  public :: gsminres_glanczos_pre, gsminres_glanczos_pst, gsminres_glanczos
   public :: gsminres_update
   public :: gsminres_finalize
   public :: gsminres_get_residual
@@ -61,6 +61,24 @@ contains
     handle%ref = c_gsminres_create(n, m)
   end function gsminres_create
 
+  !> \brief Create a new GSMINRES solver instance for the standard shifted systems (B = I).
+  !> \details Use `gsminres_glanczos` instead of `gsminres_glanczos_pre` and `gsminres_glanczos_pst`.
+  !> \param[in] n  Matrix size
+  !> \param[in] m  Number of shift values
+  !> \return Solver handle (type(c_ptr))
+  function gsminres_create_std(n, m) result(handle)
+    integer(c_size_t), intent(in), value :: n, m
+    type(gsminres_handle) :: handle
+    interface
+       function c_gsminres_create_std(n, m) bind(C, name="gsminres_create_std")
+         import :: c_size_t, c_ptr
+         integer(c_size_t), value :: n, m
+         type(c_ptr)              :: c_gsminres_create_std
+       end function c_gsminres_create_std
+    end interface
+    handle%ref = c_gsminres_create_std(n, m)
+  end function gsminres_create_std
+
   !> \brief Free the solver object and release internal resources.
   !> \param[in] handle Solver handle (obtained from gsminres_create)
   subroutine gsminres_destroy(handle)
@@ -147,6 +165,27 @@ contains
     call c_gsminres_glanczos_pst(handle%ref, wp, up, n)
   end subroutine gsminres_glanczos_pst
 
+  !> \brief Apply one step of the Lanczos process (solver created by gsminres_create_std).
+  !> \param[in]     handle Solver handle
+  !> \param[in,out] v      Input A*w, output the next Lanczos vector
+  !> \param[in]     n      Size of the vector
+  subroutine gsminres_glanczos(handle, v, n)
+    type(gsminres_handle),     intent(in)            :: handle
+    complex(c_double_complex), intent(inout), target :: v(*)
+    integer(c_size_t),         intent(in)            :: n
+    type(c_ptr) :: vp
+    interface
+       subroutine c_gsminres_glanczos(h, v, n) bind(C, name="gsminres_glanczos")
+         import :: c_size_t, c_ptr
+         type(c_ptr),       value :: h
+         type(c_ptr),       value :: v
+         integer(c_size_t), value :: n
+       end subroutine c_gsminres_glanczos
+    end interface
+    vp = c_loc(v(1))
+    call c_gsminres_glanczos(handle%ref, vp, n)
+  end subroutine gsminres_glanczos
+
   !> \brief Update the solution vectors.
   !> \param[in]     handle Solver handle
   !> \param[in,out] x      Approximate solutions (updated in place)
@@ -0,0 +1,122 @@
+/**
+ * \file gsminres_mapped_array.cpp
+ * \brief Implementation of the memory-mapped file storage for GSMINRES++.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_mapped_array.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace gsminres {
+
+  MappedArray::MappedArray(const std::string& filename, std::size_t slice_size, std::size_t slice_count,
+                           bool remove_file)
+    : filename_(filename),
+      slice_size_(slice_size),
+      slice_count_(slice_count),
+      bytes_(slice_size*slice_count*sizeof(std::complex<double>)),
+      remove_file_(remove_file),
+      fd_(-1),
+      data_(nullptr) {
+    fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      std::cerr << "MappedArray: [ERROR] Unable to open file " << filename_
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    // A truncated and extended file reads as zeros without occupying disk blocks
+    if (::ftruncate(fd_, static_cast<off_t>(bytes_)) != 0) {
+      std::cerr << "MappedArray: [ERROR] Unable to resize file " << filename_
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if (bytes_ == 0) {
+      return;
+    }
+    void* addr = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "MappedArray: [ERROR] Unable to map file " << filename_
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    data_ = static_cast<std::complex<double>*>(addr);
+    // update() sweeps the slices in order
+    ::madvise(addr, bytes_, MADV_SEQUENTIAL);
+  }
+
+  MappedArray::~MappedArray() {
+    if (data_ != nullptr) {
+      ::munmap(data_, bytes_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    if (remove_file_) {
+      ::unlink(filename_.c_str());
+    }
+  }
+
+  void MappedArray::page_range(std::size_t first, std::size_t count, char*& addr, std::size_t& length) const {
+    const std::size_t page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = first*slice_size_*sizeof(std::complex<double>);
+    std::size_t       end   = (first+count)*slice_size_*sizeof(std::complex<double>);
+    if (end > bytes_) {
+      end = bytes_;
+    }
+    const std::size_t aligned = begin - begin % page;
+    addr   = reinterpret_cast<char*>(data_) + aligned;
+    length = (end > aligned) ? end - aligned : 0;
+  }
+
+  void MappedArray::prefetch(std::size_t first, std::size_t count) const {
+    if (data_ == nullptr || first >= slice_count_) {
+      return;
+    }
+    char* addr; std::size_t length;
+    page_range(first, count, addr, length);
+    ::madvise(addr, length, MADV_WILLNEED);
+  }
+
+  void MappedArray::release(std::size_t first, std::size_t count) const {
+    if (data_ == nullptr || first >= slice_count_) {
+      return;
+    }
+    // Only whole pages inside the range are released, so that neighbouring slices
+    // sharing a page at the boundaries are not affected.
+    const std::size_t page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t begin = first*slice_size_*sizeof(std::complex<double>);
+    std::size_t end   = (first+count)*slice_size_*sizeof(std::complex<double>);
+    if (end > bytes_) {
+      end = bytes_;
+    }
+    begin = (begin + page - 1) / page * page;
+    end   = (end == bytes_) ? end : end / page * page;
+    if (end <= begin) {
+      return;
+    }
+    char* addr = reinterpret_cast<char*>(data_) + begin;
+    // Dirty pages are scheduled for write-back before they are dropped
+    ::msync(addr, end - begin, MS_ASYNC);
+    ::madvise(addr, end - begin, MADV_DONTNEED);
+  }
+
+  void MappedArray::clear() {
+    if (data_ == nullptr) {
+      return;
+    }
+    // Punching the whole file back to zero length releases both the pages and the disk blocks
+    if (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(bytes_)) != 0) {
+      std::cerr << "MappedArray: [ERROR] Unable to resize file " << filename_
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    ::madvise(data_, bytes_, MADV_DONTNEED);
+  }
+
+}  // namespace gsminres
@@ -0,0 +1,133 @@
+/**
+ * \file gsminres_mpi_shift_solver.cpp
+ * \brief Implementation of the GSMINRES++ shift-partitioned solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_mpi_shift_solver.hpp"
+#include "gsminres_mpi_util.hpp"
+#include <utility>
+
+namespace gsminres {
+  namespace mpi {
+
+    namespace {
+      /**
+       * \brief Balanced contiguous block of shifts owned by this process.
+       */
+      std::pair<std::size_t, std::size_t> shift_block(MPI_Comm comm, std::size_t shift_size) {
+        std::size_t begin, size;
+        partition_rows(comm, shift_size, begin, size);
+        return {begin, size};
+      }
+
+      int comm_rank(MPI_Comm comm) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        return rank;
+      }
+    }
+
+    ShiftSolver::ShiftSolver(MPI_Comm comm, std::size_t matrix_size, std::size_t shift_size,
+                             bool broadcast, int leader)
+      : comm_(comm),
+        rank_(comm_rank(comm)),
+        leader_(leader),
+        broadcast_(broadcast),
+        matrix_size_(matrix_size),
+        shift_size_(shift_size),
+        shift_begin_(shift_block(comm, shift_size).first),
+        local_shift_size_(shift_block(comm, shift_size).second),
+        counts_(),
+        displs_(),
+        // The non-leaders in broadcast mode never see u, so they use the standard mode storage
+        solver_(matrix_size, local_shift_size_, broadcast && rank_ != leader) {
+      int size;
+      MPI_Comm_size(comm_, &size);
+      counts_.resize(size);
+      displs_.resize(size);
+      const int local = static_cast<int>(local_shift_size_);
+      MPI_Allgather(&local, 1, MPI_INT, counts_.data(), 1, MPI_INT, comm_);
+      for (int q=1; q<size; q++) {
+        displs_[q] = displs_[q-1] + counts_[q-1];
+      }
+    }
+
+    void ShiftSolver::initialize(std::vector<std::complex<double>>& x,
+                                 const std::vector<std::complex<double>>& b,
+                                 std::vector<std::complex<double>>& w,
+                                 const std::vector<std::complex<double>>& sigma,
+                                 const double threshold) {
+      if (broadcast_) {
+        MPI_Bcast(w.data(), static_cast<int>(2*matrix_size_), MPI_DOUBLE, leader_, comm_);
+      }
+      std::vector<std::complex<double>> local_sigma(sigma.begin()+shift_begin_,
+                                                    sigma.begin()+shift_begin_+local_shift_size_);
+      solver_.initialize(x, b, w, local_sigma, threshold);
+    }
+
+    void ShiftSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+      if (applies_operators()) {
+        solver_.glanczos_pre(u);
+      }
+    }
+
+    void ShiftSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                   std::vector<std::complex<double>>& u) {
+      if (!broadcast_) {
+        solver_.glanczos_pst(w, u);
+        return;
+      }
+      // The leader normalizes w in place, so that w itself is the next Lanczos vector
+      double coef[2];
+      if (rank_ == leader_) {
+        solver_.glanczos_pst(w, u);
+        solver_.get_lanczos(coef[0], coef[1]);
+      }
+      MPI_Bcast(coef, 2, MPI_DOUBLE, leader_, comm_);
+      MPI_Bcast(w.data(), static_cast<int>(2*matrix_size_), MPI_DOUBLE, leader_, comm_);
+      if (rank_ != leader_) {
+        solver_.glanczos_set(coef[0], coef[1], w);
+      }
+    }
+
+    bool ShiftSolver::update(std::vector<std::complex<double>>& x) {
+      int done = solver_.update(x) ? 1 : 0;
+      MPI_Allreduce(MPI_IN_PLACE, &done, 1, MPI_INT, MPI_LAND, comm_);
+      return done != 0;
+    }
+
+    void ShiftSolver::finalize(std::vector<std::size_t>& conv_itr,
+                               std::vector<double>&      conv_res) {
+      std::vector<std::size_t> local_itr;
+      std::vector<double>      local_res;
+      solver_.finalize(local_itr, local_res);
+      std::vector<unsigned long long> itr(local_itr.begin(), local_itr.end()), all_itr(shift_size_);
+      conv_res.resize(shift_size_);
+      MPI_Allgatherv(itr.data(), static_cast<int>(local_shift_size_), MPI_UNSIGNED_LONG_LONG,
+                     all_itr.data(), counts_.data(), displs_.data(), MPI_UNSIGNED_LONG_LONG, comm_);
+      MPI_Allgatherv(local_res.data(), static_cast<int>(local_shift_size_), MPI_DOUBLE,
+                     conv_res.data(), counts_.data(), displs_.data(), MPI_DOUBLE, comm_);
+      conv_itr.assign(all_itr.begin(), all_itr.end());
+    }
+
+    void ShiftSolver::get_residual(std::vector<double>& res) const {
+      std::vector<double> local_res(local_shift_size_);
+      solver_.get_residual(local_res);
+      MPI_Allgatherv(local_res.data(), static_cast<int>(local_shift_size_), MPI_DOUBLE,
+                     res.data(), counts_.data(), displs_.data(), MPI_DOUBLE, comm_);
+    }
+
+    void ShiftSolver::set_convergence_callback(Solver::ConvergenceCallback callback) {
+      if (!callback) {
+        solver_.set_convergence_callback(nullptr);
+        return;
+      }
+      const std::size_t offset = shift_begin_;
+      solver_.set_convergence_callback([callback, offset](std::size_t shift, const std::complex<double>* xm, std::size_t n) {
+        callback(offset + shift, xm, n);
+      });
+    }
+
+  }  // namespace mpi
+}  // namespace gsminres
@@ -0,0 +1,21 @@
+/**
+ * \file gsminres_mpi_solver.cpp
+ * \brief Implementation of the GSMINRES++ distributed-memory solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_mpi_solver.hpp"
+
+namespace gsminres {
+  namespace mpi {
+
+    Solver::Solver(MPI_Comm comm, std::size_t local_size, std::size_t shift_size, bool standard)
+      : gsminres::Solver(local_size, shift_size, standard),
+        comm_(comm) {
+      set_reduction([comm](double* values, std::size_t count) {
+        MPI_Allreduce(MPI_IN_PLACE, values, static_cast<int>(count), MPI_DOUBLE, MPI_SUM, comm);
+      });
+    }
+
+  }  // namespace mpi
+}  // namespace gsminres
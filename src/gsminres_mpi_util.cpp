@@ -0,0 +1,270 @@
+/**
+ * \file gsminres_mpi_util.cpp
+ * \brief Implementation of the GSMINRES++ distributed-memory utilities.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_mpi_util.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+namespace gsminres {
+  namespace mpi {
+
+    void partition_rows(MPI_Comm comm, const std::size_t global_size,
+                        std::size_t& row_begin, std::size_t& local_size) {
+      int rank, size;
+      MPI_Comm_rank(comm, &rank);
+      MPI_Comm_size(comm, &size);
+      const std::size_t r = static_cast<std::size_t>(rank), p = static_cast<std::size_t>(size);
+      row_begin  = global_size/p*r + std::min(r, global_size%p);
+      local_size = global_size/p + (r < global_size%p ? 1 : 0);
+    }
+
+    DistCSRMat build_dist_csr(MPI_Comm comm, const std::size_t global_size,
+                              const std::size_t row_begin, const util::CSRMat& rows) {
+      int rank, size;
+      MPI_Comm_rank(comm, &rank);
+      MPI_Comm_size(comm, &size);
+      const std::size_t n = rows.matrix_size;
+      const std::size_t row_end = row_begin + n;
+
+      // Row blocks of all processes
+      unsigned long long my_begin = row_begin;
+      std::vector<unsigned long long> begins(size+1, global_size);
+      MPI_Allgather(&my_begin, 1, MPI_UNSIGNED_LONG_LONG, begins.data(), 1, MPI_UNSIGNED_LONG_LONG, comm);
+
+      // Ghost columns, sorted (hence grouped by owner)
+      std::vector<std::size_t> ghost_cols;
+      for (std::size_t j=0; j<rows.row_pointer[n]; ++j) {
+        const std::size_t col = rows.col_indices[j];
+        if (col < row_begin || col >= row_end) {
+          ghost_cols.push_back(col);
+        }
+      }
+      std::sort(ghost_cols.begin(), ghost_cols.end());
+      ghost_cols.erase(std::unique(ghost_cols.begin(), ghost_cols.end()), ghost_cols.end());
+
+      // Split the rows into the owned and the ghost parts
+      std::size_t nnz_local = 0, nnz_ghost = 0;
+      for (std::size_t j=0; j<rows.row_pointer[n]; ++j) {
+        const std::size_t col = rows.col_indices[j];
+        if (col < row_begin || col >= row_end) { nnz_ghost++;}
+        else                                   { nnz_local++;}
+      }
+      DistCSRMat A(comm, n);
+      A.global_size = global_size;
+      A.row_begin   = row_begin;
+      A.local = util::CSRMat(n+1, nnz_local);
+      A.ghost = util::CSRMat(n+1, nnz_ghost);
+      std::size_t kl = 0, kg = 0;
+      for (std::size_t i=0; i<n; ++i) {
+        for (std::size_t j=rows.row_pointer[i]; j<rows.row_pointer[i+1]; ++j) {
+          const std::size_t col = rows.col_indices[j];
+          if (col < row_begin || col >= row_end) {
+            A.ghost.col_indices[kg] = std::lower_bound(ghost_cols.begin(), ghost_cols.end(), col) - ghost_cols.begin();
+            A.ghost.values[kg++]    = rows.values[j];
+          } else {
+            A.local.col_indices[kl] = col - row_begin;
+            A.local.values[kl++]    = rows.values[j];
+          }
+        }
+        A.local.row_pointer[i+1] = kl;
+        A.ghost.row_pointer[i+1] = kg;
+      }
+
+      // Receive pattern: owners of the ghost columns
+      std::vector<int> recv_counts(size, 0), send_counts(size, 0);
+      for (std::size_t col : ghost_cols) {
+        const int owner = static_cast<int>(std::upper_bound(begins.begin(), begins.begin()+size, col) - begins.begin()) - 1;
+        if (owner < 0 || owner == rank || col >= global_size) {
+          std::cerr << "build_dist_csr: [ERROR] Invalid column index " << col << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+        recv_counts[owner]++;
+      }
+      A.recv_offsets.push_back(0);
+      for (int q=0; q<size; ++q) {
+        if (recv_counts[q] > 0) {
+          A.recv_ranks.push_back(q);
+          A.recv_offsets.push_back(A.recv_offsets.back() + recv_counts[q]);
+        }
+      }
+
+      // Send pattern: the indices requested by the other processes
+      MPI_Alltoall(recv_counts.data(), 1, MPI_INT, send_counts.data(), 1, MPI_INT, comm);
+      std::vector<int> rdispl(size, 0), sdispl(size, 0);
+      for (int q=1; q<size; ++q) {
+        rdispl[q] = rdispl[q-1] + recv_counts[q-1];
+        sdispl[q] = sdispl[q-1] + send_counts[q-1];
+      }
+      std::vector<unsigned long long> requested(ghost_cols.begin(), ghost_cols.end());
+      std::vector<unsigned long long> to_send(sdispl[size-1] + send_counts[size-1]);
+      MPI_Alltoallv(requested.data(), recv_counts.data(), rdispl.data(), MPI_UNSIGNED_LONG_LONG,
+                    to_send.data(),   send_counts.data(), sdispl.data(), MPI_UNSIGNED_LONG_LONG, comm);
+      A.send_offsets.push_back(0);
+      for (int q=0; q<size; ++q) {
+        if (send_counts[q] > 0) {
+          A.send_ranks.push_back(q);
+          A.send_offsets.push_back(A.send_offsets.back() + send_counts[q]);
+        }
+      }
+      A.send_indices.resize(to_send.size());
+      for (std::size_t k=0; k<to_send.size(); ++k) {
+        A.send_indices[k] = static_cast<std::size_t>(to_send[k]) - row_begin;
+      }
+      A.send_buffer.resize(to_send.size());
+      A.halo.resize(ghost_cols.size());
+      A.requests.resize(A.recv_ranks.size() + A.send_ranks.size());
+      return A;
+    }
+
+    DistCSRMat distribute_csr(MPI_Comm comm, const util::CSRMat& A) {
+      std::size_t row_begin, local_size;
+      partition_rows(comm, A.matrix_size, row_begin, local_size);
+      const std::size_t first = A.row_pointer[row_begin];
+      util::CSRMat rows(local_size+1, A.row_pointer[row_begin+local_size] - first);
+      for (std::size_t i=0; i<=local_size; ++i) {
+        rows.row_pointer[i] = A.row_pointer[row_begin+i] - first;
+      }
+      std::copy(A.col_indices.begin()+first, A.col_indices.begin()+first+rows.col_indices.size(), rows.col_indices.begin());
+      std::copy(A.values.begin()+first,      A.values.begin()+first+rows.values.size(),           rows.values.begin());
+      return build_dist_csr(comm, A.matrix_size, row_begin, rows);
+    }
+
+    void spmv(const DistCSRMat& A, const std::vector<std::complex<double>>& x, std::vector<std::complex<double>>& y) {
+      // Start the halo exchange
+      std::size_t nreq = 0;
+      for (std::size_t k=0; k<A.recv_ranks.size(); ++k) {
+        MPI_Irecv(A.halo.data()+A.recv_offsets[k], static_cast<int>(2*(A.recv_offsets[k+1]-A.recv_offsets[k])),
+                  MPI_DOUBLE, A.recv_ranks[k], 0, A.comm, &A.requests[nreq++]);
+      }
+      for (std::size_t k=0; k<A.send_indices.size(); ++k) {
+        A.send_buffer[k] = x[A.send_indices[k]];
+      }
+      for (std::size_t k=0; k<A.send_ranks.size(); ++k) {
+        MPI_Isend(A.send_buffer.data()+A.send_offsets[k], static_cast<int>(2*(A.send_offsets[k+1]-A.send_offsets[k])),
+                  MPI_DOUBLE, A.send_ranks[k], 0, A.comm, &A.requests[nreq++]);
+      }
+      // Owned columns while the halo is in flight
+      util::spmv(A.local, x, y);
+      MPI_Waitall(static_cast<int>(nreq), A.requests.data(), MPI_STATUSES_IGNORE);
+      // Ghost columns
+      #pragma omp parallel for
+      for (std::size_t i=0; i < A.local_size; ++i) {
+        for (std::size_t j=A.ghost.row_pointer[i]; j < A.ghost.row_pointer[i+1]; ++j) {
+          y[i] += A.ghost.values[j] * A.halo[A.ghost.col_indices[j]];
+        }
+      }
+    }
+
+    std::complex<double> dotc(MPI_Comm comm,
+                              const std::vector<std::complex<double>>& x,
+                              const std::vector<std::complex<double>>& y) {
+      std::complex<double> sum = blas::zdotc(x.size(), x, 0, y, 0);
+      MPI_Allreduce(MPI_IN_PLACE, &sum, 2, MPI_DOUBLE, MPI_SUM, comm);
+      return sum;
+    }
+
+    double nrm2(MPI_Comm comm, const std::vector<std::complex<double>>& x) {
+      double sum = blas::dznrm2(x.size(), x);
+      sum *= sum;
+      MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, comm);
+      return std::sqrt(sum);
+    }
+
+    bool cg(const DistCSRMat& A, std::vector<std::complex<double>>& x, const std::vector<std::complex<double>>& b, const double tol, const std::size_t max_iter) {
+      bool status = false;
+      const std::size_t N = A.local_size;
+      std::vector<std::complex<double>> r(N), p(N), Ap(N);
+      std::complex<double> alpha;
+      double beta, rr, rr_old;
+      blas::zdscal(N, 0.0, x);
+      blas::zcopy(N, b, 0, r, 0);
+      blas::zcopy(N, r, 0, p, 0);
+      // The squared residual norm serves both the convergence check and beta
+      rr = nrm2(A.comm, r);
+      rr *= rr;
+      const double r0nrm = std::sqrt(rr);
+      if (r0nrm == 0.0) {
+        return true;
+      }
+      for (std::size_t i=0; i < max_iter; ++i) {
+        spmv(A, p, Ap);
+        alpha = rr / dotc(A.comm, p, Ap);
+        blas::zaxpy(N, alpha,   p, 0, x, 0);
+        blas::zaxpy(N, -alpha, Ap, 0, r, 0);
+        rr_old = rr;
+        rr = nrm2(A.comm, r);
+        if (rr/r0nrm < tol) {
+          status = true;
+          break;
+        }
+        rr *= rr;
+        beta = rr / rr_old;
+        blas::zdscal(N, beta, p);
+        blas::zaxpy(N, {1.0, 0.0}, r, 0, p, 0);
+      }
+      return status;
+    }
+
+    util::ChebyshevParam chebyshev_setup(const DistCSRMat& A, const double tol, const std::size_t lanczos_steps) {
+      const std::size_t N = A.local_size;
+      const std::size_t K = std::min(lanczos_steps, A.global_size);
+      // Same start vector as util::chebyshev_setup(), independent of the partitioning
+      std::vector<std::complex<double>> v_prev(N, {0.0, 0.0}), v(N), w(N);
+      for (std::size_t i=0; i < N; ++i) {
+        v[i] = std::sin(1.0 + static_cast<double>(A.row_begin+i));
+      }
+      blas::zdscal(N, 1.0/nrm2(A.comm, v), v);
+      std::vector<double> alpha, beta;
+      double beta_prev = 0.0;
+      for (std::size_t j=0; j < K; ++j) {
+        spmv(A, v, w);
+        const double a = dotc(A.comm, v, w).real();
+        blas::zaxpy(N, -a,         v,      0, w, 0);
+        blas::zaxpy(N, -beta_prev, v_prev, 0, w, 0);
+        alpha.push_back(a);
+        const double b = nrm2(A.comm, w);
+        if (b <= 1e-14*std::abs(a)) {
+          break;
+        }
+        beta.push_back(b);
+        v_prev.swap(v);
+        blas::zcopy(N, w, 0, v, 0);
+        blas::zdscal(N, 1.0/b, v);
+        beta_prev = b;
+      }
+      return util::chebyshev_param(alpha, beta, tol);
+    }
+
+    void chebyshev(const DistCSRMat& A, const util::ChebyshevParam& param, std::vector<std::complex<double>>& x, const std::vector<std::complex<double>>& b) {
+      const std::size_t N     = A.local_size;
+      const double      theta = (param.lambda_max+param.lambda_min)/2.0;
+      const double      delta = (param.lambda_max-param.lambda_min)/2.0;
+      const double      sigma = theta/delta;
+      double rho = 1.0/sigma;
+      std::vector<std::complex<double>> r(N), d(N), Ad(N);
+      blas::zdscal(N, 0.0, x);
+      blas::zcopy(N, b, 0, r, 0);
+      blas::zcopy(N, b, 0, d, 0);
+      blas::zdscal(N, 1.0/theta, d);
+      for (std::size_t i=0; i < param.iterations; ++i) {
+        blas::zaxpy(N, {1.0, 0.0}, d, 0, x, 0);
+        if (i+1 == param.iterations) {
+          break;
+        }
+        spmv(A, d, Ad);
+        blas::zaxpy(N, {-1.0, 0.0}, Ad, 0, r, 0);
+        const double rho_next = 1.0/(2.0*sigma-rho);
+        blas::zdscal(N, rho_next*rho, d);
+        blas::zaxpy(N, 2.0*rho_next/delta, r, 0, d, 0);
+        rho = rho_next;
+      }
+    }
+
+  }  // namespace mpi
+}  // namespace gsminres
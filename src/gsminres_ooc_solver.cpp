@@ -0,0 +1,164 @@
+/**
+ * \file gsminres_ooc_solver.cpp
+ * \brief Implementation of the GSMINRES++ out-of-core solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_ooc_solver.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace gsminres {
+
+  OutOfCoreSolver::OutOfCoreSolver(std::size_t matrix_size, std::size_t shift_size,
+                                   const std::string& prefix, std::size_t window)
+    : iter_(1),
+      matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      window_(window > 0 ? window : 1),
+      r0_norm_(0.0),
+      sigma_(shift_size, {0.0, 0.0}),
+      alpha_(0.0),
+      beta_prev_(0.0),
+      beta_curr_(0.0),
+      w_curr_(matrix_size, {0.0, 0.0}),
+      w_next_(matrix_size, {0.0, 0.0}),
+      u_prev_(matrix_size, {0.0, 0.0}),
+      u_curr_(matrix_size, {0.0, 0.0}),
+      u_next_(matrix_size, {0.0, 0.0}),
+      T_prev2_(1, {0.0, 0.0}),
+      T_prev_( 1, {0.0, 0.0}),
+      T_curr_( 1, {0.0, 0.0}),
+      T_next_( 1, {0.0, 0.0}),
+      Gc_(shift_size, std::array<double, 3>{0.0, 0.0, 0.0}),
+      Gs_(shift_size, std::array<std::complex<double>, 3>{{{0.0,0.0}, {0.0,0.0}, {0.0,0.0}}}),
+      x_(prefix + ".x",   matrix_size, shift_size, false),
+      p_(prefix + ".p", 3*matrix_size, shift_size, true),
+      f_(shift_size, {1.0, 0.0}),
+      h_(shift_size, 1.0),
+      conv_num_(0),
+      is_conv_(shift_size, 0),
+      threshold_(1e-12) {
+  }
+
+  void OutOfCoreSolver::initialize(const std::vector<std::complex<double>>& b,
+                                   std::vector<std::complex<double>>& w,
+                                   const std::vector<std::complex<double>>& sigma,
+                                   const double threshold) {
+    x_.clear();
+    p_.clear();
+    r0_norm_ = std::sqrt((blas::zdotc(matrix_size_, b, 0, w, 0)).real());
+    blas::zcopy(matrix_size_, w, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, b, 0, u_curr_, 0);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, w_curr_);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, u_curr_);
+    blas::zcopy(matrix_size_, w_curr_, 0, w, 0);
+    blas::dscal(shift_size_, r0_norm_, h_);
+    blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
+    threshold_ = threshold;
+  }
+
+  void OutOfCoreSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    alpha_ = (blas::zdotc(matrix_size_, w_curr_, 0, u, 0)).real();
+    blas::zaxpy(matrix_size_, -alpha_,     u_curr_, 0, u, 0);
+    blas::zaxpy(matrix_size_, -beta_prev_, u_prev_, 0, u, 0);
+  }
+
+  void OutOfCoreSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                     std::vector<std::complex<double>>& u) {
+    beta_curr_ = std::sqrt((blas::zdotc(matrix_size_, u, 0, w, 0)).real());
+    blas::zdscal(matrix_size_, 1.0/beta_curr_, w);
+    blas::zdscal(matrix_size_, 1.0/beta_curr_, u);
+    blas::zcopy(matrix_size_, w, 0, w_next_, 0);
+    blas::zcopy(matrix_size_, u, 0, u_next_, 0);
+  }
+
+  bool OutOfCoreSolver::update() {
+    const std::size_t N = matrix_size_;
+    std::vector<std::size_t> active;
+    for (std::size_t m=0; m<shift_size_; m++) {
+      if (is_conv_[m] == 0) {
+        active.push_back(m);
+      }
+    }
+    for (std::size_t a=0; a<active.size() && a<window_; a++) {
+      x_.prefetch(active[a]);
+      p_.prefetch(active[a]);
+    }
+    // Slots of the auxiliary vectors rotate by the iteration index: p_j is kept in slot j%3
+    const std::size_t s_curr = (iter_  ) % 3;
+    const std::size_t s_prev = (iter_+2) % 3;
+    const std::size_t s_prv2 = (iter_+1) % 3;
+    const std::complex<double>* w = w_curr_.data();
+    for (std::size_t a=0; a<active.size(); a++) {
+      const std::size_t m = active[a];
+      if (a+window_ < active.size()) {
+        x_.prefetch(active[a+window_]);
+        p_.prefetch(active[a+window_]);
+      }
+      T_prev2_[0] = 0.0;
+      T_prev_[0]  = beta_prev_;
+      T_curr_[0]  = alpha_ + sigma_[m];
+      T_next_[0]  = beta_curr_;
+      if (iter_ >= 3) {
+        blas::zrot(1, T_prev2_, 0, T_prev_, 0, Gc_[m][0], Gs_[m][0]);
+      }
+      if (iter_ >= 2) {
+        blas::zrot(1, T_prev_,  0, T_curr_, 0, Gc_[m][1], Gs_[m][1]);
+      }
+      blas::zrotg(T_curr_[0], T_next_[0], Gc_[m][2], Gs_[m][2]);
+      const std::complex<double> t2   = T_prev2_[0];
+      const std::complex<double> t1   = T_prev_[0];
+      const std::complex<double> tinv = 1.0 / T_curr_[0];
+      const std::complex<double> coef = r0_norm_*Gc_[m][2]*f_[m];
+      std::complex<double>* p  = p_.slice(m);
+      std::complex<double>* pn = p + s_curr*N;
+      const std::complex<double>* p1 = p + s_prev*N;
+      const std::complex<double>* p2 = p + s_prv2*N;
+      std::complex<double>* x  = x_.slice(m);
+      #pragma omp parallel for
+      for (std::size_t i=0; i<N; i++) {
+        const std::complex<double> v = (w[i] - t2*p2[i] - t1*p1[i]) * tinv;
+        pn[i] = v;
+        x[i] += coef * v;
+      }
+      x_.release(m);
+      p_.release(m);
+      f_[m] = -std::conj(Gs_[m][2]) * f_[m];
+      h_[m] = std::abs(-std::conj(Gs_[m][2])) * h_[m];
+      if (h_[m]/r0_norm_ < threshold_) {
+        conv_num_++;
+        is_conv_[m] = iter_;
+        continue;
+      }
+      Gc_[m][0] = Gc_[m][1]; Gc_[m][1] = Gc_[m][2];
+      Gs_[m][0] = Gs_[m][1]; Gs_[m][1] = Gs_[m][2];
+    }
+    beta_prev_ = beta_curr_;
+    w_curr_.swap(w_next_);
+    u_prev_.swap(u_curr_);
+    u_curr_.swap(u_next_);
+    iter_++;
+    if (conv_num_ >= shift_size_) {
+      return true;
+    }
+    return false;
+  }
+
+  void OutOfCoreSolver::get_solution(std::size_t m, std::vector<std::complex<double>>& xm) const {
+    const std::complex<double>* x = x_.slice(m);
+    xm.assign(x, x + matrix_size_);
+  }
+
+  void OutOfCoreSolver::finalize(std::vector<std::size_t>& conv_itr,
+                                 std::vector<double>&      conv_res) {
+    conv_itr = is_conv_;
+    conv_res = h_;
+  }
+
+  void OutOfCoreSolver::get_residual(std::vector<double>& res) const {
+    blas::dcopy(shift_size_, h_, 0, res, 0);
+  }
+
+}  // namespace gsminres
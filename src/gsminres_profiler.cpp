@@ -0,0 +1,363 @@
+/**
+ * \file gsminres_profiler.cpp
+ * \brief Implementation of the per-phase timing instrumentation for GSMINRES++.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_profiler.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gsminres {
+  namespace profiler {
+
+    namespace {
+      /**
+       * \brief Events of one thread.
+       */
+      struct Buffer {
+        std::uint32_t      thread;
+        std::vector<Event> events;
+      };
+
+      std::mutex& buffers_mutex() {
+        static std::mutex mtx;
+        return mtx;
+      }
+
+      std::vector<std::shared_ptr<Buffer>>& buffers() {
+        static std::vector<std::shared_ptr<Buffer>> list;
+        return list;
+      }
+
+      std::chrono::steady_clock::time_point origin() {
+        static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        return t0;
+      }
+
+      /**
+       * \brief Peak bandwidth [GB/s] and flop rate [GFLOP/s] (0 if unknown).
+       */
+      double peak_bandwidth = 0.0;
+      double peak_gflops    = 0.0;
+
+      /**
+       * \brief Write the trace to `GSMINRES_PROFILE_OUTPUT` and the summaries to std::cerr at exit.
+       */
+      void write_at_exit() {
+        const char* filename = std::getenv("GSMINRES_PROFILE_OUTPUT");
+        if (filename != nullptr && write_chrome_trace(filename)) {
+          std::cerr << "profiler: trace written to " << filename << std::endl;
+        }
+        print_summary(std::cerr);
+        print_roofline(std::cerr);
+      }
+
+      /**
+       * \brief Whether the hardware counters are requested (`GSMINRES_PROFILE_PERF=1`).
+       */
+      bool perf_requested() {
+        static const bool requested = []() {
+          const char* env = std::getenv("GSMINRES_PROFILE_PERF");
+          return env != nullptr && std::strcmp(env, "0") != 0;
+        }();
+        return requested;
+      }
+
+      /**
+       * \brief Cache-miss counter of the calling thread (0 if not available).
+       */
+      std::uint64_t read_misses() {
+#ifdef __linux__
+        // -2: not opened yet, -1: not available
+        thread_local int fd = -2;
+        if (fd == -2) {
+          fd = -1;
+          if (perf_requested()) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd < 0) {
+              static std::once_flag warned;
+              std::call_once(warned, []() {
+                std::cerr << "profiler: [WARNING] perf_event_open failed; cache misses are not counted" << std::endl;
+              });
+              fd = -1;
+            }
+          }
+        }
+        std::uint64_t count = 0;
+        if (fd >= 0 && read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+          count = 0;
+        }
+        return count;
+#else
+        return 0;
+#endif
+      }
+
+      /**
+       * \brief Innermost recorded phase of the calling thread.
+       */
+      thread_local Scope* current = nullptr;
+    }  // namespace
+
+    namespace detail {
+      std::atomic<bool>& flag() {
+        static std::atomic<bool> on([]() {
+          const char* env = std::getenv("GSMINRES_PROFILE");
+          const bool enable = env != nullptr && std::strcmp(env, "0") != 0;
+          if (enable && std::getenv("GSMINRES_PROFILE_OUTPUT") != nullptr) {
+            // Construct the statics before registering, so that they outlive the handler
+            buffers_mutex();
+            buffers();
+            origin();
+            std::atexit(write_at_exit);
+          }
+          return enable;
+        }());
+        return on;
+      }
+
+      std::uint64_t now() {
+        return static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin()).count());
+      }
+
+      void begin(Scope& scope) {
+        scope.parent_ = current;
+        current       = &scope;
+        scope.misses_ = read_misses();
+        scope.begin_  = now();
+      }
+
+      void end(Scope& scope) {
+        const std::uint64_t t      = now();
+        const std::uint64_t misses = read_misses() - scope.misses_;
+        current = scope.parent_;
+        if (scope.parent_ != nullptr) {
+          scope.parent_->bytes_ += scope.bytes_;
+          scope.parent_->flops_ += scope.flops_;
+        }
+        // The buffer is registered once per thread; afterwards recording takes no lock
+        thread_local std::shared_ptr<Buffer> local;
+        if (!local) {
+          std::lock_guard<std::mutex> lock(buffers_mutex());
+          local = std::make_shared<Buffer>();
+          local->thread = static_cast<std::uint32_t>(buffers().size());
+          local->events.reserve(4096);
+          buffers().push_back(local);
+        }
+        local->events.push_back({scope.name_, scope.iteration_, scope.begin_, t, local->thread,
+                                 scope.bytes_, scope.flops_, misses});
+      }
+    }  // namespace detail
+
+    void enable(bool enable) {
+      origin();
+      detail::flag().store(enable, std::memory_order_relaxed);
+    }
+
+    void clear() {
+      std::lock_guard<std::mutex> lock(buffers_mutex());
+      for (const std::shared_ptr<Buffer>& buf : buffers()) {
+        buf->events.clear();
+      }
+    }
+
+    std::vector<Event> events() {
+      std::vector<Event> all;
+      {
+        std::lock_guard<std::mutex> lock(buffers_mutex());
+        for (const std::shared_ptr<Buffer>& buf : buffers()) {
+          all.insert(all.end(), buf->events.begin(), buf->events.end());
+        }
+      }
+      std::sort(all.begin(), all.end(), [](const Event& a, const Event& b) { return a.begin < b.begin; });
+      return all;
+    }
+
+    bool write_chrome_trace(const std::string& filename) {
+      std::ofstream ofs(filename);
+      if (!ofs) {
+        std::cerr << "profiler::write_chrome_trace: [ERROR] Cannot open " << filename << std::endl;
+        return false;
+      }
+      const std::vector<Event> all = events();
+      ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      ofs << std::fixed << std::setprecision(3);
+      for (std::size_t i=0; i<all.size(); i++) {
+        const Event& e = all[i];
+        ofs << (i == 0 ? "\n" : ",\n")
+            << "{\"name\":\"" << e.name << "\",\"cat\":\"gsminres\",\"ph\":\"X\""
+            << ",\"ts\":"  << static_cast<double>(e.begin)*1e-3
+            << ",\"dur\":" << static_cast<double>(e.end-e.begin)*1e-3
+            << ",\"pid\":0,\"tid\":" << e.thread;
+        if (e.iteration >= 0) {
+          ofs << ",\"args\":{\"iteration\":" << e.iteration << "}";
+        }
+        ofs << "}";
+      }
+      ofs << "\n]}\n";
+      return static_cast<bool>(ofs);
+    }
+
+    void print_summary(std::ostream& os) {
+      struct Stat {
+        std::size_t   calls = 0;
+        std::uint64_t total = 0;
+        std::uint64_t max   = 0;
+      };
+      const std::vector<Event> all = events();
+      if (all.empty()) {
+        os << "profiler: no events recorded" << std::endl;
+        return;
+      }
+      std::map<std::string, Stat> stats;
+      std::uint64_t first = all.front().begin, last = 0;
+      for (const Event& e : all) {
+        Stat& s = stats[e.name];
+        const std::uint64_t d = e.end - e.begin;
+        s.calls++;
+        s.total += d;
+        s.max    = std::max(s.max, d);
+        last     = std::max(last, e.end);
+      }
+      const double wall = static_cast<double>(last - first);
+      os << std::left << std::setw(16) << "phase" << std::right
+         << std::setw(10) << "calls"
+         << std::setw(14) << "total [ms]"
+         << std::setw(14) << "mean [us]"
+         << std::setw(14) << "max [us]"
+         << std::setw(10) << "share" << std::endl;
+      for (const auto& kv : stats) {
+        const Stat& s = kv.second;
+        os << std::left << std::setw(16) << kv.first << std::right
+           << std::setw(10) << s.calls
+           << std::fixed << std::setprecision(3)
+           << std::setw(14) << static_cast<double>(s.total)*1e-6
+           << std::setw(14) << static_cast<double>(s.total)*1e-3/static_cast<double>(s.calls)
+           << std::setw(14) << static_cast<double>(s.max)*1e-3
+           << std::setprecision(1)
+           << std::setw(9)  << 100.0*static_cast<double>(s.total)/wall << "%" << std::endl;
+      }
+      os << std::left << std::setw(16) << "wall" << std::right << std::setw(10) << ""
+         << std::fixed << std::setprecision(3) << std::setw(14) << wall*1e-6 << std::endl;
+      os.unsetf(std::ios::floatfield);
+    }
+
+    void set_peak(double bandwidth, double gflops) {
+      peak_bandwidth = bandwidth;
+      peak_gflops    = gflops;
+    }
+
+    double measure_bandwidth(std::size_t size) {
+      std::vector<double> a(size), b(size, 1.0), c(size, 2.0);
+      const std::size_t n = size;
+      double* pa = a.data();
+      const double* pb = b.data();
+      const double* pc = c.data();
+      double best = 0.0;
+      for (int rep=0; rep<5; rep++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        #pragma omp parallel for schedule(static)
+        for (std::size_t i=0; i<n; i++) {
+          pa[i] = pb[i] + 3.0*pc[i];
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        // Two loads and one store (write-allocate is not counted, as in STREAM)
+        best = std::max(best, 3.0*sizeof(double)*static_cast<double>(n)/sec*1e-9);
+      }
+      return best;
+    }
+
+    void print_roofline(std::ostream& os) {
+      struct Stat {
+        std::uint64_t time   = 0;
+        double        bytes  = 0.0;
+        double        flops  = 0.0;
+        std::uint64_t misses = 0;
+      };
+      const std::vector<Event> all = events();
+      std::map<std::string, Stat> stats;
+      bool has_misses = false;
+      for (const Event& e : all) {
+        if (e.bytes <= 0.0) {
+          continue;
+        }
+        Stat& s = stats[e.name];
+        s.time   += e.end - e.begin;
+        s.bytes  += e.bytes;
+        s.flops  += e.flops;
+        s.misses += e.misses;
+        has_misses = has_misses || e.misses > 0;
+      }
+      if (stats.empty()) {
+        os << "profiler: no kernels with byte counts recorded" << std::endl;
+        return;
+      }
+      if (peak_bandwidth <= 0.0) {
+        peak_bandwidth = measure_bandwidth();
+      }
+      os << "roofline (peak bandwidth " << std::fixed << std::setprecision(1) << peak_bandwidth << " GB/s";
+      if (peak_gflops > 0.0) {
+        os << ", peak " << peak_gflops << " GFLOP/s";
+      }
+      os << ")" << std::endl;
+      os << std::left << std::setw(16) << "kernel" << std::right
+         << std::setw(12) << "GB"
+         << std::setw(10) << "GB/s"
+         << std::setw(10) << "GFLOP/s"
+         << std::setw(10) << "flop/B"
+         << std::setw(10) << "%bw";
+      if (peak_gflops > 0.0) {
+        os << std::setw(10) << "%roof";
+      }
+      if (has_misses) {
+        os << std::setw(12) << "perf GB/s";
+      }
+      os << std::endl;
+      for (const auto& kv : stats) {
+        const Stat&  s    = kv.second;
+        const double sec  = static_cast<double>(s.time)*1e-9;
+        const double gbs  = sec > 0.0 ? s.bytes/sec*1e-9 : 0.0;
+        const double gfs  = sec > 0.0 ? s.flops/sec*1e-9 : 0.0;
+        const double ai   = s.flops/s.bytes;
+        os << std::left << std::setw(16) << kv.first << std::right << std::fixed
+           << std::setprecision(3) << std::setw(12) << s.bytes*1e-9
+           << std::setprecision(2) << std::setw(10) << gbs
+           << std::setw(10) << gfs
+           << std::setprecision(3) << std::setw(10) << ai
+           << std::setprecision(1) << std::setw(9)  << 100.0*gbs/peak_bandwidth << "%";
+        if (peak_gflops > 0.0) {
+          // Attainable performance of the roofline model
+          const double roof = std::min(peak_gflops, ai*peak_bandwidth);
+          os << std::setw(9) << 100.0*gfs/roof << "%";
+        }
+        if (has_misses) {
+          os << std::setprecision(2) << std::setw(12) << (sec > 0.0 ? 64.0*static_cast<double>(s.misses)/sec*1e-9 : 0.0);
+        }
+        os << std::endl;
+      }
+      os.unsetf(std::ios::floatfield);
+    }
+
+  }  // namespace profiler
+}  // namespace gsminres
@@ -0,0 +1,141 @@
+/**
+ * \file gsminres_projected_solver.cpp
+ * \brief Implementation of the GSMINRES++ projected-output solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_projected_solver.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace gsminres {
+
+  ProjectedSolver::ProjectedSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t projection_size)
+    : iter_(1),
+      matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      projection_size_(projection_size),
+      r0_norm_(0.0),
+      sigma_(shift_size, {0.0, 0.0}),
+      c_(projection_size*matrix_size, {0.0, 0.0}),
+      alpha_(0.0),
+      beta_prev_(0.0),
+      beta_curr_(0.0),
+      w_curr_(matrix_size, {0.0, 0.0}),
+      w_next_(matrix_size, {0.0, 0.0}),
+      u_prev_(matrix_size, {0.0, 0.0}),
+      u_curr_(matrix_size, {0.0, 0.0}),
+      u_next_(matrix_size, {0.0, 0.0}),
+      cw_(projection_size, {0.0, 0.0}),
+      T_prev2_(1, {0.0, 0.0}),
+      T_prev_( 1, {0.0, 0.0}),
+      T_curr_( 1, {0.0, 0.0}),
+      T_next_( 1, {0.0, 0.0}),
+      Gc_(shift_size, std::array<double, 3>{0.0, 0.0, 0.0}),
+      Gs_(shift_size, std::array<std::complex<double>, 3>{{{0.0,0.0}, {0.0,0.0}, {0.0,0.0}}}),
+      q_prev2_(shift_size*projection_size, {0.0, 0.0}),
+      q_prev_( shift_size*projection_size, {0.0, 0.0}),
+      q_curr_( shift_size*projection_size, {0.0, 0.0}),
+      f_(shift_size, {1.0, 0.0}),
+      h_(shift_size, 1.0),
+      conv_num_(0),
+      is_conv_(shift_size, 0),
+      threshold_(1e-12) {
+  }
+
+  void ProjectedSolver::initialize(std::vector<std::complex<double>>& z,
+                                   const std::vector<std::complex<double>>& c,
+                                   const std::vector<std::complex<double>>& b,
+                                   std::vector<std::complex<double>>& w,
+                                   const std::vector<std::complex<double>>& sigma,
+                                   const double threshold) {
+    blas::zdscal(projection_size_*shift_size_, 0.0, z);
+    blas::zcopy(projection_size_*matrix_size_, c, 0, c_, 0);
+    r0_norm_ = std::sqrt((blas::zdotc(matrix_size_, b, 0, w, 0)).real());
+    blas::zcopy(matrix_size_, w, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, b, 0, u_curr_, 0);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, w_curr_);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, u_curr_);
+    blas::zcopy(matrix_size_, w_curr_, 0, w, 0);
+    blas::dscal(shift_size_, r0_norm_, h_);
+    blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
+    threshold_ = threshold;
+  }
+
+  void ProjectedSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    alpha_ = (blas::zdotc(matrix_size_, w_curr_, 0, u, 0)).real();
+    blas::zaxpy(matrix_size_, -alpha_,     u_curr_, 0, u, 0);
+    blas::zaxpy(matrix_size_, -beta_prev_, u_prev_, 0, u, 0);
+  }
+
+  void ProjectedSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                     std::vector<std::complex<double>>& u) {
+    beta_curr_ = std::sqrt((blas::zdotc(matrix_size_, u, 0, w, 0)).real());
+    blas::zdscal(matrix_size_, 1.0/beta_curr_, w);
+    blas::zdscal(matrix_size_, 1.0/beta_curr_, u);
+    blas::zcopy(matrix_size_, w, 0, w_next_, 0);
+    blas::zcopy(matrix_size_, u, 0, u_next_, 0);
+  }
+
+  bool ProjectedSolver::update(std::vector<std::complex<double>>& z) {
+    const std::size_t K = projection_size_, M = shift_size_;
+    // c_k^H w for all k in a single sweep over the projection vectors
+    blas::zgemm('C', 'N', K, 1, matrix_size_, {1.0, 0.0}, c_, 0, matrix_size_,
+                w_curr_, 0, matrix_size_, {0.0, 0.0}, cw_, 0, K);
+    for (std::size_t m=0; m<M; m++) {
+      if (is_conv_[m] != 0) {
+        continue;
+      }
+      T_prev2_[0] = 0.0;
+      T_prev_[0]  = beta_prev_;
+      T_curr_[0]  = alpha_ + sigma_[m];
+      T_next_[0]  = beta_curr_;
+      if (iter_ >= 3) {
+        blas::zrot(1, T_prev2_, 0, T_prev_, 0, Gc_[m][0], Gs_[m][0]);
+      }
+      if (iter_ >= 2) {
+        blas::zrot(1, T_prev_,  0, T_curr_, 0, Gc_[m][1], Gs_[m][1]);
+      }
+      blas::zrotg(T_curr_[0], T_next_[0], Gc_[m][2], Gs_[m][2]);
+      // Same recurrence as the auxiliary vectors p in Solver::update(), applied to c_k^H p
+      const std::complex<double> coef = r0_norm_*Gc_[m][2]*f_[m];
+      for (std::size_t k=0; k<K; k++) {
+        std::size_t mk = m*K + k;
+        q_prev2_[mk] = q_prev_[mk];
+        q_prev_[mk]  = q_curr_[mk];
+        q_curr_[mk]  = (cw_[k] - T_prev2_[0]*q_prev2_[mk] - T_prev_[0]*q_prev_[mk]) / T_curr_[0];
+        z[k*M+m] += coef * q_curr_[mk];
+      }
+      f_[m] = -std::conj(Gs_[m][2]) * f_[m];
+      h_[m] = std::abs(-std::conj(Gs_[m][2])) * h_[m];
+      if (h_[m]/r0_norm_ < threshold_) {
+        conv_num_++;
+        is_conv_[m] = iter_;
+        continue;
+      }
+      Gc_[m][0] = Gc_[m][1]; Gc_[m][1] = Gc_[m][2];
+      Gs_[m][0] = Gs_[m][1]; Gs_[m][1] = Gs_[m][2];
+    }
+    beta_prev_ = beta_curr_;
+    blas::zcopy(matrix_size_, w_next_, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, u_curr_, 0, u_prev_, 0);
+    blas::zcopy(matrix_size_, u_next_, 0, u_curr_, 0);
+    iter_++;
+    if (conv_num_ >= shift_size_) {
+      return true;
+    }
+    return false;
+  }
+
+  void ProjectedSolver::finalize(std::vector<std::size_t>& conv_itr,
+                                 std::vector<double>&      conv_res) {
+    conv_itr = is_conv_;
+    conv_res = h_;
+  }
+
+  void ProjectedSolver::get_residual(std::vector<double>& res) const {
+    blas::dcopy(shift_size_, h_, 0, res, 0);
+  }
+
+}  // namespace gsminres
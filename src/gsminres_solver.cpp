@@ -6,16 +6,181 @@
 
 #include "gsminres_solver.hpp"
 #include "gsminres_blas.hpp"
-//#include "gsminres_lapack.hpp"
+#include "gsminres_lapack.hpp"
+#include "gsminres_profiler.hpp"
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <cmath>
+#include <future>
+#include <limits>
+#include <algorithm>
 
 namespace gsminres {
 
-  Solver::Solver(std::size_t matrix_size, std::size_t shift_size)
+  namespace {
+    /**
+     * \brief Real part of \f$ x^H y \f$ in a single threaded sweep.
+     */
+    double real_dot(std::size_t n, const std::complex<double>* x, const std::complex<double>* y) {
+      double sum = 0.0;
+      #pragma omp parallel for reduction(+:sum) schedule(static)
+      for (std::size_t i=0; i<n; i++) {
+        sum += x[i].real()*y[i].real() + x[i].imag()*y[i].imag();
+      }
+      return sum;
+    }
+
+    const char          ckpt_magic[4] = {'G', 'S', 'M', 'C'}; ///< Start of a checkpoint
+    const char          ckpt_end[4]   = {'G', 'S', 'M', 'E'}; ///< End of a complete checkpoint
+    const std::uint32_t ckpt_version  = 1;                    ///< Checkpoint format version
+
+    /**
+     * \brief Archive that counts the bytes of the state (to reserve the image).
+     */
+    class StateCounter {
+    public:
+      std::size_t bytes = 0;
+      template <typename T>
+      void operator()(T&) { bytes += sizeof(T); }
+      template <typename T>
+      void operator()(std::vector<T>& v) { bytes += sizeof(std::uint64_t) + v.size()*sizeof(T); }
+      template <typename T>
+      void operator()(std::vector<std::vector<T>>& v) {
+        bytes += sizeof(std::uint64_t);
+        for (std::vector<T>& e : v) {
+          (*this)(e);
+        }
+      }
+      void operator()(std::string& s) { bytes += sizeof(std::uint64_t) + s.size(); }
+    };
+
+    /**
+     * \brief Archive that appends the state to a memory image (sizes as uint64, then raw elements).
+     */
+    class StateWriter {
+    public:
+      explicit StateWriter(std::vector<char>& image) : image_(image) {}
+      void raw(const void* data, std::size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        image_.insert(image_.end(), p, p+bytes);
+      }
+      template <typename T>
+      void operator()(T& v) { raw(&v, sizeof(T)); }
+      template <typename T>
+      void operator()(std::vector<T>& v) {
+        const std::uint64_t n = v.size();
+        raw(&n, sizeof(n));
+        raw(v.data(), v.size()*sizeof(T));
+      }
+      template <typename T>
+      void operator()(std::vector<std::vector<T>>& v) {
+        const std::uint64_t n = v.size();
+        raw(&n, sizeof(n));
+        for (std::vector<T>& e : v) {
+          (*this)(e);
+        }
+      }
+      void operator()(std::string& s) {
+        const std::uint64_t n = s.size();
+        raw(&n, sizeof(n));
+        raw(s.data(), s.size());
+      }
+    private:
+      std::vector<char>& image_;
+    };
+
+    /**
+     * \brief Archive that writes the state to a file in the format of `StateWriter`, in chunks of 64 MiB.
+     */
+    class StreamWriter {
+    public:
+      explicit StreamWriter(std::ostream& os) : os_(os) {}
+      void raw(const void* data, std::size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        const std::size_t chunk = std::size_t(1) << 26;
+        for (std::size_t pos=0; os_ && pos<bytes; pos+=chunk) {
+          os_.write(p+pos, static_cast<std::streamsize>(std::min(chunk, bytes-pos)));
+        }
+      }
+      template <typename T>
+      void operator()(const T& v) { raw(&v, sizeof(T)); }
+      template <typename T>
+      void operator()(const std::vector<T>& v) {
+        const std::uint64_t n = v.size();
+        raw(&n, sizeof(n));
+        raw(v.data(), v.size()*sizeof(T));
+      }
+      template <typename T>
+      void operator()(const std::vector<std::vector<T>>& v) {
+        const std::uint64_t n = v.size();
+        raw(&n, sizeof(n));
+        for (const std::vector<T>& e : v) {
+          (*this)(e);
+        }
+      }
+    private:
+      std::ostream& os_;
+    };
+
+    /**
+     * \brief Archive that reads the state from a file; sizes beyond the end of the file are rejected.
+     */
+    class StateReader {
+    public:
+      StateReader(std::istream& is, std::uint64_t remaining) : is_(is), remaining_(remaining), ok_(true) {}
+      bool ok() const { return ok_; }
+      void raw(void* data, std::size_t bytes) {
+        if (!ok_ || bytes > remaining_ || !is_.read(static_cast<char*>(data), static_cast<std::streamsize>(bytes))) {
+          ok_ = false;
+          return;
+        }
+        remaining_ -= bytes;
+      }
+      template <typename T>
+      void operator()(T& v) { raw(&v, sizeof(T)); }
+      template <typename T>
+      void operator()(std::vector<T>& v) {
+        const std::uint64_t n = size(sizeof(T));
+        v.resize(n);
+        raw(v.data(), n*sizeof(T));
+      }
+      template <typename T>
+      void operator()(std::vector<std::vector<T>>& v) {
+        v.resize(size(sizeof(std::uint64_t)));
+        for (std::vector<T>& e : v) {
+          (*this)(e);
+        }
+      }
+      void operator()(std::string& s) {
+        s.resize(size(1));
+        raw(&s[0], s.size());
+      }
+    private:
+      std::uint64_t size(std::size_t element) {
+        std::uint64_t n = 0;
+        raw(&n, sizeof(n));
+        if (!ok_ || n > remaining_/element) {
+          ok_ = false;
+          return 0;
+        }
+        return n;
+      }
+      std::istream& is_;
+      std::uint64_t remaining_;
+      bool ok_;
+    };
+  }
+
+  Solver::Solver(std::size_t matrix_size, std::size_t shift_size, bool standard)
     : iter_(1),
       matrix_size_(matrix_size),
       shift_size_(shift_size),
+      standard_(standard),
       r0_norm_(0.0),
       sigma_(shift_size, {0.0, 0.0}),
       alpha_(0.0),
@@ -24,23 +189,78 @@ namespace gsminres {
       w_prev_(matrix_size, {0.0, 0.0}),
       w_curr_(matrix_size, {0.0, 0.0}),
       w_next_(matrix_size, {0.0, 0.0}),
-      u_prev_(matrix_size, {0.0, 0.0}),
-      u_curr_(matrix_size, {0.0, 0.0}),
-      u_next_(matrix_size, {0.0, 0.0}),
+      u_prev_(standard ? 0 : matrix_size, {0.0, 0.0}),
+      u_curr_(standard ? 0 : matrix_size, {0.0, 0.0}),
+      u_next_(standard ? 0 : matrix_size, {0.0, 0.0}),
       T_prev2_(1, {0.0, 0.0}),
       T_prev_( 1, {0.0, 0.0}),
       T_curr_( 1, {0.0, 0.0}),
       T_next_( 1, {0.0, 0.0}),
       Gc_(shift_size, std::array<double, 3>{0.0, 0.0, 0.0}),
       Gs_(shift_size, std::array<std::complex<double>, 3>{{{0.0,0.0}, {0.0,0.0}, {0.0,0.0}}}),
-      p_prev2_(shift_size*matrix_size, {0.0, 0.0}),
-      p_prev_( shift_size*matrix_size, {0.0, 0.0}),
-      p_curr_( shift_size*matrix_size, {0.0, 0.0}),
+      p_prev2_(shift_size, std::vector<std::complex<double>>(matrix_size, {0.0, 0.0})),
+      p_prev_( shift_size, std::vector<std::complex<double>>(matrix_size, {0.0, 0.0})),
+      p_curr_( shift_size, std::vector<std::complex<double>>(matrix_size, {0.0, 0.0})),
       f_(shift_size, {1.0, 0.0}),
       h_(shift_size, 1.0),
       conv_num_(0),
       is_conv_(shift_size, 0),
-      threshold_(1e-12) {
+      stall_num_(0),
+      stall_(shift_size, 0),
+      threshold_(1e-12),
+      on_converged_(),
+      reduce_(),
+      upd_shift_(),
+      upd_coef_(),
+      conv_shift_(),
+      block_size_(1),
+      blk_len_(0),
+      W_(),
+      blk_coef_(),
+      blk_count_(),
+      lz_alpha_(),
+      lz_beta_(1, 0.0),
+      log_capacity_(0),
+      log_stride_(1),
+      log_count_(0),
+      log_res_(),
+      log_iter_(),
+      log_output_(),
+      aud_interval_(0),
+      aud_drift_(0.0),
+      aud_stop_(false),
+      aud_last_(0),
+      aud_res_(shift_size, -1.0),
+      aud_flag_(shift_size, 0),
+      reorth_(false),
+      reorth_next_(false),
+      reorth_count_(0),
+      reorth_set_(),
+      reorth_col_(),
+      reorth_ptr_(1, 0),
+      reorth_row_(),
+      reorth_coef_(),
+      reorth_xi_(shift_size),
+      omega_prev_(),
+      omega_curr_(),
+      hist_w_(),
+      hist_u_(),
+      ckpt_pending_(),
+      work_threads_(0),
+      workers_(),
+      work_mtx_(),
+      work_cv_(),
+      done_cv_(),
+      work_gen_(0),
+      work_left_(0),
+      work_stop_(false),
+      pending_x_(nullptr),
+      pending_(false) {
+  }
+
+  Solver::~Solver() {
+    checkpoint_sync();
+    stop_workers();
   }
 
   void Solver::initialize(std::vector<std::complex<double>>& x,
@@ -48,36 +268,344 @@ namespace gsminres {
                           std::vector<std::complex<double>>& w,
                           const std::vector<std::complex<double>>& sigma,
                           const double threshold) {
+    checkpoint_sync();
     blas::zdscal(shift_size_*matrix_size_, 0.0, x);
-    r0_norm_ = std::sqrt((blas::zdotc(matrix_size_, b, 0, w, 0)).real());
+    r0_norm_ = std::sqrt(allsum((blas::zdotc(matrix_size_, b, 0, w, 0)).real()));
     blas::zcopy(matrix_size_, w, 0, w_curr_, 0);
-    blas::zcopy(matrix_size_, b, 0, u_curr_, 0);
     blas::zdscal(matrix_size_, 1.0/r0_norm_, w_curr_);
-    blas::zdscal(matrix_size_, 1.0/r0_norm_, u_curr_);
+    if (!standard_) {
+      blas::zcopy(matrix_size_, b, 0, u_curr_, 0);
+      blas::zdscal(matrix_size_, 1.0/r0_norm_, u_curr_);
+    }
     blas::zcopy(matrix_size_, w_curr_, 0, w, 0);
     blas::dscal(shift_size_, r0_norm_, h_);
     blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
     threshold_ = threshold;
+    lz_alpha_.clear();
+    lz_beta_.assign(1, 0.0);
+    log_count_ = 0;
+    aud_last_  = 0;
+    aud_res_.assign(shift_size_, -1.0);
+    aud_flag_.assign(shift_size_, 0);
+    if (reorth_) {
+      hist_w_ = w_curr_;
+      hist_u_ = u_curr_;
+      omega_prev_.clear();
+      omega_curr_.assign(1, 1.0);
+      reorth_set_.clear();
+      reorth_next_  = false;
+      reorth_count_ = 0;
+      reorth_col_.clear();
+      reorth_ptr_.assign(1, 0);
+      reorth_row_.clear();
+      reorth_coef_.clear();
+      reorth_xi_.assign(shift_size_, std::vector<std::complex<double>>());
+    }
   }
 
   void Solver::glanczos_pre(std::vector<std::complex<double>>& u) {
-    alpha_ = (blas::zdotc(matrix_size_, w_curr_, 0, u, 0)).real();
-    blas::zaxpy(matrix_size_, -alpha_,     u_curr_, 0, u, 0);
-    blas::zaxpy(matrix_size_, -beta_prev_, u_prev_, 0, u, 0);
+    // Reads w, u twice, u_curr, u_prev and writes u
+    GSMINRES_PROFILE_KERNEL("glanczos_pre", iter_, 96.0*matrix_size_, 12.0*matrix_size_);
+    // Sweep 1: alpha = Re(w^H u). Sweep 2: u -= alpha u_curr + beta_prev u_prev in one pass.
+    alpha_ = allsum(real_dot(matrix_size_, w_curr_.data(), u.data()));
+    const double a = alpha_, b = beta_prev_;
+    std::complex<double>*       uu = u.data();
+    // In the standard mode u = w, so the Lanczos vectors themselves are used
+    const std::complex<double>* uc = standard_ ? w_curr_.data() : u_curr_.data();
+    const std::complex<double>* up = standard_ ? w_prev_.data() : u_prev_.data();
+    const std::size_t n = matrix_size_;
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i=0; i<n; i++) {
+      uu[i] -= a*uc[i] + b*up[i];
+    }
   }
 
   void Solver::glanczos_pst(std::vector<std::complex<double>>& w,
                             std::vector<std::complex<double>>& u) {
-    beta_curr_ = std::sqrt((blas::zdotc(matrix_size_, u, 0, w, 0)).real());
-    blas::zdscal(matrix_size_, 1.0/beta_curr_, w);
-    blas::zdscal(matrix_size_, 1.0/beta_curr_, u);
-    blas::zcopy(matrix_size_, w, 0, w_next_, 0);
-    blas::zcopy(matrix_size_, u, 0, u_next_, 0);
+    // Reads u, w twice and writes w, w_next (and u_next)
+    GSMINRES_PROFILE_KERNEL("glanczos_pst", iter_, (standard_ ? 80.0 : 112.0)*matrix_size_,
+                            (standard_ ? 6.0 : 8.0)*matrix_size_);
+    // Sweep 1: beta = sqrt(Re(u^H w)). Sweep 2: the normalized vectors are written
+    // directly into the solver's buffers (and w back to the caller for the next multiplication).
+    beta_curr_ = std::sqrt(allsum(real_dot(matrix_size_, u.data(), w.data())));
+    const double inv = 1.0/beta_curr_;
+    std::complex<double>*       ww = w.data();
+    const std::complex<double>* uu = u.data();
+    std::complex<double>*       wn = w_next_.data();
+    std::complex<double>*       un = u_next_.data();
+    const std::size_t n = matrix_size_;
+    if (standard_) {
+      #pragma omp parallel for schedule(static)
+      for (std::size_t i=0; i<n; i++) {
+        const std::complex<double> v = ww[i]*inv;
+        wn[i] = v;
+        ww[i] = v;
+      }
+      if (reorth_) {
+        reorthogonalize(w);
+      }
+      return;
+    }
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i=0; i<n; i++) {
+      const std::complex<double> v = ww[i]*inv;
+      wn[i] = v;
+      ww[i] = v;
+      un[i] = uu[i]*inv;
+    }
+    if (reorth_) {
+      reorthogonalize(w);
+    }
+  }
+
+  void Solver::glanczos(std::vector<std::complex<double>>& v) {
+    if (!standard_) {
+      std::cerr << "Solver::glanczos: [ERROR] Only available in the standard mode (B = I)" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    // Sweep 1: alpha = Re(w^H v).
+    // Sweep 2: v -= alpha w_curr + beta_prev w_prev, accumulating ||v||^2 at the same time.
+    // Sweep 3: normalization into the caller's v and w_next_.
+    alpha_ = allsum(real_dot(matrix_size_, w_curr_.data(), v.data()));
+    const double a = alpha_, b = beta_prev_;
+    std::complex<double>*       vv = v.data();
+    const std::complex<double>* wc = w_curr_.data();
+    const std::complex<double>* wp = w_prev_.data();
+    std::complex<double>*       wn = w_next_.data();
+    const std::size_t n = matrix_size_;
+    double nrm2 = 0.0;
+    #pragma omp parallel for reduction(+:nrm2) schedule(static)
+    for (std::size_t i=0; i<n; i++) {
+      const std::complex<double> t = vv[i] - (a*wc[i] + b*wp[i]);
+      vv[i] = t;
+      nrm2 += t.real()*t.real() + t.imag()*t.imag();
+    }
+    beta_curr_ = std::sqrt(allsum(nrm2));
+    const double inv = 1.0/beta_curr_;
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i=0; i<n; i++) {
+      const std::complex<double> t = vv[i]*inv;
+      wn[i] = t;
+      vv[i] = t;
+    }
+    if (reorth_) {
+      reorthogonalize(v);
+    }
+  }
+
+  void Solver::reorthogonalize(std::vector<std::complex<double>>& w) {
+    GSMINRES_PROFILE_SCOPE("reorthogonalize", iter_);
+    const std::size_t N = matrix_size_;
+    const std::size_t k = omega_curr_.size(); // Number of stored Lanczos vectors w_1, ..., w_k
+    const double eps  = std::numeric_limits<double>::epsilon();
+    const double eps1 = eps*std::sqrt(static_cast<double>(N));
+
+    // omega-recurrence (Simon): estimate of (w_{k+1}, w_j)_B from (w_k, .)_B and (w_{k-1}, .)_B
+    std::vector<double> omega_next(k+1, 0.0);
+    for (std::size_t j=1; j<k; j++) {
+      double num = lz_beta_[j]*omega_curr_[j]
+                 + (lz_alpha_[j-1]-alpha_)*omega_curr_[j-1]
+                 - lz_beta_[k-1]*omega_prev_[j-1];
+      if (j > 1) {
+        num += lz_beta_[j-1]*omega_curr_[j-2];
+      }
+      num += (num >= 0.0 ? 1.0 : -1.0)*eps1*(lz_beta_[j] + beta_curr_);
+      omega_next[j-1] = num/beta_curr_;
+    }
+    if (k > 0) {
+      omega_next[k-1] = eps1;
+    }
+    omega_next[k] = 1.0;
+
+    double omega_max = 0.0;
+    for (std::size_t j=0; j<k; j++) {
+      omega_max = std::max(omega_max, std::abs(omega_next[j]));
+    }
+    if (omega_max > std::sqrt(eps) || reorth_next_) {
+      // The vector after a reorthogonalized one is orthogonalized against the same vectors too
+      if (!reorth_next_) {
+        reorth_set_.clear();
+      }
+      const double eta = std::pow(eps, 0.75);
+      for (std::size_t j=0; j<k; j++) {
+        if (std::abs(omega_next[j]) > eta &&
+            std::find(reorth_set_.begin(), reorth_set_.end(), j) == reorth_set_.end()) {
+          reorth_set_.push_back(j);
+        }
+      }
+      reorth_next_ = !reorth_next_;
+      // Classical Gram-Schmidt in the B-inner product, with one reduction for all coefficients
+      const std::vector<std::complex<double>>& U = standard_ ? hist_w_ : hist_u_;
+      std::vector<std::complex<double>> c(reorth_set_.size());
+      for (std::size_t i=0; i<reorth_set_.size(); i++) {
+        c[i] = blas::zdotc(N, U, reorth_set_[i]*N, w_next_, 0);
+      }
+      if (reduce_ && !c.empty()) {
+        reduce_(reinterpret_cast<double*>(c.data()), 2*c.size());
+      }
+      // A w_k = B(beta_prev w_{k-1} + alpha w_k + beta sum_j c_j w_j + beta' w_{k+1}): the middle sum is
+      // dropped from the tridiagonal matrix, so it is kept for the loss estimate in update_scalars()
+      reorth_col_.push_back(iter_);
+      for (std::size_t i=0; i<reorth_set_.size(); i++) {
+        reorth_row_.push_back(reorth_set_[i]);
+        reorth_coef_.push_back(beta_curr_*c[i]);
+      }
+      reorth_ptr_.push_back(reorth_row_.size());
+      for (std::size_t i=0; i<reorth_set_.size(); i++) {
+        blas::zaxpy(N, -c[i], hist_w_, reorth_set_[i]*N, w_next_, 0);
+        if (!standard_) {
+          blas::zaxpy(N, -c[i], hist_u_, reorth_set_[i]*N, u_next_, 0);
+        }
+        omega_next[reorth_set_[i]] = eps1;
+      }
+      const double nu = std::sqrt(allsum(standard_ ? real_dot(N, w_next_.data(), w_next_.data())
+                                                   : real_dot(N, u_next_.data(), w_next_.data())));
+      blas::zdscal(N, 1.0/nu, w_next_);
+      if (!standard_) {
+        blas::zdscal(N, 1.0/nu, u_next_);
+      }
+      beta_curr_ *= nu;
+      blas::zcopy(N, w_next_, 0, w, 0);
+      reorth_count_++;
+    }
+    omega_prev_.swap(omega_curr_);
+    omega_curr_.swap(omega_next);
+    hist_w_.insert(hist_w_.end(), w_next_.begin(), w_next_.end());
+    if (!standard_) {
+      hist_u_.insert(hist_u_.end(), u_next_.begin(), u_next_.end());
+    }
+  }
+
+  void Solver::glanczos_set(const double alpha, const double beta,
+                            const std::vector<std::complex<double>>& w, std::size_t offset) {
+    alpha_     = alpha;
+    beta_curr_ = beta;
+    blas::zcopy(matrix_size_, w, offset, w_next_, 0);
+  }
+
+  double Solver::reorth_loss(std::size_t m) const {
+    if (reorth_col_.empty()) {
+      return 0.0;
+    }
+    // g = C y: the coefficients of each column weighted by the coordinate of x along its Lanczos vector
+    const std::vector<std::complex<double>>& xi = reorth_xi_[m];
+    std::vector<std::complex<double>> g(omega_curr_.size(), {0.0, 0.0});
+    for (std::size_t e=0; e<reorth_col_.size(); e++) {
+      for (std::size_t i=reorth_ptr_[e]; i<reorth_ptr_[e+1]; i++) {
+        g[reorth_row_[i]] += reorth_coef_[i]*xi[3*e+2];
+      }
+    }
+    double nrm2 = 0.0;
+    for (const std::complex<double>& v : g) {
+      nrm2 += std::norm(v);
+    }
+    return std::sqrt(nrm2);
+  }
+
+  void Solver::get_lanczos(double& alpha, double& beta) const {
+    alpha = alpha_;
+    beta  = beta_curr_;
   }
 
   bool Solver::update(std::vector<std::complex<double>>& x) {
+    checkpoint_sync();
+    update_wait();
+    bool converged = update_scalars();
+    update_vectors(x);
+    release_converged(x);
+    return converged;
+  }
+
+  bool Solver::update_begin(std::vector<std::complex<double>>& x) {
+    checkpoint_sync();
+    update_wait();
+    bool converged = update_scalars();
+    if (workers_.empty()) {
+      std::size_t n = work_threads_;
+      if (n == 0) {
+        n = std::max<std::size_t>(1, std::thread::hardware_concurrency()/2);
+      }
+      n = std::max<std::size_t>(1, std::min(n, shift_size_));
+      work_stop_ = false;
+      for (std::size_t t=0; t<n; t++) {
+        workers_.emplace_back(&Solver::update_loop, this, t, n, work_gen_);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(work_mtx_);
+      pending_x_ = &x;
+      work_left_ = workers_.size();
+      work_gen_++;
+    }
+    pending_ = true;
+    work_cv_.notify_all();
+    return converged;
+  }
+
+  void Solver::update_wait() {
+    if (!pending_) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lock(work_mtx_);
+      done_cv_.wait(lock, [this]() { return work_left_ == 0; });
+    }
+    pending_ = false;
+    release_converged(*pending_x_);
+    pending_x_ = nullptr;
+  }
+
+  void Solver::update_loop(std::size_t part, std::size_t parts, std::size_t seen) {
+    for (;;) {
+      std::vector<std::complex<double>>* x = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(work_mtx_);
+        work_cv_.wait(lock, [&]() { return work_stop_ || work_gen_ != seen; });
+        if (work_stop_) {
+          return;
+        }
+        seen = work_gen_;
+        x = pending_x_;
+      }
+      update_vectors(*x, part, parts);
+      std::lock_guard<std::mutex> lock(work_mtx_);
+      if (--work_left_ == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  void Solver::stop_workers() {
+    if (workers_.empty()) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lock(work_mtx_);
+      done_cv_.wait(lock, [this]() { return work_left_ == 0; });
+      work_stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread& t : workers_) {
+      t.join();
+    }
+    workers_.clear();
+  }
+
+  void Solver::set_update_threads(std::size_t n) {
+    update_wait();
+    stop_workers();
+    work_threads_ = n;
+  }
+
+  bool Solver::update_scalars() {
+    GSMINRES_PROFILE_SCOPE("update_scalars", iter_);
+    lz_alpha_.push_back(alpha_);
+    lz_beta_.push_back(beta_curr_);
+    upd_shift_.clear();
+    upd_coef_.clear();
+    bool newly_converged = false;
     for (std::size_t m=0; m<shift_size_; m++) {
-      if (is_conv_[m] != 0) {
+      if (is_conv_[m] != 0 || stall_[m] != 0) {
         continue;
       }
       T_prev2_[0] = 0.0;
@@ -92,45 +620,637 @@ namespace gsminres {
       }
       blas::zrotg(T_curr_[0], T_next_[0], Gc_[m][2], Gs_[m][2]);
       //lapack::zlartg(T_curr_[0], T_next_[0], Gc_[m][2], Gs_[m][2]);
-      std::size_t offset = m*matrix_size_;
-      blas::zcopy(matrix_size_, p_prev_, offset, p_prev2_, offset);
-      blas::zcopy(matrix_size_, p_curr_, offset, p_prev_,  offset);
-      blas::zcopy(matrix_size_, w_curr_,    0,   p_curr_,  offset);
-      blas::zaxpy(matrix_size_, -T_prev2_[0], p_prev2_, offset, p_curr_, offset);
-      blas::zaxpy(matrix_size_, -T_prev_[0],  p_prev_,  offset, p_curr_, offset);
-      blas::zscal(matrix_size_, 1.0/T_curr_[0], p_curr_, offset);
-      blas::zaxpy(matrix_size_, r0_norm_*Gc_[m][2]*f_[m], p_curr_, offset, x, offset);
+      upd_shift_.push_back(m);
+      upd_coef_.push_back({T_prev2_[0], T_prev_[0], 1.0/T_curr_[0], r0_norm_*Gc_[m][2]*f_[m]});
+      if (!reorth_col_.empty()) {
+        // Coordinates of p_prev, p_curr and x along the reorthogonalized columns, by the same recurrence
+        // as update_vectors(); the new Lanczos vector w_k contributes to its own column only
+        const std::array<std::complex<double>, 4>& c = upd_coef_.back();
+        std::vector<std::complex<double>>& xi = reorth_xi_[m];
+        xi.resize(3*reorth_col_.size(), {0.0, 0.0});
+        for (std::size_t e=0; e<reorth_col_.size(); e++) {
+          const std::complex<double> p = ((reorth_col_[e] == iter_ ? 1.0 : 0.0) - c[0]*xi[3*e] - c[1]*xi[3*e+1])*c[2];
+          xi[3*e]    = xi[3*e+1];
+          xi[3*e+1]  = p;
+          xi[3*e+2] += c[3]*p;
+        }
+      }
       f_[m] = -std::conj(Gs_[m][2]) * f_[m];
       h_[m] = std::abs(-std::conj(Gs_[m][2])) * h_[m];
-      if (h_[m]/r0_norm_ < threshold_) {
+      // With reorthogonalization, the residual left by the discarded coefficients is added
+      double loss = 0.0;
+      if (!reorth_col_.empty() && h_[m]/r0_norm_ < std::max(threshold_, std::sqrt(std::numeric_limits<double>::epsilon()))) {
+        loss = reorth_loss(m);
+      }
+      if ((h_[m] + loss)/r0_norm_ < threshold_) {
+        h_[m] += loss;
         conv_num_++;
         is_conv_[m] = iter_;
+        conv_shift_.push_back(m);
+        newly_converged = true;
+        continue;
+      }
+      if (loss >= threshold_*r0_norm_ && h_[m] < loss) {
+        // The loss alone exceeds the threshold and further iterations do not reduce it:
+        // stop iterating the shift without reporting it as converged
+        h_[m] += loss;
+        stall_num_++;
+        stall_[m] = iter_;
+        conv_shift_.push_back(m);
+        newly_converged = true;
         continue;
       }
       Gc_[m][0] = Gc_[m][1]; Gc_[m][1] = Gc_[m][2];
       Gs_[m][0] = Gs_[m][1]; Gs_[m][1] = Gs_[m][2];
     }
+    if (log_capacity_ > 0 && (iter_ % log_stride_ == 0 || newly_converged)) {
+      record_history();
+    }
+    // After the rotation, w_prev_ holds the Lanczos vector of this iteration for update_vectors()
+    // and is not touched by the generalized Lanczos process until the next update.
     beta_prev_ = beta_curr_;
-    blas::zcopy(matrix_size_, w_curr_, 0, w_prev_, 0);
-    blas::zcopy(matrix_size_, w_next_, 0, w_curr_, 0);
-    blas::zcopy(matrix_size_, u_curr_, 0, u_prev_, 0);
-    blas::zcopy(matrix_size_, u_next_, 0, u_curr_, 0);
+    w_prev_.swap(w_curr_);
+    w_curr_.swap(w_next_);
+    u_prev_.swap(u_curr_);
+    u_curr_.swap(u_next_);
     iter_++;
-    if (conv_num_ >= shift_size_) {
+    if (conv_num_ + stall_num_ >= shift_size_) {
       return true;
     }
     return false;
   }
 
+  void Solver::update_vectors(std::vector<std::complex<double>>& x, std::size_t part, std::size_t parts) {
+    // update_scalars() has already advanced the iteration counter
+    GSMINRES_PROFILE_SCOPE("update_vectors", iter_-1);
+    if (block_size_ > 1) {
+      if (part != 0) {
+        return;
+      }
+      // Deferred mode: keep the Lanczos vector and the coefficients until the block is full
+      blas::zcopy(matrix_size_, w_prev_, 0, W_, blk_len_*matrix_size_);
+      for (std::size_t k=0; k<upd_shift_.size(); k++) {
+        const std::size_t m = upd_shift_[k];
+        blk_coef_[m*block_size_ + blk_count_[m]] = upd_coef_[k];
+        blk_count_[m]++;
+      }
+      blk_len_++;
+      if (blk_len_ >= block_size_ || conv_num_ + stall_num_ >= shift_size_) {
+        apply_block(x);
+      }
+      return;
+    }
+    // The shifts are independent: each part updates every parts-th of them
+    for (std::size_t k=part; k<upd_shift_.size(); k+=parts) {
+      const std::size_t m = upd_shift_[k];
+      const std::array<std::complex<double>, 4>& c = upd_coef_[k];
+      std::size_t offset = m*matrix_size_;
+      // Rotate the auxiliary vectors by swapping; the oldest one is overwritten by w
+      p_prev2_[m].swap(p_prev_[m]);
+      p_prev_[m].swap(p_curr_[m]);
+      blas::zcopy(matrix_size_, w_prev_, 0, p_curr_[m], 0);
+      blas::zaxpy(matrix_size_, -c[0], p_prev2_[m], 0, p_curr_[m], 0);
+      blas::zaxpy(matrix_size_, -c[1], p_prev_[m],  0, p_curr_[m], 0);
+      blas::zscal(matrix_size_, c[2], p_curr_[m]);
+      blas::zaxpy(matrix_size_, c[3], p_curr_[m], 0, x, offset);
+    }
+  }
+
+  void Solver::apply_block(std::vector<std::complex<double>>& x) {
+    const std::size_t N = matrix_size_, s = blk_len_, ld = s + 2;
+    // For each shift, express the last two auxiliary vectors and the increment of x
+    // in the basis [p_prev2, p_prev, w_1, ..., w_s] by running the recurrence on coefficients.
+    // C[m] is a (s+2) x 3 column-major matrix.
+    std::vector<std::size_t> active;
+    std::vector<std::complex<double>> C(shift_size_*ld*3, {0.0, 0.0});
+    std::vector<std::complex<double>> V;
+    for (std::size_t m=0; m<shift_size_; m++) {
+      const std::size_t n = blk_count_[m];
+      if (n == 0) {
+        continue;
+      }
+      active.push_back(m);
+      V.assign((n+2)*ld, {0.0, 0.0});
+      V[0*ld+0] = 1.0;
+      V[1*ld+1] = 1.0;
+      std::complex<double>* dx = C.data() + (m*3+2)*ld;
+      for (std::size_t t=0; t<n; t++) {
+        const std::array<std::complex<double>, 4>& c = blk_coef_[m*block_size_+t];
+        std::complex<double>* v = V.data() + (t+2)*ld;
+        for (std::size_t r=0; r<ld; r++) {
+          v[r] = (((r == t+2) ? 1.0 : 0.0) - c[0]*V[t*ld+r] - c[1]*V[(t+1)*ld+r]) * c[2];
+          dx[r] += c[3] * v[r];
+        }
+      }
+      for (std::size_t r=0; r<ld; r++) {
+        C[(m*3+0)*ld+r] = V[n*ld+r];
+        C[(m*3+1)*ld+r] = V[(n+1)*ld+r];
+      }
+      blk_count_[m] = 0;
+    }
+    // Reads W once, reads and writes p_prev2, p_prev and x of every active shift;
+    // 3 columns of s+2 complex multiply-adds (8 flops each) per row and shift
+    const double nact = static_cast<double>(active.size());
+    GSMINRES_PROFILE_KERNEL("apply_block", iter_-1, 16.0*s*N + 96.0*N*nact, 24.0*(s+2)*N*nact);
+    // Row-tiled small GEMM [p_prev2, p_prev, W] * C[m]. The tile of W stays in cache
+    // while it is reused for all shifts, and p and x are streamed once per block.
+    const std::size_t tile = 256;
+    const std::complex<double>* W = W_.data();
+    #pragma omp parallel for schedule(static)
+    for (std::size_t i0=0; i0<N; i0+=tile) {
+      const std::size_t i1 = (i0+tile < N) ? i0+tile : N;
+      for (std::size_t m : active) {
+        const std::complex<double>* c0 = C.data() + (m*3+0)*ld;
+        const std::complex<double>* c1 = C.data() + (m*3+1)*ld;
+        const std::complex<double>* c2 = C.data() + (m*3+2)*ld;
+        std::complex<double>* p2 = p_prev2_[m].data();
+        std::complex<double>* p1 = p_prev_[m].data();
+        std::complex<double>* xm = x.data() + m*N;
+        for (std::size_t i=i0; i<i1; i++) {
+          // Complex products are expanded by hand: std::complex multiplication
+          // would otherwise go through the NaN-checking library routine.
+          const double ar = p2[i].real(), ai = p2[i].imag();
+          const double br = p1[i].real(), bi = p1[i].imag();
+          double y0r = c0[0].real()*ar - c0[0].imag()*ai + c0[1].real()*br - c0[1].imag()*bi;
+          double y0i = c0[0].real()*ai + c0[0].imag()*ar + c0[1].real()*bi + c0[1].imag()*br;
+          double y1r = c1[0].real()*ar - c1[0].imag()*ai + c1[1].real()*br - c1[1].imag()*bi;
+          double y1i = c1[0].real()*ai + c1[0].imag()*ar + c1[1].real()*bi + c1[1].imag()*br;
+          double y2r = c2[0].real()*ar - c2[0].imag()*ai + c2[1].real()*br - c2[1].imag()*bi;
+          double y2i = c2[0].real()*ai + c2[0].imag()*ar + c2[1].real()*bi + c2[1].imag()*br;
+          for (std::size_t t=0; t<s; t++) {
+            const double wr = W[t*N+i].real(), wi = W[t*N+i].imag();
+            y0r += c0[t+2].real()*wr - c0[t+2].imag()*wi;
+            y0i += c0[t+2].real()*wi + c0[t+2].imag()*wr;
+            y1r += c1[t+2].real()*wr - c1[t+2].imag()*wi;
+            y1i += c1[t+2].real()*wi + c1[t+2].imag()*wr;
+            y2r += c2[t+2].real()*wr - c2[t+2].imag()*wi;
+            y2i += c2[t+2].real()*wi + c2[t+2].imag()*wr;
+          }
+          p2[i] = {y0r, y0i};
+          p1[i] = {y1r, y1i};
+          xm[i] = {xm[i].real() + y2r, xm[i].imag() + y2i};
+        }
+      }
+    }
+    blk_len_ = 0;
+  }
+
+  void Solver::flush(std::vector<std::complex<double>>& x) {
+    checkpoint_sync();
+    update_wait();
+    if (blk_len_ > 0) {
+      apply_block(x);
+    }
+    release_converged(x);
+  }
+
+  void Solver::set_update_block_size(std::size_t s) {
+    checkpoint_sync();
+    update_wait();
+    block_size_ = (s > 0) ? s : 1;
+    blk_len_ = 0;
+    if (block_size_ > 1) {
+      W_.assign(block_size_*matrix_size_, {0.0, 0.0});
+      blk_coef_.assign(block_size_*shift_size_, std::array<std::complex<double>, 4>{});
+      blk_count_.assign(shift_size_, 0);
+      // apply_block() keeps the last two auxiliary vectors in p_prev2 and p_prev: p_curr is not used
+      for (std::size_t m=0; m<shift_size_; m++) {
+        std::vector<std::complex<double>>().swap(p_curr_[m]);
+      }
+    } else {
+      std::vector<std::complex<double>>().swap(W_);
+      std::vector<std::array<std::complex<double>, 4>>().swap(blk_coef_);
+      std::vector<std::size_t>().swap(blk_count_);
+      for (std::size_t m=0; m<shift_size_; m++) {
+        if (is_conv_[m] == 0 && stall_[m] == 0) {
+          p_curr_[m].assign(matrix_size_, {0.0, 0.0});
+        }
+      }
+    }
+  }
+
+  void Solver::release_converged(std::vector<std::complex<double>>& x) {
+    if (blk_len_ > 0) {
+      // The solutions of the current block are not final yet; see flush()
+      return;
+    }
+    for (std::size_t m : conv_shift_) {
+      // x^{(m)} is final: release its auxiliary vectors and hand it over (stalled shifts are not handed over)
+      std::vector<std::complex<double>>().swap(p_prev2_[m]);
+      std::vector<std::complex<double>>().swap(p_prev_[m]);
+      std::vector<std::complex<double>>().swap(p_curr_[m]);
+      if (on_converged_ && is_conv_[m] != 0) {
+        on_converged_(m, x.data()+m*matrix_size_, matrix_size_);
+      }
+    }
+    conv_shift_.clear();
+  }
+
   void Solver::finalize(std::vector<std::size_t>& conv_itr,
                         std::vector<double>&      conv_res) {
     // 当初はメモリの解放などを行う予定だったが
     // (動的な確保をおこなっていないため)不要なので収束までの反復回数と残差のノルムを返す関数とする
     conv_itr = is_conv_;
     conv_res = h_;
+    if (!log_output_.empty()) {
+      const std::string ext = ".bin";
+      const bool binary = log_output_.size() >= ext.size()
+        && log_output_.compare(log_output_.size()-ext.size(), ext.size(), ext) == 0;
+      if (!write_history(log_output_, binary) || !write_diagnostics(log_output_ + ".diag.csv")) {
+        std::cerr << "Solver::finalize: [WARNING] Cannot write the residual history to " << log_output_ << std::endl;
+      }
+    }
   }
 
   void Solver::get_residual(std::vector<double>& res) const {
     blas::dcopy(shift_size_, h_, 0, res, 0);
   }
+
+  const std::vector<double>& Solver::get_residual_view() const {
+    return h_;
+  }
+
+  void Solver::set_audit(std::size_t interval, double drift, bool stop) {
+    aud_interval_ = interval;
+    aud_drift_    = drift;
+    aud_stop_     = stop;
+  }
+
+  bool Solver::audit_due(std::vector<std::size_t>& shifts) {
+    shifts.clear();
+    if (aud_drift_ <= 0.0) {
+      return false;
+    }
+    update_wait();
+    if (blk_len_ > 0) {
+      return false;
+    }
+    const std::size_t done = iter_-1;
+    bool due = aud_interval_ > 0 && done >= aud_last_ + aud_interval_;
+    for (std::size_t m=0; m<shift_size_; m++) {
+      const std::size_t finished = (is_conv_[m] != 0) ? is_conv_[m] : stall_[m];
+      if (finished == 0) {
+        shifts.push_back(m);
+      } else if (finished > aud_last_ && aud_flag_[m] == 0) {
+        shifts.push_back(m);
+        due = true;
+      }
+    }
+    if (!due) {
+      shifts.clear();
+    }
+    return due && !shifts.empty();
+  }
+
+  std::size_t Solver::audit(const std::vector<std::size_t>& shifts, const std::vector<double>& true_res,
+                            std::vector<std::complex<double>>& x) {
+    checkpoint_sync();
+    update_wait();
+    const std::size_t done = iter_-1;
+    std::size_t count = 0;
+    for (std::size_t k=0; k<shifts.size(); k++) {
+      const std::size_t m = shifts[k];
+      aud_res_[m] = true_res[k];
+      if (aud_flag_[m] != 0 || true_res[k] <= aud_drift_*std::max(h_[m]/r0_norm_, threshold_)) {
+        continue;
+      }
+      aud_flag_[m] = done;
+      count++;
+      if (aud_stop_ && is_conv_[m] == 0 && stall_[m] == 0) {
+        is_conv_[m] = done;
+        conv_num_++;
+        conv_shift_.push_back(m);
+      }
+    }
+    aud_last_ = done;
+    release_converged(x);
+    return count;
+  }
+
+  void Solver::get_audit(std::vector<double>& true_res, std::vector<std::size_t>& flagged) const {
+    true_res = aud_res_;
+    flagged  = aud_flag_;
+  }
+
+  template <typename Archive>
+  void Solver::transfer(Archive& ar) {
+    ar(iter_); ar(r0_norm_); ar(sigma_); ar(threshold_);
+    // Generalized Lanczos process
+    ar(alpha_); ar(beta_prev_); ar(beta_curr_);
+    ar(w_prev_); ar(w_curr_); ar(w_next_);
+    ar(u_prev_); ar(u_curr_); ar(u_next_);
+    // Solution update (auxiliary vectors of converged shifts are empty)
+    ar(Gc_); ar(Gs_); ar(f_); ar(h_);
+    ar(conv_num_); ar(is_conv_); ar(stall_num_); ar(stall_); ar(conv_shift_);
+    ar(block_size_); ar(blk_len_); ar(W_); ar(blk_coef_); ar(blk_count_);
+    ar(lz_alpha_); ar(lz_beta_);
+    // Residual history and audit
+    ar(log_capacity_); ar(log_stride_); ar(log_count_); ar(log_res_); ar(log_iter_); ar(log_output_);
+    ar(aud_interval_); ar(aud_drift_); ar(aud_stop_); ar(aud_last_); ar(aud_res_); ar(aud_flag_);
+    // Partial reorthogonalization
+    ar(reorth_); ar(reorth_next_); ar(reorth_count_); ar(reorth_set_);
+    ar(reorth_col_); ar(reorth_ptr_); ar(reorth_row_); ar(reorth_coef_); ar(reorth_xi_);
+    ar(omega_prev_); ar(omega_curr_); ar(hist_w_); ar(hist_u_);
+  }
+
+  void Solver::checkpoint_begin(const std::string& filename, const std::vector<std::complex<double>>& x) {
+    GSMINRES_PROFILE_SCOPE("checkpoint", iter_-1);
+    update_wait();
+    checkpoint_wait();
+    // Header and the O(N) state are copied into an image; the auxiliary vectors and x are not
+    std::uint64_t header[3] = {matrix_size_, shift_size_, standard_ ? 1u : 0u};
+    std::uint32_t version   = ckpt_version;
+    StateCounter counter;
+    transfer(counter);
+    std::vector<char> image;
+    image.reserve(sizeof(ckpt_magic) + sizeof(version) + sizeof(header) + counter.bytes);
+    StateWriter writer(image);
+    writer.raw(ckpt_magic, sizeof(ckpt_magic));
+    writer(version);
+    writer.raw(header, sizeof(header));
+    transfer(writer);
+    // Stream the image, then the auxiliary vectors and x from the live buffers, to a temporary file,
+    // and replace the previous checkpoint at the end. update() waits before modifying them.
+    ckpt_pending_ = std::async(std::launch::async, [this, filename, &x, image = std::move(image)]() {
+      const std::string tmp = filename + ".tmp";
+      std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+      StreamWriter stream(ofs);
+      stream.raw(image.data(), image.size());
+      stream(p_prev2_); stream(p_prev_); stream(p_curr_);
+      stream(x);
+      stream.raw(ckpt_end, sizeof(ckpt_end));
+      ofs.close();
+      if (!ofs) {
+        std::remove(tmp.c_str());
+        return false;
+      }
+      return std::rename(tmp.c_str(), filename.c_str()) == 0;
+    });
+  }
+
+  void Solver::checkpoint_sync() {
+    if (ckpt_pending_.valid()) {
+      ckpt_pending_.wait();
+    }
+  }
+
+  bool Solver::checkpoint_wait() {
+    if (!ckpt_pending_.valid()) {
+      return true;
+    }
+    const bool ok = ckpt_pending_.get();
+    if (!ok) {
+      std::cerr << "Solver::checkpoint: [ERROR] Cannot write the checkpoint" << std::endl;
+    }
+    return ok;
+  }
+
+  bool Solver::checkpoint(const std::string& filename, const std::vector<std::complex<double>>& x) {
+    checkpoint_begin(filename, x);
+    return checkpoint_wait();
+  }
+
+  bool Solver::restore(const std::string& filename, std::vector<std::complex<double>>& x,
+                       std::vector<std::complex<double>>& w) {
+    update_wait();
+    checkpoint_wait();
+    std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+    if (!ifs) {
+      std::cerr << "Solver::restore: [ERROR] Cannot open " << filename << std::endl;
+      return false;
+    }
+    const std::uint64_t bytes = static_cast<std::uint64_t>(ifs.tellg());
+    ifs.seekg(0);
+    StateReader reader(ifs, bytes);
+    char magic[4] = {0, 0, 0, 0};
+    std::uint32_t version = 0;
+    std::uint64_t header[3] = {0, 0, 0};
+    reader.raw(magic, sizeof(magic));
+    reader(version);
+    reader.raw(header, sizeof(header));
+    if (!reader.ok() || std::memcmp(magic, ckpt_magic, sizeof(magic)) != 0 || version != ckpt_version) {
+      std::cerr << "Solver::restore: [ERROR] " << filename << " is not a checkpoint of this version" << std::endl;
+      return false;
+    }
+    if (header[0] != matrix_size_ || header[1] != shift_size_ || header[2] != (standard_ ? 1u : 0u)) {
+      std::cerr << "Solver::restore: [ERROR] Checkpoint does not match the matrix size, number of shifts or mode" << std::endl;
+      return false;
+    }
+    transfer(reader);
+    reader(p_prev2_); reader(p_prev_); reader(p_curr_);
+    reader(x);
+    char end[4] = {0, 0, 0, 0};
+    reader.raw(end, sizeof(end));
+    if (!reader.ok() || std::memcmp(end, ckpt_end, sizeof(end)) != 0 || x.size() != matrix_size_*shift_size_) {
+      std::cerr << "Solver::restore: [ERROR] " << filename << " is truncated or corrupted" << std::endl;
+      return false;
+    }
+    w.resize(matrix_size_);
+    blas::zcopy(matrix_size_, w_curr_, 0, w, 0);
+    pending_x_ = nullptr;
+    return true;
+  }
+
+  std::size_t Solver::get_iteration() const {
+    return iter_-1;
+  }
+
+  void Solver::set_history(std::size_t capacity, std::size_t stride, const std::string& output) {
+    log_capacity_ = capacity;
+    log_stride_   = std::max<std::size_t>(stride, 1);
+    log_count_    = 0;
+    log_output_   = output;
+    log_res_.assign(capacity*shift_size_, 0.0);
+    log_iter_.assign(capacity, 0);
+  }
+
+  void Solver::record_history() {
+    const std::size_t pos = log_count_ % log_capacity_;
+    for (std::size_t m=0; m<shift_size_; m++) {
+      log_res_[pos*shift_size_ + m] = h_[m]/r0_norm_;
+    }
+    log_iter_[pos] = iter_;
+    log_count_++;
+  }
+
+  Solver::HistoryView Solver::get_history() const {
+    HistoryView view;
+    view.residual   = log_res_.data();
+    view.iterations = log_iter_.data();
+    view.capacity   = log_capacity_;
+    view.count      = std::min(log_count_, log_capacity_);
+    view.first      = log_count_ > log_capacity_ ? log_count_ % log_capacity_ : 0;
+    view.shift_size = shift_size_;
+    return view;
+  }
+
+  void Solver::get_diagnostics(std::vector<ShiftDiagnostics>& diag, double reduction) const {
+    const HistoryView view = get_history();
+    diag.assign(shift_size_, ShiftDiagnostics{0, 0.0, 1.0, 0, 0});
+    for (std::size_t m=0; m<shift_size_; m++) {
+      ShiftDiagnostics& d = diag[m];
+      d.converged = is_conv_[m];
+      d.residual  = r0_norm_ > 0.0 ? h_[m]/r0_norm_ : 0.0;
+      // Records after the convergence (or stall) repeat the final value
+      const std::size_t finished = (is_conv_[m] != 0) ? is_conv_[m] : stall_[m];
+      std::size_t n = 0;
+      while (n < view.size() && (finished == 0 || view.iteration(n) <= finished)) {
+        n++;
+      }
+      if (n == 0) {
+        continue;
+      }
+      d.plateau_begin = view.iteration(0);
+      const std::size_t span = view.iteration(n-1) - view.iteration(0);
+      if (span > 0 && view(0, m) > 0.0) {
+        d.rate = std::pow(view(n-1, m)/view(0, m), 1.0/static_cast<double>(span));
+      }
+      // The norms do not increase, so the end of the longest plateau from record i moves forward with i
+      std::size_t j = 0;
+      for (std::size_t i=0; i<n; i++) {
+        j = std::max(j, i);
+        while (j+1 < n && view(j+1, m) > reduction*view(i, m)) {
+          j++;
+        }
+        if (view.iteration(j) - view.iteration(i) > d.plateau_length) {
+          d.plateau_begin  = view.iteration(i);
+          d.plateau_length = view.iteration(j) - view.iteration(i);
+        }
+      }
+    }
+  }
+
+  bool Solver::write_history(const std::string& filename, bool binary) const {
+    const HistoryView view = get_history();
+    if (binary) {
+      std::ofstream ofs(filename, std::ios::binary);
+      if (!ofs) {
+        return false;
+      }
+      const std::uint64_t header[2] = {shift_size_, view.size()};
+      ofs.write("GSMH", 4);
+      ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+      for (std::size_t k=0; k<view.size(); k++) {
+        const std::uint64_t it = view.iteration(k);
+        const double* res = view.residual + ((view.first+k)%view.capacity)*shift_size_;
+        ofs.write(reinterpret_cast<const char*>(&it), sizeof(it));
+        ofs.write(reinterpret_cast<const char*>(res), static_cast<std::streamsize>(shift_size_*sizeof(double)));
+      }
+      return static_cast<bool>(ofs);
+    }
+    std::ofstream ofs(filename);
+    if (!ofs) {
+      return false;
+    }
+    ofs << "iteration";
+    for (std::size_t m=0; m<shift_size_; m++) {
+      ofs << ",shift_" << m;
+    }
+    ofs << "\n" << std::scientific << std::setprecision(6);
+    for (std::size_t k=0; k<view.size(); k++) {
+      ofs << view.iteration(k);
+      for (std::size_t m=0; m<shift_size_; m++) {
+        ofs << "," << view(k, m);
+      }
+      ofs << "\n";
+    }
+    return static_cast<bool>(ofs);
+  }
+
+  bool Solver::write_diagnostics(const std::string& filename) const {
+    std::vector<ShiftDiagnostics> diag;
+    get_diagnostics(diag);
+    std::ofstream ofs(filename);
+    if (!ofs) {
+      return false;
+    }
+    ofs << "shift,sigma_re,sigma_im,converged,residual,rate,plateau_begin,plateau_length\n";
+    for (std::size_t m=0; m<shift_size_; m++) {
+      ofs << m << "," << std::scientific << std::setprecision(6)
+          << sigma_[m].real() << "," << sigma_[m].imag() << "," << diag[m].converged << ","
+          << diag[m].residual << "," << std::fixed << std::setprecision(6) << diag[m].rate << ","
+          << diag[m].plateau_begin << "," << diag[m].plateau_length << "\n";
+    }
+    return static_cast<bool>(ofs);
+  }
+
+  void Solver::get_tridiagonal(std::vector<double>& alpha, std::vector<double>& beta) const {
+    alpha = lz_alpha_;
+    beta.assign(lz_beta_.begin()+1, lz_beta_.end());
+  }
+
+  void Solver::get_ritz_values(std::vector<double>& ritz) const {
+    const std::size_t k = lz_alpha_.size();
+    ritz = lz_alpha_;
+    if (k == 0) {
+      return;
+    }
+    std::vector<double> e(lz_beta_.begin()+1, lz_beta_.begin()+k);
+    e.push_back(0.0);
+    lapack::dsterf(static_cast<int>(k), ritz, e);
+  }
+
+  void Solver::predict_iterations(std::vector<std::size_t>& itr) const {
+    itr.assign(shift_size_, 0);
+    std::vector<double> ritz;
+    get_ritz_values(ritz);
+    if (ritz.size() < 2 || !(ritz.back() > ritz.front())) {
+      return;
+    }
+    // The residual polynomial of the shift is small on [a, b] and one at -sigma.
+    // Its asymptotic convergence factor is 1/|zeta| with the Joukowski map zeta of -sigma.
+    const double a = ritz.front(), b = ritz.back();
+    const std::size_t done = lz_alpha_.size();
+    for (std::size_t m=0; m<shift_size_; m++) {
+      if (is_conv_[m] != 0 || stall_[m] != 0) {
+        itr[m] = is_conv_[m];
+        continue;
+      }
+      const std::complex<double> t = (-2.0*sigma_[m] - (a+b))/(b-a);
+      std::complex<double> zeta = t + std::sqrt(t*t - 1.0);
+      if (std::abs(zeta) < 1.0) {
+        zeta = t - std::sqrt(t*t - 1.0);
+      }
+      const double log_rate = -std::log(std::abs(zeta));
+      const double target   = threshold_*r0_norm_/h_[m];
+      if (!(log_rate < -1.0e-12)) {
+        continue; // -sigma lies (numerically) inside the interval: no prediction
+      }
+      const double more = target < 1.0 ? std::ceil(std::log(target)/log_rate) : 0.0;
+      itr[m] = done + static_cast<std::size_t>(more);
+    }
+  }
+
+  void Solver::set_reorthogonalization(bool enable) {
+    reorth_ = enable;
+    if (!enable) {
+      hist_w_.clear();
+      hist_w_.shrink_to_fit();
+      hist_u_.clear();
+      hist_u_.shrink_to_fit();
+    }
+  }
+
+  std::size_t Solver::get_reorthogonalization_count() const {
+    return reorth_count_;
+  }
+
+  void Solver::get_stalled(std::vector<std::size_t>& stalled) const {
+    stalled = stall_;
+  }
+
+  void Solver::set_convergence_callback(ConvergenceCallback callback) {
+    on_converged_ = std::move(callback);
+  }
+
+  void Solver::set_reduction(Reduction reduction) {
+    reduce_ = std::move(reduction);
+  }
+
+  double Solver::allsum(double value) const {
+    if (reduce_) {
+      reduce_(&value, 1);
+    }
+    return value;
+  }
 }
@@ -0,0 +1,408 @@
+/**
+ * \file gsminres_sstep_solver.cpp
+ * \brief Implementation of the GSMINRES++ s-step solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_sstep_solver.hpp"
+#include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+
+namespace gsminres {
+
+  SStepSolver::SStepSolver(std::size_t matrix_size, std::size_t shift_size, std::size_t block_size)
+    : matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      s_(block_size),
+      step_(0),
+      classical_(true),
+      classical_end_(block_size),
+      block_(block_size),
+      threshold_(0.0),
+      drift_tol_(0.0),
+      alpha_(),
+      beta_(1, 0.0),
+      Y_( matrix_size*(2*block_size+1), {0.0, 0.0}),
+      BY_(matrix_size*(2*block_size+1), {0.0, 0.0}),
+      Wn_(matrix_size*block_size, {0.0, 0.0}),
+      Un_(matrix_size*block_size, {0.0, 0.0}),
+      G_((2*block_size+1)*(2*block_size+1), {0.0, 0.0}),
+      theta_(block_size, 0.0),
+      gamma_(1.0),
+      refresh_at_(0),
+      ready_(0),
+      first_ready_(0),
+      reduce_(),
+      b_product_(),
+      solver_(matrix_size, shift_size, true) {
+    if (block_size == 0) {
+      std::cerr << "SStepSolver: [ERROR] Block size must be at least 1" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  void SStepSolver::initialize(std::vector<std::complex<double>>& x,
+                               const std::vector<std::complex<double>>& b,
+                               std::vector<std::complex<double>>& w,
+                               const std::vector<std::complex<double>>& sigma,
+                               const double threshold) {
+    double r0 = (blas::zdotc(matrix_size_, b, 0, w, 0)).real();
+    if (reduce_) {
+      reduce_(&r0, 1);
+    }
+    r0 = std::sqrt(r0);
+    // solver_ normalizes w; the first column of BY_ is the matching u = b / ||b||
+    solver_.initialize(x, b, w, sigma, threshold);
+    blas::zcopy(matrix_size_, w, 0, Y_, 0);
+    blas::zcopy(matrix_size_, b, 0, BY_, 0);
+    blas::zdscal(matrix_size_, 1.0/r0, BY_, 0);
+    alpha_.clear();
+    beta_.assign(1, 0.0);
+    step_          = 0;
+    classical_     = true;
+    classical_end_ = s_;
+    block_         = s_;
+    threshold_     = threshold;
+    drift_tol_     = std::max(1.0e6*std::numeric_limits<double>::epsilon(), threshold);
+    refresh_at_    = 0;
+    ready_         = 0;
+  }
+
+  void SStepSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    const std::size_t N = matrix_size_;
+    if (classical_) {
+      // Classical step: the current Lanczos vector is column step_ of Y_
+      const std::size_t j = step_;
+      double alpha = (blas::zdotc(N, Y_, j*N, u, 0)).real();
+      if (reduce_) {
+        reduce_(&alpha, 1);
+      }
+      alpha_.push_back(alpha);
+      blas::zaxpy(N, -alpha, BY_, j*N, u, 0);
+      if (j > 0) {
+        blas::zaxpy(N, -beta_.back(), BY_, (j-1)*N, u, 0);
+      }
+      return;
+    }
+    // Newton basis: u = (A - theta_j B) v_j
+    blas::zaxpy(N, -theta_[step_], BY_, (s_+step_)*N, u, 0);
+  }
+
+  void SStepSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                 std::vector<std::complex<double>>& u) {
+    const std::size_t N = matrix_size_;
+    if (classical_) {
+      const std::size_t j = step_;
+      double beta = (blas::zdotc(N, u, 0, w, 0)).real();
+      if (reduce_) {
+        reduce_(&beta, 1);
+      }
+      beta = std::sqrt(beta);
+      beta_.push_back(beta);
+      blas::zdscal(N, 1.0/beta, w);
+      blas::zcopy(N, w, 0, Y_,  (j+1)*N);
+      blas::zcopy(N, u, 0, BY_, (j+1)*N);
+      blas::zdscal(N, 1.0/beta, BY_, (j+1)*N);
+      blas::zcopy(N, w, 0, Wn_, 0);
+      ready_       = 1;
+      first_ready_ = alpha_.size()-1;
+      step_++;
+      if (step_ == classical_end_) {
+        if (classical_end_ > s_) {
+          // Restart with classical steps: drop the oldest vector
+          std::copy(Y_.begin()+N,  Y_.begin()+(s_+2)*N,  Y_.begin());
+          std::copy(BY_.begin()+N, BY_.begin()+(s_+2)*N, BY_.begin());
+        }
+        // Y_ now holds the last s Lanczos vectors followed by v_0
+        compute_shifts();
+        classical_ = false;
+        step_      = 0;
+      }
+      return;
+    }
+    const std::size_t col = s_+step_+1;
+    blas::zdscal(N, 1.0/gamma_, w);
+    blas::zcopy(N, w, 0, Y_,  col*N);
+    blas::zcopy(N, u, 0, BY_, col*N);
+    blas::zdscal(N, 1.0/gamma_, BY_, col*N);
+    step_++;
+    if (step_ == block_) {
+      step_ = 0;
+      finish_block(w);
+    }
+  }
+
+  void SStepSolver::finish_block(std::vector<std::complex<double>>& w) {
+    const std::size_t N = matrix_size_;
+    const std::size_t s = block_;
+    const std::size_t o = s_-block_; // first column of the window: the last s Lanczos vectors, v_0, ..., v_s
+    const std::size_t d = 2*s+1;
+    const std::size_t k = alpha_.size()+1; // Lanczos index of v_0
+
+    // The only reduction of the block: the full B-Gram matrix Y^H B Y. The previous Lanczos vectors
+    // are included, since they are B-orthonormal only up to the loss of orthogonality of the process.
+    blas::zgemm('C', 'N', d, d, N, {1.0, 0.0}, Y_, o*N, N, BY_, o*N, N, {0.0, 0.0}, G_, 0, d);
+    if (reduce_) {
+      reduce_(reinterpret_cast<double*>(G_.data()), 2*d*d);
+    }
+
+    // Real symmetric part of the Gram matrix (the coordinate vectors below are real)
+    std::vector<double> G(d*d, 0.0);
+    for (std::size_t b=0; b<d; b++) {
+      for (std::size_t a=0; a<d; a++) {
+        G[a+b*d] = 0.5*(G_[a+b*d].real() + G_[b+a*d].real());
+      }
+    }
+
+    // Loss of B-orthonormality of v_0 against the previous Lanczos vectors. It limits the attainable
+    // residual to about its size, and is tolerated up to the convergence threshold.
+    const double drift_tol = std::max(1.0e6*std::numeric_limits<double>::epsilon(), threshold_);
+    double drift = 0.0;
+    for (std::size_t a=0; a<=s; a++) {
+      drift = std::max(drift, std::abs(G[a+s*d] - (a == s ? 1.0 : 0.0)));
+    }
+    if (s == 1 && drift > drift_tol_) {
+      // A restart keeps the drift between its two starting vectors: tolerate it from now on
+      drift_tol_ = std::min(2.0*drift, 1.0e3*drift_tol);
+    }
+
+    // B^{-1}A in the coordinates of the window: three-term recurrence for the previous Lanczos vectors
+    // w_{k-i} (column s-i), Newton recurrence for v_j (column s+j)
+    std::vector<double> K(d*d, 0.0);
+    for (std::size_t i=1; i<s; i++) {
+      const std::size_t c = s-i;
+      K[(c-1)+c*d] = beta_[k-i-1];
+      K[ c   +c*d] = alpha_[k-i-1];
+      K[(c+1)+c*d] = beta_[k-i];
+    }
+    for (std::size_t j=0; j<s; j++) {
+      K[(s+j+1)+(s+j)*d] = gamma_;
+      K[(s+j)  +(s+j)*d] = theta_[j];
+    }
+
+    // Lanczos process on the coordinate vectors
+    std::vector<double> q_prev(d, 0.0), q(d, 0.0), z(d, 0.0), Gz(d, 0.0);
+    std::vector<std::complex<double>> Q(d*s, {0.0, 0.0});
+    q_prev[s-1] = 1.0;
+    q[s]        = 1.0;
+    double beta_prev = beta_[k-1];
+    std::size_t done = 0;
+    for (std::size_t j=0; j<s; j++) {
+      for (std::size_t a=0; a<d; a++) {
+        double sum = 0.0;
+        for (std::size_t b=0; b<d; b++) {
+          sum += K[a+b*d]*q[b];
+        }
+        z[a] = sum;
+      }
+      double alpha = 0.0;
+      for (std::size_t a=0; a<d; a++) {
+        double sum = 0.0;
+        for (std::size_t b=0; b<d; b++) {
+          sum += G[a+b*d]*z[b];
+        }
+        alpha += q[a]*sum;
+      }
+      for (std::size_t a=0; a<d; a++) {
+        z[a] -= alpha*q[a] + beta_prev*q_prev[a];
+      }
+      double beta2 = 0.0, znrm2 = 0.0;
+      for (std::size_t a=0; a<d; a++) {
+        double sum = 0.0;
+        for (std::size_t b=0; b<d; b++) {
+          sum += G[a+b*d]*z[b];
+        }
+        Gz[a]  = sum;
+        beta2 += z[a]*sum;
+      }
+      for (std::size_t a=0; a<d; a++) {
+        znrm2 += std::abs(z[a]*Gz[a]);
+      }
+      // The basis is numerically rank deficient when the B-norm of the new vector
+      // is lost in the cancellation of the quadratic form
+      if (!(beta2 > 1.0e3*std::numeric_limits<double>::epsilon()*static_cast<double>(d)*znrm2)) {
+        break;
+      }
+      const double beta = std::sqrt(beta2);
+      // The errors of the three-term relations of the previous vectors are amplified within the block:
+      // stop before the new vector drifts from B-orthogonality to the window and the vectors recovered so far.
+      // The margin over the drift tolerance avoids discarding most of the basis of large blocks, and the
+      // drift already present in the window is not counted. A block of size one is never stopped, since
+      // a classical step would give the same vector.
+      double loss = 0.0;
+      for (std::size_t a=0; a<=s; a++) {
+        loss = std::max(loss, std::abs(Gz[a])/beta);
+      }
+      for (std::size_t i=0; i<j; i++) {
+        double sum = 0.0;
+        for (std::size_t a=0; a<d; a++) {
+          sum += Q[a+i*d].real()*Gz[a];
+        }
+        loss = std::max(loss, std::abs(sum)/beta);
+      }
+      if (s > 1 && loss > std::max(1.0e3*drift_tol, 10.0*drift)) {
+        break;
+      }
+      alpha_.push_back(alpha);
+      beta_.push_back(beta);
+      for (std::size_t a=0; a<d; a++) {
+        q_prev[a] = q[a];
+        q[a]      = z[a]/beta;
+        Q[a+j*d]  = q[a];
+      }
+      beta_prev = beta;
+      done++;
+    }
+
+    // Lanczos vectors w_{k+1}, ..., w_{k+done} and their B-images
+    if (done > 0) {
+      blas::zgemm('N', 'N', N, done, d, {1.0, 0.0}, Y_,  o*N, N, Q, 0, d, {0.0, 0.0}, Wn_, 0, N);
+      blas::zgemm('N', 'N', N, done, d, {1.0, 0.0}, BY_, o*N, N, Q, 0, d, {0.0, 0.0}, Un_, 0, N);
+    }
+    ready_       = done;
+    first_ready_ = k-1;
+
+    const bool restart = done < s || drift > drift_tol_;
+    if (restart) {
+      // Breakdown or drift of v_0: keep the recovered vectors and restart from w_{k+done-1} and w_{k+done}
+      // with a block of size one, which uses no three-term relation of the previous vectors.
+      if (done == 1) {
+        blas::zcopy(N, Y_,  s_*N, Y_,  (s_-1)*N);
+        blas::zcopy(N, BY_, s_*N, BY_, (s_-1)*N);
+      } else if (done > 1) {
+        blas::zcopy(N, Wn_, (done-2)*N, Y_,  (s_-1)*N);
+        blas::zcopy(N, Un_, (done-2)*N, BY_, (s_-1)*N);
+      }
+      if (done > 0) {
+        blas::zcopy(N, Wn_, (done-1)*N, Y_,  s_*N);
+        blas::zcopy(N, Un_, (done-1)*N, BY_, s_*N);
+      }
+      block_ = 1;
+    } else {
+      // Next block: previous Lanczos vectors w_{k+s-s_}, ..., w_{k+s-1}, and v_0 = w_{k+s}.
+      // After a restart, the block size is doubled up to s as valid previous vectors accumulate.
+      std::copy(Y_.begin()+s*N,  Y_.begin()+(s_+1)*N,  Y_.begin());
+      std::copy(BY_.begin()+s*N, BY_.begin()+(s_+1)*N, BY_.begin());
+      blas::zcopy(s*N, Wn_, 0, Y_,  (s_-s+1)*N);
+      blas::zcopy(s*N, Un_, 0, BY_, (s_-s+1)*N);
+      block_ = std::min(2*s, s_);
+    }
+    blas::zcopy(N, Y_, s_*N, w, 0);
+    if (b_product_) {
+      // Exact B-image of v_0, which removes the mismatch accumulated by the recurrences
+      b_product_(w, Un_);
+      blas::zcopy(N, Un_, 0, BY_, s_*N);
+    }
+    if (restart && !b_product_) {
+      // Without the multiplication by B, the B-images of the window are those of the recurrences:
+      // s classical steps from w_{k+done-1} and w_{k+done} take new images from the inner solves.
+      // The Newton shifts are refreshed at the end.
+      blas::zcopy(N, Y_,  (s_-1)*N, Y_,  0);
+      blas::zcopy(N, BY_, (s_-1)*N, BY_, 0);
+      blas::zcopy(N, Y_,  s_*N,     Y_,  N);
+      blas::zcopy(N, BY_, s_*N,     BY_, N);
+      classical_     = true;
+      classical_end_ = s_+1;
+      step_          = 1;
+      block_         = s_;
+      return;
+    }
+    if (restart && done == 0 && s == 1) {
+      // The Newton basis of size one is rank deficient: one classical step from w_{k-1} and w_k,
+      // after which the last two Lanczos vectors allow a block of size two
+      classical_     = true;
+      classical_end_ = s_+1;
+      step_          = s_;
+      block_         = std::min<std::size_t>(2, s_);
+      return;
+    }
+    if (alpha_.size() >= refresh_at_) {
+      compute_shifts();
+    }
+  }
+
+  void SStepSolver::compute_shifts() {
+    // Ritz values of the whole tridiagonal matrix recorded so far
+    const std::size_t s = s_;
+    const std::size_t n = alpha_.size();
+    std::vector<double> d(alpha_.begin(), alpha_.end());
+    std::vector<double> e(n, 0.0);
+    for (std::size_t i=0; i+1<n; i++) {
+      e[i] = beta_[i+1];
+    }
+    lapack::dsterf(static_cast<int>(n), d, e);
+    // Leja ordering from the center of the interval: each shift maximizes the product of the distances
+    // to the previous ones. Starting at an extreme Ritz value amplifies the rounding errors of the
+    // B-images (the first shift multiplies the component of v_0 in the recovered vectors).
+    std::vector<bool> used(n, false);
+    for (std::size_t j=0; j<s; j++) {
+      std::size_t best = 0;
+      double best_val = -1.0e300;
+      for (std::size_t i=0; i<n; i++) {
+        if (used[i]) {
+          continue;
+        }
+        double val = 0.0;
+        if (j == 0) {
+          val = -std::abs(d[i]-0.5*(d[0]+d[n-1]));
+        } else {
+          for (std::size_t l=0; l<j; l++) {
+            val += std::log(std::abs(d[i]-theta_[l]) + 1.0e-300);
+          }
+        }
+        if (val > best_val) {
+          best_val = val;
+          best     = i;
+        }
+      }
+      used[best] = true;
+      theta_[j]  = d[best];
+    }
+    // Capacity of the interval of the Ritz values keeps the basis vectors of moderate size
+    gamma_ = (d[n-1]-d[0])/4.0;
+    if (!(gamma_ > 0.0)) {
+      gamma_ = std::abs(d[0]) > 0.0 ? std::abs(d[0]) : 1.0;
+    }
+    // The extreme Ritz values converge quickly: refresh when the number of iterations has doubled
+    refresh_at_ = 2*n;
+  }
+
+  bool SStepSolver::update(std::vector<std::complex<double>>& x) {
+    bool converged = false;
+    for (std::size_t i=0; i<ready_; i++) {
+      const std::size_t it = first_ready_+i;
+      solver_.glanczos_set(alpha_[it], beta_[it+1], Wn_, i*matrix_size_);
+      if (solver_.update(x)) {
+        converged = true;
+        break;
+      }
+    }
+    ready_ = 0;
+    return converged;
+  }
+
+  void SStepSolver::finalize(std::vector<std::size_t>& conv_itr,
+                             std::vector<double>&      conv_res) {
+    solver_.finalize(conv_itr, conv_res);
+  }
+
+  void SStepSolver::get_residual(std::vector<double>& res) const {
+    solver_.get_residual(res);
+  }
+
+  void SStepSolver::set_b_product(Product product) {
+    b_product_ = std::move(product);
+  }
+
+  void SStepSolver::set_reduction(Solver::Reduction reduction) {
+    reduce_ = reduction;
+    solver_.set_reduction(std::move(reduction));
+  }
+
+}  // namespace gsminres
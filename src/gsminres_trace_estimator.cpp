@@ -0,0 +1,244 @@
+/**
+ * \file gsminres_trace_estimator.cpp
+ * \brief Implementation of the GSMINRES++ stochastic trace and diagonal estimator.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_trace_estimator.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+namespace gsminres {
+
+  TraceEstimator::TraceEstimator(std::size_t matrix_size,
+                                 const std::vector<std::complex<double>>& sigma,
+                                 bool diagonal,
+                                 std::uint64_t seed)
+    : matrix_size_(matrix_size),
+      shift_size_(sigma.size()),
+      sigma_(sigma),
+      diagonal_(diagonal),
+      tolerance_(1e-2),
+      min_probes_(10),
+      max_probes_(1000),
+      gen_(seed),
+      color_(),
+      color_size_(0),
+      probe_count_(0),
+      z_(matrix_size, {0.0, 0.0}),
+      count_(sigma.size(), 0),
+      mean_(sigma.size(), {0.0, 0.0}),
+      m2_(sigma.size(), 0.0),
+      stopped_(sigma.size(), false),
+      diag_(diagonal ? matrix_size*sigma.size() : 0, {0.0, 0.0}),
+      active_(),
+      sample_(),
+      added_(),
+      x_(),
+      zx_(),
+      solver_(),
+      projected_() {}
+
+  void TraceEstimator::set_stopping(double tolerance, std::size_t min_probes, std::size_t max_probes) {
+    tolerance_  = tolerance;
+    min_probes_ = min_probes < 2 ? 2 : min_probes;
+    max_probes_ = max_probes;
+  }
+
+  void TraceEstimator::set_coloring(const std::vector<std::size_t>& color, std::size_t color_size) {
+    if (probe_count_ != 0 || color.size() != matrix_size_) {
+      std::cerr << "TraceEstimator::set_coloring: [ERROR] Must be called before the first probe with one colour per node" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    color_      = color;
+    color_size_ = color_size;
+  }
+
+  bool TraceEstimator::next_probe(std::vector<std::complex<double>>& z) {
+    if (!color_.empty()) {
+      // Probing: one probe per colour
+      if (probe_count_ == color_size_) {
+        return false;
+      }
+      for (std::size_t i=0; i<matrix_size_; i++) {
+        z_[i] = (color_[i] == probe_count_) ? 1.0 : 0.0;
+      }
+    } else {
+      bool remaining = false;
+      for (std::size_t m=0; m<shift_size_; m++) {
+        remaining = remaining || !stopped_[m];
+      }
+      if (!remaining || probe_count_ == max_probes_) {
+        return false;
+      }
+      // 64 Rademacher entries per random number
+      for (std::size_t i=0; i<matrix_size_; i+=64) {
+        const std::uint64_t bits = gen_();
+        for (std::size_t j=i; j<i+64 && j<matrix_size_; j++) {
+          z_[j] = ((bits >> (j-i)) & 1) ? 1.0 : -1.0;
+        }
+      }
+    }
+    probe_count_++;
+    z = z_;
+    return true;
+  }
+
+  void TraceEstimator::initialize(const std::vector<std::complex<double>>& b,
+                                  std::vector<std::complex<double>>& w,
+                                  const double threshold) {
+    // Shifts which have stopped are dropped from the solver
+    active_.clear();
+    for (std::size_t m=0; m<shift_size_; m++) {
+      if (!stopped_[m]) {
+        active_.push_back(m);
+      }
+    }
+    std::vector<std::complex<double>> sigma(active_.size());
+    for (std::size_t k=0; k<active_.size(); k++) {
+      sigma[k] = sigma_[active_[k]];
+    }
+    sample_.assign(active_.size(), {0.0, 0.0});
+    added_.assign(active_.size(), false);
+    blas::zcopy(matrix_size_, z_, 0, w, 0);
+    if (!diagonal_) {
+      // Trace only: the projection z^H x^{(m)} is all that is needed
+      zx_.assign(active_.size(), {0.0, 0.0});
+      projected_.reset(new ProjectedSolver(matrix_size_, active_.size(), 1));
+      projected_->initialize(zx_, z_, b, w, sigma, threshold);
+      return;
+    }
+    x_.assign(matrix_size_*active_.size(), {0.0, 0.0});
+    // Solver is used once per right-hand side
+    solver_.reset(new Solver(matrix_size_, active_.size()));
+    solver_->set_convergence_callback([this](std::size_t shift, const std::complex<double>* xm, std::size_t) {
+      accumulate(shift, xm);
+    });
+    solver_->initialize(x_, b, w, sigma, threshold);
+  }
+
+  void TraceEstimator::glanczos_pre(std::vector<std::complex<double>>& u) {
+    if (projected_) {
+      projected_->glanczos_pre(u);
+      return;
+    }
+    solver_->glanczos_pre(u);
+  }
+
+  void TraceEstimator::glanczos_pst(std::vector<std::complex<double>>& w,
+                                    std::vector<std::complex<double>>& u) {
+    if (projected_) {
+      projected_->glanczos_pst(w, u);
+      return;
+    }
+    solver_->glanczos_pst(w, u);
+  }
+
+  bool TraceEstimator::update() {
+    if (projected_) {
+      // The projections of the converged shifts are no longer updated
+      if (projected_->update(zx_)) {
+        sample_ = zx_;
+        commit();
+        return true;
+      }
+      return false;
+    }
+    if (solver_->update(x_)) {
+      commit();
+      return true;
+    }
+    return false;
+  }
+
+  void TraceEstimator::flush() {
+    if (projected_) {
+      sample_ = zx_;
+      commit();
+      return;
+    }
+    for (std::size_t k=0; k<active_.size(); k++) {
+      if (!added_[k]) {
+        accumulate(k, x_.data()+k*matrix_size_);
+      }
+    }
+    commit();
+  }
+
+  void TraceEstimator::accumulate(std::size_t shift, const std::complex<double>* xm) {
+    const std::size_t N = matrix_size_;
+    const std::size_t m = active_[shift];
+    std::complex<double> s = {0.0, 0.0};
+    // The probe vectors are real
+    for (std::size_t i=0; i<N; i++) {
+      s += z_[i].real()*xm[i];
+    }
+    sample_[shift] = s;
+    if (diagonal_) {
+      for (std::size_t i=0; i<N; i++) {
+        diag_[m*N+i] += z_[i].real()*xm[i];
+      }
+    }
+    added_[shift] = true;
+  }
+
+  void TraceEstimator::commit() {
+    for (std::size_t k=0; k<active_.size(); k++) {
+      const std::size_t m = active_[k];
+      count_[m]++;
+      const std::complex<double> delta = sample_[k] - mean_[m];
+      mean_[m] += delta/static_cast<double>(count_[m]);
+      m2_[m]   += std::real(std::conj(delta)*(sample_[k] - mean_[m]));
+      if (color_.empty() && count_[m] >= min_probes_) {
+        const double error = std::sqrt(m2_[m]/static_cast<double>((count_[m]-1)*count_[m]));
+        stopped_[m] = error <= tolerance_*std::abs(mean_[m]);
+      }
+    }
+    active_.clear();
+    // Release the memory of the probe
+    projected_.reset();
+    solver_.reset();
+    std::vector<std::complex<double>>().swap(x_);
+  }
+
+  void TraceEstimator::get_trace(std::vector<std::complex<double>>& trace, std::vector<double>& error) const {
+    trace.assign(shift_size_, {0.0, 0.0});
+    error.assign(shift_size_, 0.0);
+    for (std::size_t m=0; m<shift_size_; m++) {
+      const double n = static_cast<double>(count_[m]);
+      if (!color_.empty()) {
+        // Probing: the trace is the sum over the colours
+        trace[m] = mean_[m]*n;
+      } else {
+        trace[m] = mean_[m];
+        if (count_[m] > 1) {
+          error[m] = std::sqrt(m2_[m]/((n-1.0)*n));
+        }
+      }
+    }
+  }
+
+  void TraceEstimator::get_diagonal(std::vector<std::complex<double>>& diag) const {
+    if (!diagonal_) {
+      std::cerr << "TraceEstimator::get_diagonal: [ERROR] Diagonal estimation is not enabled" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    diag = diag_;
+    if (color_.empty()) {
+      // Rademacher: |z_i|^2 = 1 for every probe
+      for (std::size_t m=0; m<shift_size_; m++) {
+        if (count_[m] > 0) {
+          blas::zdscal(matrix_size_, 1.0/static_cast<double>(count_[m]), diag, m*matrix_size_);
+        }
+      }
+    }
+  }
+
+  void TraceEstimator::get_status(std::vector<std::size_t>& probes, std::vector<bool>& stopped) const {
+    probes  = count_;
+    stopped = stopped_;
+  }
+
+}  // namespace gsminres
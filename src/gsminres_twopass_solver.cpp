@@ -0,0 +1,181 @@
+/**
+ * \file gsminres_twopass_solver.cpp
+ * \brief Implementation of the GSMINRES++ two-pass solver class.
+ * \author Shuntaro Hidaka
+ */
+
+#include "gsminres_twopass_solver.hpp"
+#include "gsminres_blas.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace gsminres {
+
+  TwoPassSolver::TwoPassSolver(std::size_t matrix_size, std::size_t shift_size)
+    : iter_(1),
+      matrix_size_(matrix_size),
+      shift_size_(shift_size),
+      r0_norm_(0.0),
+      sigma_(shift_size, {0.0, 0.0}),
+      second_pass_(false),
+      alpha_(),
+      beta_(1, 0.0),
+      w_curr_(matrix_size, {0.0, 0.0}),
+      w_next_(matrix_size, {0.0, 0.0}),
+      u_prev_(matrix_size, {0.0, 0.0}),
+      u_curr_(matrix_size, {0.0, 0.0}),
+      u_next_(matrix_size, {0.0, 0.0}),
+      w_init_(matrix_size, {0.0, 0.0}),
+      u_init_(matrix_size, {0.0, 0.0}),
+      T_prev2_(1, {0.0, 0.0}),
+      T_prev_( 1, {0.0, 0.0}),
+      T_curr_( 1, {0.0, 0.0}),
+      T_next_( 1, {0.0, 0.0}),
+      Gc_(shift_size, std::array<double, 3>{0.0, 0.0, 0.0}),
+      Gs_(shift_size, std::array<std::complex<double>, 3>{{{0.0,0.0}, {0.0,0.0}, {0.0,0.0}}}),
+      R_(shift_size),
+      y_(shift_size),
+      f_(shift_size, {1.0, 0.0}),
+      h_(shift_size, 1.0),
+      conv_num_(0),
+      is_conv_(shift_size, 0),
+      max_iter_(0),
+      threshold_(1e-12) {
+  }
+
+  void TwoPassSolver::initialize(const std::vector<std::complex<double>>& b,
+                                 std::vector<std::complex<double>>& w,
+                                 const std::vector<std::complex<double>>& sigma,
+                                 const double threshold) {
+    r0_norm_ = std::sqrt((blas::zdotc(matrix_size_, b, 0, w, 0)).real());
+    blas::zcopy(matrix_size_, w, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, b, 0, u_curr_, 0);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, w_curr_);
+    blas::zdscal(matrix_size_, 1.0/r0_norm_, u_curr_);
+    blas::zcopy(matrix_size_, w_curr_, 0, w, 0);
+    blas::zcopy(matrix_size_, w_curr_, 0, w_init_, 0);
+    blas::zcopy(matrix_size_, u_curr_, 0, u_init_, 0);
+    blas::dscal(shift_size_, r0_norm_, h_);
+    blas::zcopy(shift_size_, sigma, 0, sigma_, 0);
+    threshold_ = threshold;
+  }
+
+  void TwoPassSolver::glanczos_pre(std::vector<std::complex<double>>& u) {
+    if (!second_pass_) {
+      alpha_.push_back((blas::zdotc(matrix_size_, w_curr_, 0, u, 0)).real());
+    }
+    blas::zaxpy(matrix_size_, -alpha_[iter_-1], u_curr_, 0, u, 0);
+    blas::zaxpy(matrix_size_, -beta_[iter_-1],  u_prev_, 0, u, 0);
+  }
+
+  void TwoPassSolver::glanczos_pst(std::vector<std::complex<double>>& w,
+                                   std::vector<std::complex<double>>& u) {
+    if (!second_pass_) {
+      beta_.push_back(std::sqrt((blas::zdotc(matrix_size_, u, 0, w, 0)).real()));
+    }
+    blas::zdscal(matrix_size_, 1.0/beta_[iter_], w);
+    blas::zdscal(matrix_size_, 1.0/beta_[iter_], u);
+    blas::zcopy(matrix_size_, w, 0, w_next_, 0);
+    blas::zcopy(matrix_size_, u, 0, u_next_, 0);
+  }
+
+  bool TwoPassSolver::update() {
+    for (std::size_t m=0; m<shift_size_; m++) {
+      if (is_conv_[m] != 0) {
+        continue;
+      }
+      T_prev2_[0] = 0.0;
+      T_prev_[0]  = beta_[iter_-1];
+      T_curr_[0]  = alpha_[iter_-1] + sigma_[m];
+      T_next_[0]  = beta_[iter_];
+      if (iter_ >= 3) {
+        blas::zrot(1, T_prev2_, 0, T_prev_, 0, Gc_[m][0], Gs_[m][0]);
+      }
+      if (iter_ >= 2) {
+        blas::zrot(1, T_prev_,  0, T_curr_, 0, Gc_[m][1], Gs_[m][1]);
+      }
+      blas::zrotg(T_curr_[0], T_next_[0], Gc_[m][2], Gs_[m][2]);
+      // Column iter_ of the triangular factor and the corresponding right-hand side entry
+      R_[m].push_back({T_prev2_[0], T_prev_[0], T_curr_[0]});
+      y_[m].push_back(r0_norm_*Gc_[m][2]*f_[m]);
+      f_[m] = -std::conj(Gs_[m][2]) * f_[m];
+      h_[m] = std::abs(-std::conj(Gs_[m][2])) * h_[m];
+      if (h_[m]/r0_norm_ < threshold_) {
+        conv_num_++;
+        is_conv_[m] = iter_;
+        continue;
+      }
+      Gc_[m][0] = Gc_[m][1]; Gc_[m][1] = Gc_[m][2];
+      Gs_[m][0] = Gs_[m][1]; Gs_[m][1] = Gs_[m][2];
+    }
+    blas::zcopy(matrix_size_, w_next_, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, u_curr_, 0, u_prev_, 0);
+    blas::zcopy(matrix_size_, u_next_, 0, u_curr_, 0);
+    iter_++;
+    if (conv_num_ >= shift_size_) {
+      return true;
+    }
+    return false;
+  }
+
+  void TwoPassSolver::restart(std::vector<std::complex<double>>& x,
+                              std::vector<std::complex<double>>& w) {
+    // Back substitution R y = z with the upper triangular factor of bandwidth 3.
+    // This replaces the recurrence of the auxiliary vectors p in Solver::update().
+    max_iter_ = 0;
+    for (std::size_t m=0; m<shift_size_; m++) {
+      std::vector<std::complex<double>>& y = y_[m];
+      const std::vector<std::array<std::complex<double>, 3>>& R = R_[m];
+      const std::size_t n = y.size();
+      for (std::size_t j=n; j-- > 0; ) {
+        if (j+1 < n) {
+          y[j] -= R[j+1][1] * y[j+1];
+        }
+        if (j+2 < n) {
+          y[j] -= R[j+2][0] * y[j+2];
+        }
+        y[j] /= R[j][2];
+      }
+      if (n > max_iter_) {
+        max_iter_ = n;
+      }
+      R_[m].clear();
+      R_[m].shrink_to_fit();
+    }
+    blas::zdscal(shift_size_*matrix_size_, 0.0, x);
+    blas::zcopy(matrix_size_, w_init_, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, u_init_, 0, u_curr_, 0);
+    blas::zdscal(matrix_size_, 0.0, u_prev_);
+    blas::zcopy(matrix_size_, w_init_, 0, w, 0);
+    iter_ = 1;
+    second_pass_ = true;
+  }
+
+  bool TwoPassSolver::accumulate(std::vector<std::complex<double>>& x) {
+    for (std::size_t m=0; m<shift_size_; m++) {
+      if (iter_ > y_[m].size()) {
+        continue;
+      }
+      blas::zaxpy(matrix_size_, y_[m][iter_-1], w_curr_, 0, x, m*matrix_size_);
+    }
+    blas::zcopy(matrix_size_, w_next_, 0, w_curr_, 0);
+    blas::zcopy(matrix_size_, u_curr_, 0, u_prev_, 0);
+    blas::zcopy(matrix_size_, u_next_, 0, u_curr_, 0);
+    iter_++;
+    if (iter_ > max_iter_) {
+      return true;
+    }
+    return false;
+  }
+
+  void TwoPassSolver::finalize(std::vector<std::size_t>& conv_itr,
+                               std::vector<double>&      conv_res) {
+    conv_itr = is_conv_;
+    conv_res = h_;
+  }
+
+  void TwoPassSolver::get_residual(std::vector<double>& res) const {
+    blas::dcopy(shift_size_, h_, 0, res, 0);
+  }
+
+}  // namespace gsminres
@@ -6,12 +6,16 @@
 
 #include "gsminres_util.hpp"
 #include "gsminres_blas.hpp"
+#include "gsminres_lapack.hpp"
+#include "gsminres_profiler.hpp"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <complex>
 #include <vector>
 #include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 namespace gsminres {
   namespace util {
@@ -165,6 +169,9 @@ namespace gsminres {
     }
 
     void spmv(const CSRMat& A, const std::vector<std::complex<double>>& x, std::vector<std::complex<double>>& y) {
+      // Values and column indices once, row pointer, x (assumed cached) and y
+      GSMINRES_PROFILE_KERNEL("spmv", -1, 24.0*A.values.size() + 8.0*(A.matrix_size+1) + 32.0*A.matrix_size,
+                              8.0*A.values.size());
       #pragma omp parallel for
       for (std::size_t i=0; i < A.matrix_size; ++i) {
         y[i] = {0.0, 0.0};
@@ -174,7 +181,73 @@ namespace gsminres {
       }
     }
 
+    void spmm(const CSRMat& A, const std::vector<std::complex<double>>& X, std::vector<std::complex<double>>& Y, const std::size_t num_vectors) {
+      GSMINRES_PROFILE_KERNEL("spmm", -1, 24.0*A.values.size() + 8.0*(A.matrix_size+1) + 32.0*A.matrix_size*num_vectors,
+                              8.0*A.values.size()*num_vectors);
+      const std::size_t N = A.matrix_size;
+      #pragma omp parallel for
+      for (std::size_t i=0; i < N; ++i) {
+        for (std::size_t k=0; k < num_vectors; ++k) {
+          Y[k*N+i] = {0.0, 0.0};
+        }
+        for (std::size_t j=A.row_pointer[i]; j < A.row_pointer[i+1]; ++j) {
+          const std::complex<double> a   = A.values[j];
+          const std::size_t          col = A.col_indices[j];
+          for (std::size_t k=0; k < num_vectors; ++k) {
+            Y[k*N+i] += a * X[k*N+col];
+          }
+        }
+      }
+    }
+
+    void shifted_residuals(const CSRMat& A, const CSRMat& B, const std::vector<std::complex<double>>& X,
+                           const std::vector<std::complex<double>>& b, const std::vector<std::complex<double>>& sigma,
+                           const std::vector<std::size_t>& shifts, std::vector<double>& res) {
+      const std::size_t N = A.matrix_size, K = shifts.size();
+      GSMINRES_PROFILE_KERNEL("shifted_residuals", -1,
+                              24.0*(A.values.size() + B.values.size()) + 16.0*(N+1) + 16.0*N*(K+1),
+                              8.0*(A.values.size() + B.values.size())*K + 14.0*N*K);
+      res.assign(K, 0.0);
+      #pragma omp parallel
+      {
+        std::vector<std::complex<double>> ax(K), bx(K);
+        std::vector<double> sum(K, 0.0);
+        #pragma omp for schedule(static)
+        for (std::size_t i=0; i < N; ++i) {
+          for (std::size_t k=0; k < K; ++k) {
+            ax[k] = {0.0, 0.0};
+            bx[k] = {0.0, 0.0};
+          }
+          for (std::size_t j=A.row_pointer[i]; j < A.row_pointer[i+1]; ++j) {
+            const std::complex<double> a   = A.values[j];
+            const std::size_t          col = A.col_indices[j];
+            for (std::size_t k=0; k < K; ++k) {
+              ax[k] += a * X[shifts[k]*N+col];
+            }
+          }
+          for (std::size_t j=B.row_pointer[i]; j < B.row_pointer[i+1]; ++j) {
+            const std::complex<double> v   = B.values[j];
+            const std::size_t          col = B.col_indices[j];
+            for (std::size_t k=0; k < K; ++k) {
+              bx[k] += v * X[shifts[k]*N+col];
+            }
+          }
+          for (std::size_t k=0; k < K; ++k) {
+            sum[k] += std::norm(b[i] - ax[k] - sigma[shifts[k]]*bx[k]);
+          }
+        }
+        #pragma omp critical
+        for (std::size_t k=0; k < K; ++k) {
+          res[k] += sum[k];
+        }
+      }
+      for (std::size_t k=0; k < K; ++k) {
+        res[k] = std::sqrt(res[k]);
+      }
+    }
+
     bool cg(const CSRMat& A, std::vector<std::complex<double>>& x, const std::vector<std::complex<double>>& b, const double tol=1e-12, const std::size_t max_iter=10000) {
+      GSMINRES_PROFILE_SCOPE("cg", -1);
       bool status = false;
       std::size_t N = A.matrix_size;
       double r0nrm = blas::dznrm2(N, b);
@@ -202,5 +275,205 @@ namespace gsminres {
       return status;
     }
 
+    bool cg(const CSRMat& A, std::vector<std::complex<double>>& x, const std::vector<std::complex<double>>& b, const double tol, const std::size_t max_iter, const Preconditioner& precond) {
+      GSMINRES_PROFILE_SCOPE("cg", -1);
+      bool status = false;
+      std::size_t N = A.matrix_size;
+      double r0nrm = blas::dznrm2(N, b);
+      std::vector<std::complex<double>> r(N), z(N), p(N), Ap(N);
+      std::complex<double> alpha, beta, rz, rz_old;
+      blas::zdscal(N, 0.0, x);
+      if (r0nrm == 0.0) {
+        return true;
+      }
+      blas::zcopy(N, b, 0, r, 0);
+      precond(r, z);
+      blas::zcopy(N, z, 0, p, 0);
+      rz = blas::zdotc(N, r, 0, z, 0);
+      for (std::size_t i=0; i < max_iter; ++i) {
+        spmv(A, p, Ap);
+        alpha = rz / blas::zdotc(N, p, 0, Ap, 0);
+        blas::zaxpy(N, alpha,   p, 0, x, 0);
+        blas::zaxpy(N, -alpha, Ap, 0, r, 0);
+        if (blas::dznrm2(N, r)/r0nrm < tol) {
+          status = true;
+          break;
+        }
+        precond(r, z);
+        rz_old = rz;
+        rz = blas::zdotc(N, r, 0, z, 0);
+        beta = rz / rz_old;
+        blas::zscal(N, beta, p);
+        blas::zaxpy(N, {1.0, 0.0}, z, 0, p, 0);
+      }
+      return status;
+    }
+
+    bool block_cg(const CSRMat& A, std::vector<std::complex<double>>& X, const std::vector<std::complex<double>>& B, const std::size_t num_vectors, const double tol, const std::size_t max_iter) {
+      GSMINRES_PROFILE_SCOPE("block_cg", -1);
+      const std::size_t N = A.matrix_size;
+      const std::size_t K = num_vectors;
+      std::vector<std::complex<double>> R(N*K), P(N*K), AP(N*K);
+      std::vector<std::complex<double>> rr(K);
+      std::vector<double> r0nrm(K);
+      std::vector<bool> active(K, true);
+      std::size_t num_active = K;
+      blas::zdscal(N*K, 0.0, X);
+      blas::zcopy(N*K, B, 0, R, 0);
+      blas::zcopy(N*K, R, 0, P, 0);
+      for (std::size_t k=0; k < K; ++k) {
+        r0nrm[k] = blas::dznrm2(N, B, k*N);
+        rr[k]    = blas::zdotc(N, R, k*N, R, k*N);
+        if (r0nrm[k] == 0.0) {
+          active[k] = false;
+          blas::zdscal(N, 0.0, P, k*N);
+          num_active--;
+        }
+      }
+      for (std::size_t i=0; i < max_iter && num_active > 0; ++i) {
+        spmm(A, P, AP, K);
+        for (std::size_t k=0; k < K; ++k) {
+          if (!active[k]) {
+            continue;
+          }
+          std::size_t offset = k*N;
+          std::complex<double> alpha = rr[k] / blas::zdotc(N, P, offset, AP, offset);
+          blas::zaxpy(N, alpha,   P, offset, X, offset);
+          blas::zaxpy(N, -alpha, AP, offset, R, offset);
+          if (blas::dznrm2(N, R, offset)/r0nrm[k] < tol) {
+            // Zero search direction keeps the column out of the following SpMMs' results
+            active[k] = false;
+            blas::zdscal(N, 0.0, P, offset);
+            num_active--;
+            continue;
+          }
+          std::complex<double> rr_old = rr[k];
+          rr[k] = blas::zdotc(N, R, offset, R, offset);
+          blas::zscal(N, rr[k]/rr_old, P, offset);
+          blas::zaxpy(N, {1.0, 0.0}, R, offset, P, offset);
+        }
+      }
+      return num_active == 0;
+    }
+
+    ChebyshevParam chebyshev_param(const std::vector<double>& alpha, const std::vector<double>& beta, const double tol) {
+      const std::size_t k = alpha.size();
+      if (k == 0) {
+        std::cerr << "chebyshev_param: [ERROR] No Lanczos coefficients" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      std::vector<double> d(alpha), e(beta.begin(), beta.begin()+(k-1));
+      e.push_back(0.0);
+      lapack::dsterf(static_cast<int>(k), d, e);
+      ChebyshevParam param;
+      param.lambda_min = 0.9*d.front();
+      param.lambda_max = 1.1*d.back();
+      if (!(param.lambda_min > 0.0)) {
+        std::cerr << "chebyshev_param: [ERROR] The matrix is not positive definite" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      const double sqrt_kappa = std::sqrt(param.lambda_max/param.lambda_min);
+      const double rho        = (sqrt_kappa-1.0)/(sqrt_kappa+1.0);
+      param.iterations = (tol < 2.0) ? static_cast<std::size_t>(std::ceil(std::log(tol/2.0)/std::log(rho))) : 0;
+      return param;
+    }
+
+    ChebyshevParam chebyshev_setup(const CSRMat& A, const double tol, const std::size_t lanczos_steps) {
+      const std::size_t N = A.matrix_size;
+      const std::size_t K = std::min(lanczos_steps, N);
+      // Deterministic start vector without structure, so that it is not orthogonal to the extreme eigenvectors
+      std::vector<std::complex<double>> v_prev(N, {0.0, 0.0}), v(N), w(N);
+      for (std::size_t i=0; i < N; ++i) {
+        v[i] = std::sin(1.0 + static_cast<double>(i));
+      }
+      blas::zdscal(N, 1.0/blas::dznrm2(N, v), v);
+      std::vector<double> alpha, beta;
+      double beta_prev = 0.0;
+      for (std::size_t j=0; j < K; ++j) {
+        spmv(A, v, w);
+        const double a = blas::zdotc(N, v, 0, w, 0).real();
+        blas::zaxpy(N, -a,         v,      0, w, 0);
+        blas::zaxpy(N, -beta_prev, v_prev, 0, w, 0);
+        alpha.push_back(a);
+        const double b = blas::dznrm2(N, w);
+        if (b <= 1e-14*std::abs(a)) {
+          break; // Invariant subspace: the Ritz values are exact
+        }
+        beta.push_back(b);
+        v_prev.swap(v);
+        blas::zcopy(N, w, 0, v, 0);
+        blas::zdscal(N, 1.0/b, v);
+        beta_prev = b;
+      }
+      return chebyshev_param(alpha, beta, tol);
+    }
+
+    void chebyshev(const CSRMat& A, const ChebyshevParam& param, std::vector<std::complex<double>>& x, const std::vector<std::complex<double>>& b) {
+      block_chebyshev(A, param, x, b, 1);
+    }
+
+    void block_chebyshev(const CSRMat& A, const ChebyshevParam& param, std::vector<std::complex<double>>& X, const std::vector<std::complex<double>>& B, const std::size_t num_vectors) {
+      // Chebyshev iteration (Saad, Iterative Methods for Sparse Linear Systems, Algorithm 12.1)
+      const std::size_t NK    = A.matrix_size*num_vectors;
+      const double      theta = (param.lambda_max+param.lambda_min)/2.0;
+      const double      delta = (param.lambda_max-param.lambda_min)/2.0;
+      const double      sigma = theta/delta;
+      double rho = 1.0/sigma;
+      std::vector<std::complex<double>> R(NK), D(NK), AD(NK);
+      blas::zdscal(NK, 0.0, X);
+      blas::zcopy(NK, B, 0, R, 0);
+      blas::zcopy(NK, B, 0, D, 0);
+      blas::zdscal(NK, 1.0/theta, D);
+      for (std::size_t i=0; i < param.iterations; ++i) {
+        blas::zaxpy(NK, {1.0, 0.0}, D, 0, X, 0);
+        if (i+1 == param.iterations) {
+          break;
+        }
+        spmm(A, D, AD, num_vectors);
+        blas::zaxpy(NK, {-1.0, 0.0}, AD, 0, R, 0);
+        const double rho_next = 1.0/(2.0*sigma-rho);
+        blas::zdscal(NK, rho_next*rho, D);
+        blas::zaxpy(NK, 2.0*rho_next/delta, R, 0, D, 0);
+        rho = rho_next;
+      }
+    }
+
+    std::size_t greedy_coloring(const CSRMat& A, const std::size_t distance, std::vector<std::size_t>& color) {
+      const std::size_t N    = A.matrix_size;
+      const std::size_t none = static_cast<std::size_t>(-1);
+      color.assign(N, none);
+      // visited[j] == i marks the nodes reached from node i; used[c] == i marks the forbidden colours
+      std::vector<std::size_t> visited(N, none), used(N+1, none), frontier, next;
+      std::size_t num_colors = 0;
+      for (std::size_t i=0; i < N; ++i) {
+        frontier.assign(1, i);
+        visited[i] = i;
+        for (std::size_t d=0; d < distance && !frontier.empty(); ++d) {
+          next.clear();
+          for (const std::size_t j : frontier) {
+            for (std::size_t p=A.row_pointer[j]; p < A.row_pointer[j+1]; ++p) {
+              const std::size_t k = A.col_indices[p];
+              if (visited[k] == i) {
+                continue;
+              }
+              visited[k] = i;
+              if (color[k] != none) {
+                used[color[k]] = i;
+              }
+              next.push_back(k);
+            }
+          }
+          frontier.swap(next);
+        }
+        std::size_t c = 0;
+        while (used[c] == i) {
+          c++;
+        }
+        color[i] = c;
+        num_colors = std::max(num_colors, c+1);
+      }
+      return num_colors;
+    }
+
   }  // namespace util
 }  // namespace gsminres